@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "animation.h"
+#include "tile_scheduler.h"
+
+double sequence_stats_t::frames_per_hour() const
+{
+	return seconds > 0 ? frames * 3600.0 / seconds : 0;
+}
+
+SequenceRenderer::SequenceRenderer(world_factory_t build_world, frame_camera_t camera, frame_update_t update, const sequence_options_t& options)
+	: build_world{ std::move(build_world) }, camera{ std::move(camera) }, update{ std::move(update) }, options{ options }
+{
+}
+
+sequence_stats_t SequenceRenderer::render(int first_frame, int frame_count, const frame_sink_t& sink)
+{
+	sequence_stats_t stats{};
+	if (frame_count <= 0)
+	{
+		return stats;
+	}
+	const Camera first_camera{ camera(first_frame) };
+	const unsigned in_flight{ choose_in_flight(first_camera, frame_count) };
+	while (slots.size() < in_flight)
+	{
+		slots.push_back({
+			std::make_unique<World>(build_world()),
+			std::make_unique<RenderManager>(first_camera, options.tile_size, options.max_threads, options.priority)
+		});
+	}
+	const auto start = std::chrono::steady_clock::now();
+
+	std::mutex mut;
+	std::condition_variable changed;
+	std::map<int, canvas_t> finished;   // traced frames waiting for the output thread
+	std::vector<bool> busy(in_flight);  // copies of the world a frame is traced with
+	int next_frame{ first_frame };      // next frame to trace
+	int next_output{ first_frame };     // next frame to hand to the sink
+	const int end_frame{ first_frame + frame_count };
+	const int max_ahead{ static_cast<int>(2 * in_flight) };
+	std::exception_ptr error;
+	const auto fail = [&error](std::exception_ptr failure) {
+		if (!error) error = failure;
+	};
+
+	const auto trace = [&](const std::size_t slot_index, const int frame) {
+		slot_t& slot{ slots[slot_index] };
+		std::exception_ptr failure;
+		try
+		{
+			const Camera frame_camera{ camera(frame) };
+			if (frame_camera.hsize != first_camera.hsize || frame_camera.vsize != first_camera.vsize)
+			{
+				throw std::invalid_argument("Every frame of a sequence needs the same image size");
+			}
+			if (update)
+			{
+				update(*slot.world, frame);
+			}
+			slot.manager->set_camera(frame_camera);
+			canvas_t image{ slot.manager->render(*slot.world) };
+			std::lock_guard<std::mutex> lk{ mut };
+			finished.emplace(frame, std::move(image));
+		}
+		catch (...)
+		{
+			failure = std::current_exception();
+		}
+		{
+			std::lock_guard<std::mutex> lk{ mut };
+			if (failure) fail(failure);
+			busy[slot_index] = false;
+		}
+		changed.notify_all();
+	};
+
+	const auto write = [&]() {
+		std::unique_lock<std::mutex> lk{ mut };
+		while (next_output < end_frame)
+		{
+			changed.wait(lk, [&]() { return error || finished.count(next_output) > 0; });
+			if (error) return;
+			const int frame{ next_output };
+			const canvas_t image{ finished.extract(frame).mapped() };
+			lk.unlock();
+			std::exception_ptr failure;
+			try
+			{
+				sink(frame, image);
+			}
+			catch (...)
+			{
+				failure = std::current_exception();
+			}
+			lk.lock();
+			if (failure) fail(failure);
+			next_output++;
+			changed.notify_all();
+		}
+	};
+
+	// every frame is a task on the shared pool, traced with a free copy of the world;
+	// frames are queued as copies free up, at most `max_ahead` frames ahead of the output
+	ThreadPool& pool{ ThreadPool::shared() };
+	job_options_t frame_job{};
+	frame_job.priority = options.priority;
+	TaskGroup group{ pool, frame_job };
+	std::deque<std::function<void()>> frame_tasks;  // the group references them until it is waited for
+	const auto free_slot = [&busy]() {
+		return static_cast<std::size_t>(std::find(busy.begin(), busy.end(), false) - busy.begin());
+	};
+	const auto can_queue = [&]() {
+		return !error && next_frame < end_frame && next_frame < next_output + max_ahead && free_slot() < busy.size();
+	};
+
+	std::thread output{ write };
+	{
+		std::unique_lock<std::mutex> lk{ mut };
+		while (!error && next_output < end_frame)
+		{
+			while (can_queue())
+			{
+				const std::size_t slot_index{ free_slot() };
+				busy[slot_index] = true;
+				frame_tasks.emplace_back([&trace, slot_index, frame = next_frame++]() { trace(slot_index, frame); });
+				group.run(frame_tasks.back());
+			}
+			// help with the frames (and anything else queued) rather than idle, so a
+			// sequence rendered from inside a pool task cannot starve its own frames
+			lk.unlock();
+			const bool helped{ pool.run_pending_task() };
+			lk.lock();
+			if (!helped)
+			{
+				changed.wait(lk, [&]() { return error || next_output >= end_frame || can_queue(); });
+			}
+		}
+	}
+	group.wait();
+	output.join();
+	finished.clear();
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+
+	stats.frames = frame_count;
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stats.in_flight = in_flight;
+	return stats;
+}
+
+unsigned SequenceRenderer::choose_in_flight(const Camera& first, int frame_count) const
+{
+	unsigned in_flight{ options.frames_in_flight };
+	if (in_flight == 0)
+	{
+		// a frame keeps at most half as many threads busy as it has tiles, or tiles run
+		// out at the end of the frame while other threads idle
+		const unsigned workers{ ThreadPool::shared().thread_count() + 1 };
+		const std::size_t tiles{ TileScheduler::grid_size(first.hsize, first.vsize, options.tile_size) };
+		unsigned per_frame{ options.max_threads > 0 ? std::min(workers, options.max_threads) : workers };
+		per_frame = std::max(1u, std::min(per_frame, static_cast<unsigned>(tiles / 2)));
+		in_flight = (workers + per_frame - 1) / per_frame;
+	}
+	return std::max(1u, std::min(in_flight, static_cast<unsigned>(frame_count)));
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+#include "camera.h"
+#include "canvas.h"
+#include "world.h"
+#include "render_manager.h"
+
+/**
+ * @brief Builds one copy of the scene, called once per frame rendered concurrently.
+ */
+using world_factory_t = std::function<World()>;
+
+/**
+ * @brief Returns the camera of a frame, its size must be the same for every frame.
+ *
+ * Called on pool threads, for several frames at once.
+ */
+using frame_camera_t = std::function<Camera(int frame)>;
+
+/**
+ * @brief Moves the scene to a frame, e.g. by setting object transforms.
+ *
+ * It is called with every copy of the world for the frames rendered with that copy,
+ * not necessarily in frame order, so it must set the state of the frame rather than
+ * step from the previous one. Different copies are updated on pool threads at once.
+ */
+using frame_update_t = std::function<void(World& world, int frame)>;
+
+/**
+ * @brief Receives each finished frame, in frame order, e.g. to encode and write it.
+ *
+ * Called on a separate output thread while later frames are traced.
+ */
+using frame_sink_t = std::function<void(int frame, const canvas_t& image)>;
+
+/**
+ * @struct sequence_options_t
+ * @brief Settings of a `SequenceRenderer`.
+ */
+struct sequence_options_t
+{
+    /** @brief Width and height of the render tiles in pixels. */
+    int tile_size{ 16 };
+
+    /** @brief Frames traced at once, 0 picks from the frame size and the number of pool threads. */
+    unsigned frames_in_flight{ 0 };
+
+    /** @brief Maximum number of tiles of one frame rendered at once, 0 uses the whole pool. */
+    unsigned max_threads{ 0 };
+
+    /** @brief Priority of the frames relative to other jobs on the pool. */
+    Task_Priority priority{ Task_Priority::normal };
+};
+
+/**
+ * @struct sequence_stats_t
+ * @brief Timing of a rendered sequence.
+ */
+struct sequence_stats_t
+{
+    int frames{ 0 };            ///< Number of frames rendered and written.
+    double seconds{ 0 };        ///< Wall-clock time from the first trace to the last write.
+    unsigned in_flight{ 0 };    ///< Frames that were traced at once.
+
+    /**
+     * @brief Returns the throughput of the sequence.
+     */
+    double frames_per_hour() const;
+};
+
+/**
+ * @class SequenceRenderer
+ * @brief Renders the frames of an animation, overlapping frames with each other and with their output.
+ *
+ * Each frame in flight has its own copy of the world and its own `RenderManager`. The
+ * copies are built once, on first use, and kept across frames and calls to `render`,
+ * so BVHs and other acceleration structures are built once per sequence rather than
+ * once per frame; a frame only runs the update callback and sets the camera. The tile
+ * costs of a frame order the tiles of the next frame rendered with the same copy.
+ *
+ * Every frame is a task on the shared pool, so when a frame has too few tiles to keep
+ * every thread busy, several frames are traced at once. Finished frames are handed to the sink on
+ * an output thread in frame order while the following frames are traced; tracing runs
+ * at most two frames per copy of the world ahead of the output.
+ */
+class SequenceRenderer
+{
+public:
+    /**
+     * @brief Constructs the renderer, no world is built yet.
+     *
+     * @param build_world Builds a copy of the scene.
+     * @param camera Returns the camera of a frame.
+     * @param update Moves the scene to a frame (optional, for camera-only animations).
+     * @param options Tile size, frames in flight and job options.
+     */
+    SequenceRenderer(world_factory_t build_world, frame_camera_t camera, frame_update_t update = {}, const sequence_options_t& options = {});
+
+    /**
+     * @brief Renders frames `first_frame` to `first_frame + frame_count - 1`.
+     *
+     * @param first_frame Index of the first frame.
+     * @param frame_count Number of frames.
+     * @param sink Receives each frame in order.
+     * @return sequence_stats_t The timing of the sequence.
+     * @throws std::invalid_argument if a frame's camera has another size than the first frame's.
+     * @throws Rethrows the first exception thrown by a callback.
+     */
+    sequence_stats_t render(int first_frame, int frame_count, const frame_sink_t& sink);
+
+private:
+    /**
+     * @struct slot_t
+     * @brief A copy of the world and the manager that renders frames with it.
+     */
+    struct slot_t
+    {
+        std::unique_ptr<World> world;           ///< Copy of the scene.
+        std::unique_ptr<RenderManager> manager; ///< Renders the frames of this copy.
+    };
+
+    /**
+     * @brief Returns how many frames to trace at once.
+     *
+     * @param first The camera of the first frame.
+     * @param frame_count Number of frames in the sequence.
+     */
+    unsigned choose_in_flight(const Camera& first, int frame_count) const;
+
+    world_factory_t build_world;    ///< Builds a copy of the scene.
+    frame_camera_t camera;          ///< Camera of each frame.
+    frame_update_t update;          ///< Moves the scene to a frame.
+    sequence_options_t options;     ///< Tile size, frames in flight and job options.
+    std::vector<slot_t> slots;      ///< Copies of the world, kept across renders.
+};
@@ -0,0 +1,177 @@
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include "asset_registry.h"
+#include "mesh.h"
+#include "pattern_file.h"
+#include "thread_pool.h"
+
+AssetRegistry::~AssetRegistry()
+{
+	clear();
+}
+
+AssetRegistry& AssetRegistry::global()
+{
+	// the pool is constructed first so that it is destroyed after the registry
+	ThreadPool::shared();
+	static AssetRegistry registry{};
+	return registry;
+}
+
+void AssetRegistry::prefetch_texture(const std::string& path, const Texture_Format format)
+{
+	texture_request(path, format);
+}
+
+void AssetRegistry::prefetch_mesh(const std::string& path, const mesh_load_options_t& options)
+{
+	mesh_request(path, options);
+}
+
+std::shared_ptr<const std::vector<Texture>> AssetRegistry::texture(const std::string& path, const Texture_Format format)
+{
+	return std::static_pointer_cast<const std::vector<Texture>>(wait(texture_request(path, format)));
+}
+
+std::shared_ptr<const mesh_asset_t> AssetRegistry::mesh(const std::string& path, const mesh_load_options_t& options)
+{
+	return std::static_pointer_cast<const mesh_asset_t>(wait(mesh_request(path, options)));
+}
+
+AssetRegistry::asset_future_t AssetRegistry::texture_request(const std::string& path, const Texture_Format format)
+{
+	return request(make_key(path, "texture " + std::to_string(static_cast<int>(format))), [path, format]() {
+		auto levels{ std::make_shared<const std::vector<Texture>>(PatternFile::load_levels(path.c_str(), format)) };
+		std::size_t bytes{ 0 };
+		for (const Texture& level : *levels)
+		{
+			bytes += level.memory_size();
+		}
+		return std::pair<std::shared_ptr<const void>, std::size_t>{ levels, bytes };
+	});
+}
+
+AssetRegistry::asset_future_t AssetRegistry::mesh_request(const std::string& path, const mesh_load_options_t& options)
+{
+	std::ostringstream key{};
+	key.precision(17);
+	key << "mesh " << options.smooth << ' ' << options.weld_epsilon << ' ' << options.compress;
+	return request(make_key(path, key.str()), [path, options]() {
+		auto mesh{ std::make_shared<const mesh_asset_t>(wavefront_t{ path.c_str() }, options.smooth, options.weld_epsilon, options.compress) };
+		return std::pair<std::shared_ptr<const void>, std::size_t>{ mesh, mesh->memory_usage() };
+	});
+}
+
+AssetRegistry::asset_future_t AssetRegistry::request(const std::string& key, std::function<std::pair<std::shared_ptr<const void>, std::size_t>()> load)
+{
+	auto promise{ std::make_shared<std::promise<std::shared_ptr<const void>>>() };
+	asset_future_t asset{};
+	std::uint64_t loading_generation{};
+	{
+		std::lock_guard<std::mutex> lk{ mut };
+		++counters.requests;
+		const auto found{ assets.find(key) };
+		if (found != assets.end())
+		{
+			++counters.hits;
+			return found->second;
+		}
+		++counters.loads;
+		asset = promise->get_future().share();
+		assets.emplace(key, asset);
+		loading_generation = generation;
+	}
+
+	ThreadPool::shared().submit(std::packaged_task<void()>{ [this, key, loading_generation, promise, load = std::move(load)]() {
+		const auto start{ std::chrono::steady_clock::now() };
+		std::size_t bytes{ 0 };
+		bool failed{ false };
+		try
+		{
+			auto [loaded, size] = load();
+			bytes = size;
+			promise->set_value(std::move(loaded));
+		}
+		catch (...)
+		{
+			failed = true;
+			{
+				// forget the failure before anyone sees it, so a request after the throw retries
+				std::lock_guard<std::mutex> lk{ mut };
+				if (generation == loading_generation)
+				{
+					assets.erase(key);
+				}
+			}
+			promise->set_exception(std::current_exception());
+		}
+		const std::chrono::duration<double> duration{ std::chrono::steady_clock::now() - start };
+		std::lock_guard<std::mutex> lk{ mut };
+		counters.bytes += bytes;
+		counters.load_seconds += duration.count();
+		counters.failures += failed ? 1 : 0;
+	} });
+	return asset;
+}
+
+std::shared_ptr<const void> AssetRegistry::wait(const asset_future_t& asset)
+{
+	// help with queued work (possibly the load itself) while the asset is loading
+	while (asset.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready && ThreadPool::shared().run_pending_task())
+	{
+	}
+	return asset.get();
+}
+
+std::string AssetRegistry::make_key(const std::string& path, const std::string& options)
+{
+	// files reached through different relative paths or links are the same asset
+	std::error_code error{};
+	const std::filesystem::path canonical{ std::filesystem::weakly_canonical(path, error) };
+	return (error ? path : canonical.string()) + '|' + options;
+}
+
+void AssetRegistry::clear()
+{
+	std::unordered_map<std::string, asset_future_t> dropped{};
+	{
+		std::lock_guard<std::mutex> lk{ mut };
+		dropped.swap(assets);
+		++generation;
+	}
+	for (const auto& [key, asset] : dropped)
+	{
+		while (asset.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready && ThreadPool::shared().run_pending_task())
+		{
+		}
+		asset.wait();
+	}
+	std::lock_guard<std::mutex> lk{ mut };
+	counters.bytes = 0;
+}
+
+asset_stats_t AssetRegistry::stats() const
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	return counters;
+}
+
+void AssetRegistry::reset_stats()
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	counters.requests = 0;
+	counters.loads = 0;
+	counters.hits = 0;
+	counters.failures = 0;
+	counters.load_seconds = 0;
+}
+
+void AssetRegistry::report(std::ostream& os) const
+{
+	const asset_stats_t s{ stats() };
+	os << "Assets: " << s.requests << " requests, " << s.loads << " loads, " << s.hits << " shared ("
+		<< (s.requests ? 100.0 * s.hits / s.requests : 0.0) << "% deduplicated), "
+		<< s.failures << " failed, " << s.load_seconds << " s loading, "
+		<< s.bytes / (1024 * 1024) << " MB held\n";
+}
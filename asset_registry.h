@@ -0,0 +1,178 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "texture.h"
+
+struct mesh_asset_t;
+
+/**
+ * @struct mesh_load_options_t
+ * @brief The settings a mesh file is loaded with, part of the key of the loaded mesh.
+ */
+struct mesh_load_options_t
+{
+    /** @brief Whether to use smooth shading (per-vertex normals). */
+    bool smooth{ true };
+
+    /** @brief Maximum difference for two vertices to be welded (0 welds exact duplicates only). */
+    double weld_epsilon{ 0 };
+
+    /** @brief Whether to quantise the vertex buffer (see vertex_buffer_t::compress). */
+    bool compress{ false };
+};
+
+/**
+ * @struct asset_stats_t
+ * @brief Counters describing how much loading the asset registry saved.
+ */
+struct asset_stats_t
+{
+    /** @brief Calls of the prefetch and get functions. */
+    std::uint64_t requests{ 0 };
+
+    /** @brief Requests that started loading a file. */
+    std::uint64_t loads{ 0 };
+
+    /** @brief Requests served by an asset already loaded or loading, e.g. the get after a prefetch. */
+    std::uint64_t hits{ 0 };
+
+    /** @brief Loads that threw. */
+    std::uint64_t failures{ 0 };
+
+    /** @brief Time spent loading, summed over the loads (they overlap). */
+    double load_seconds{ 0 };
+
+    /** @brief Bytes held by the loaded assets. */
+    std::size_t bytes{ 0 };
+};
+
+/**
+ * @class AssetRegistry
+ * @brief Loads each texture and mesh file once and shares the loaded data.
+ *
+ * Assets are identified by the canonical path of their file and the options they
+ * are loaded with, so every `PatternFile` and `Mesh` of a file shares one copy of
+ * its texels or vertices. Loaded assets are immutable.
+ *
+ * A request for an asset that is not loaded yet queues its load on the shared pool
+ * and returns at once, so a scene can `prefetch` all of its files and load them
+ * concurrently while it is being assembled; `texture` and `mesh` wait for the load,
+ * helping the pool meanwhile. A load that throws rethrows for every request waiting
+ * on it and is then forgotten, so a later request of its key loads the file again.
+ *
+ * A single process-wide registry (`global()`) is used by `PatternFile` and
+ * `Mesh::create`. It keeps its assets until `clear`.
+ */
+class AssetRegistry
+{
+public:
+    AssetRegistry() = default;
+
+    /**
+     * @brief Waits for running loads before the registry goes away.
+     */
+    ~AssetRegistry();
+
+    /**
+     * @brief Returns the process-wide registry, created on first use after the shared pool, so the pool
+     * outlives it and its loads can still finish while it is destroyed.
+     */
+    static AssetRegistry& global();
+
+    /**
+     * @brief Starts loading the mip levels of a texture file if they are not loaded or loading.
+     * @param path The PPM file.
+     * @param format How the texels are stored.
+     */
+    void prefetch_texture(const std::string& path, const Texture_Format format);
+
+    /**
+     * @brief Starts loading a mesh file if it is not loaded or loading.
+     * @param path The OBJ file.
+     * @param options The settings the mesh is loaded with.
+     */
+    void prefetch_mesh(const std::string& path, const mesh_load_options_t& options = {});
+
+    /**
+     * @brief Returns the mip levels of a texture file, loading them if needed.
+     * @param path The PPM file.
+     * @param format How the texels are stored.
+     * @return The shared mip levels, level 0 is the image.
+     * @throws Rethrows the exception of a failed load.
+     */
+    std::shared_ptr<const std::vector<Texture>> texture(const std::string& path, const Texture_Format format);
+
+    /**
+     * @brief Returns the loaded data of a mesh file, loading it if needed.
+     * @param path The OBJ file.
+     * @param options The settings the mesh is loaded with.
+     * @return The shared mesh data.
+     * @throws Rethrows the exception of a failed load.
+     */
+    std::shared_ptr<const mesh_asset_t> mesh(const std::string& path, const mesh_load_options_t& options = {});
+
+    /**
+     * @brief Drops every asset, users of an asset keep it alive. Waits for running loads.
+     */
+    void clear();
+
+    /**
+     * @brief Returns a snapshot of the statistics.
+     */
+    asset_stats_t stats() const;
+
+    /**
+     * @brief Clears the request counters and load time (loaded assets are kept).
+     */
+    void reset_stats();
+
+    /**
+     * @brief Writes a one line summary of the statistics.
+     * @param os The stream to write to.
+     */
+    void report(std::ostream& os) const;
+
+private:
+    /** @brief A loaded or loading asset, of either kind. */
+    using asset_future_t = std::shared_future<std::shared_ptr<const void>>;
+
+    /**
+     * @brief Returns the asset of a key, queueing `load` on the pool if it is new.
+     * @param key Canonical path and options.
+     * @param load Loads the asset and returns it with its size in bytes.
+     */
+    asset_future_t request(const std::string& key, std::function<std::pair<std::shared_ptr<const void>, std::size_t>()> load);
+
+    /**
+     * @brief Requests the mip levels of a texture file.
+     */
+    asset_future_t texture_request(const std::string& path, const Texture_Format format);
+
+    /**
+     * @brief Requests the data of a mesh file.
+     */
+    asset_future_t mesh_request(const std::string& path, const mesh_load_options_t& options);
+
+    /**
+     * @brief Waits for an asset, running pool tasks meanwhile.
+     */
+    static std::shared_ptr<const void> wait(const asset_future_t& asset);
+
+    /**
+     * @brief Returns the key of a file loaded with the given options.
+     */
+    static std::string make_key(const std::string& path, const std::string& options);
+
+    mutable std::mutex mut;
+    std::unordered_map<std::string, asset_future_t> assets;
+    std::uint64_t generation{ 0 };  ///< Bumped by `clear`, so a failed load only forgets its own entry.
+    asset_stats_t counters{};
+};
@@ -1,22 +1,56 @@
 #include "bvh.h"
 #include "mesh.h"
+#include "thread_pool.h"
 #include <iostream>
 
+/**
+ * @brief Below this many triangles the children of a node are built serially.
+ */
+static constexpr std::size_t PARALLEL_BUILD_TRIANGLES{ 8192 };
+
 void bvh_t::build(int threshold) {
+    split(threshold);
+
+    // Recursively build the child BVHs, large subtrees in parallel since they share no data
+    std::size_t child_triangles{ 0 };
+    for (const auto& child : bvhs)
+    {
+        child_triangles += child->triangles.size();
+    }
+    if (bvhs.size() > 1 && child_triangles >= PARALLEL_BUILD_TRIANGLES)
+    {
+        ThreadPool::shared().parallel_for(0, bvhs.size(), 1, [this, threshold](std::size_t begin, std::size_t end) {
+            for (std::size_t i{ begin }; i < end; i++)
+            {
+                bvhs[i]->build(threshold);
+            }
+        });
+        return;
+    }
+    for (const auto& child : bvhs)
+    {
+        child->build(threshold);
+    }
+}
+
+void bvh_t::build_lazy(int threshold) {
+    lazy_threshold = threshold;
+}
+
+void bvh_t::split(int threshold) {
     // If the number of triangles is less than or equal to the threshold, we stop and don't build further
     if (triangles.size() <= threshold) return;
 
-    // Initialize an empty bounding box to accumulate the bounds of all triangles
-    bbox = {};
-
     // Combine the bounds of all the triangles into a single bounding box
+    // (kept local, a lazily built node may be read by other threads while it splits)
+    bbox_t box{};
     for (const auto& tri : triangles)
     {
-        bbox += tri->bounds();
+        box += tri->bounds();
     }
 
     // Split the bounding box into two parts (left and right)
-    auto [left_box, right_box] = bbox.split();
+    auto [left_box, right_box] = box.split();
 
     // Create two child BVH nodes (left and right)
     auto left_bvh = std::make_shared<bvh_t>();
@@ -41,7 +75,7 @@ void bvh_t::build(int threshold) {
         }
     }
 
-    // If any triangles were moved, proceed with building child BVH nodes
+    // If any triangles were moved, keep the child BVH nodes
     if (moved_any) {
         // Check if all triangles are in one of the child BVHs, which means no meaningful split
         if (left_bvh->triangles.size() == triangles.size() || right_bvh->triangles.size() == triangles.size())
@@ -49,16 +83,18 @@ void bvh_t::build(int threshold) {
             return; 
         }
 
-        // Recursively build the left and right BVHs if they contain any triangles
+        // Children of a lazy node are lazy too and split on their own first hit
+        left_bvh->lazy_threshold = lazy_threshold;
+        right_bvh->lazy_threshold = lazy_threshold;
+
+        // Add the non empty children to the parent BVH's list
         if (!left_bvh->triangles.empty())
         {
-            left_bvh->build(threshold);
-            bvhs.push_back(left_bvh);    // Add the left BVH node to the parent BVH's list
+            bvhs.push_back(left_bvh);
         }
         if (!right_bvh->triangles.empty())
         {
-            right_bvh->build(threshold);
-            bvhs.push_back(right_bvh);    // Add the right BVH node to the parent BVH's list
+            bvhs.push_back(right_bvh);
         }
 
         // Remove the triangles that have been moved to the left or right child BVHs
@@ -71,7 +107,7 @@ void bvh_t::build(int threshold) {
     }
 }
 
-void bvh_t::add(std::shared_ptr<Triangle> t) {
+void bvh_t::add(std::shared_ptr<Geometry> t) {
 	triangles.push_back(t);
 	bbox += t->bounds();
 }
@@ -79,6 +115,13 @@ void bvh_t::add(std::shared_ptr<Triangle> t) {
 void bvh_t::local_intersect(const ray_t& local_ray, intersections_t& intersections) const {
     if (!bbox.intersect(local_ray)) return;
 
+    if (lazy_threshold > 0)
+    {
+        // The first ray to enter the node splits it, concurrent rays wait for the split.
+        // Splitting does not change what the node represents, only how it is organised.
+        std::call_once(lazy_split, [this]() { const_cast<bvh_t*>(this)->split(lazy_threshold); });
+    }
+
     for (const auto& tri : triangles) {
         tri->local_intersect(local_ray, intersections);
     }
@@ -88,3 +131,10 @@ void bvh_t::local_intersect(const ray_t& local_ray, intersections_t& intersectio
     }
 }
 
+std::size_t bvh_t::memory_usage() const {
+    std::size_t bytes{ sizeof(*this) + triangles.capacity() * sizeof(triangles[0]) + bvhs.capacity() * sizeof(bvhs[0]) };
+    for (const auto& child : bvhs) {
+        bytes += child->memory_usage();
+    }
+    return bytes;
+}
@@ -1,9 +1,10 @@
 #pragma once
 #include <memory>
+#include <mutex>
 #include "ray.h"
 #include "intersection.h"
 #include "bounding_box.h"
-#include "triangle.h"
+#include "geometry.h"
 
 /**
  * @brief Bounding Volume Hierarchy (BVH) node for accelerating ray-triangle intersection tests.
@@ -26,9 +27,9 @@ struct bvh_t
      * @brief Triangles stored in this node.
      *
      * If the node is a leaf or splitting was not possible,
-     * triangles remain here.
+     * triangles remain here. Standalone `Triangle`s and `MeshTriangle`s can both be stored.
      */
-    std::vector<std::shared_ptr<Triangle>> triangles;
+    std::vector<std::shared_ptr<Geometry>> triangles;
 
     /**
      * @brief Bounding box enclosing all triangles in this node.
@@ -48,6 +49,18 @@ struct bvh_t
      */
     void build(int threshold);
 
+    /**
+     * @brief Defers building the BVH until rays actually reach it.
+     *
+     * Each node is split (one level, using the same rule as `build`) the first time a
+     * ray enters its bounds, so subtrees no ray ever reaches are never built. Safe to
+     * intersect from several threads: only one thread splits a node while the others
+     * wait for it.
+     *
+     * @param threshold The maximum number of triangles a node may contain before splitting.
+     */
+    void build_lazy(int threshold);
+
     /**
      * @brief Adds a triangle to this BVH node.
      *
@@ -56,7 +69,7 @@ struct bvh_t
      *
      * @param t Shared pointer to the triangle to add.
      */
-    void add(std::shared_ptr<Triangle> t);
+    void add(std::shared_ptr<Geometry> t);
 
     /**
      * @brief Performs intersection tests between a ray and the BVH hierarchy.
@@ -69,4 +82,25 @@ struct bvh_t
      * @param intersections The container to collect any intersection hits.
      */
     void local_intersect(const ray_t& local_ray, intersections_t& intersections) const;
+
+    /**
+     * @brief Returns the bytes held by this node and its children, not counting the triangles themselves.
+     *
+     * A lazily built BVH only counts the nodes split so far.
+     */
+    std::size_t memory_usage() const;
+
+private:
+    /**
+     * @brief Splits this node into two children if it holds more than `threshold` triangles.
+     *
+     * Triangles that fit in neither half stay in this node. Does not recurse.
+     */
+    void split(int threshold);
+
+    /** @brief Split threshold of a lazily built node (0 if the node is built eagerly). */
+    int lazy_threshold{ 0 };
+
+    /** @brief Guards the one time split of a lazily built node. */
+    mutable std::once_flag lazy_split;
 };
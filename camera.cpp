@@ -1,7 +1,7 @@
+#include <algorithm>
 #include <cmath>
-#include <chrono>
-#include <iostream>
 #include "camera.h"
+#include "render_manager.h"
 #include "settings.h"
 
 Camera::Camera(const int hsize, const int vsize, const double fov)
@@ -24,21 +24,103 @@ Camera::Camera(const int hsize, const int vsize, const double fov)
 
 ray_t Camera::ray_for_pixel(const int x, const int y) const
 {
-	// the offset from the edge of the canvas to the pixel's center
-	double x_offset{ (x + 0.5) * pixel_size };
-	double y_offset{ (y + 0.5) * pixel_size };
-	// the untransformed coordinates of the pixel in world space.
-	// (remember that the camera looks toward -z, so +x is to the *left*.)
-	double world_x{ half_width - x_offset };
-	double world_y{ half_height - y_offset };
-	// using the camera matrix, transform the canvas point and the origin,
-	// and then compute the ray's direction vector.
-	// (remember that the canvas is at z=-1)
-	tuple_t pixel{ transform.inverse() * tuple_t::point(world_x, world_y, -1) };
-	tuple_t origin{ transform.inverse() * tuple_t::point(0, 0, 0) };
-	tuple_t direction{ pixel - origin };
+	return ray_for_pixel(x, y, 0.5, 0.5);
+}
+
+ray_t Camera::ray_for_pixel(const int x, const int y, const double px, const double py) const
+{
+	return basis().ray_for_pixel(x, y, px, py);
+}
+
+camera_basis_t Camera::basis() const
+{
+	// using the inverse camera matrix, transform the canvas corner, the per-pixel steps and the origin
+	// (remember that the camera looks toward -z, so +x is to the *left*, and the canvas is at z=-1)
+	const matrix_t inverse{ transform.inverse() };
+	return {
+		inverse * tuple_t::point(0, 0, 0),
+		inverse * tuple_t::point(half_width, half_height, -1),
+		inverse * tuple_t::vector(-pixel_size, 0, 0),
+		inverse * tuple_t::vector(0, -pixel_size, 0),
+		ray_differentials
+	};
+}
+
+ray_t camera_basis_t::ray_for_pixel(const int x, const int y, const double px, const double py) const
+{
+	tuple_t direction{ corner + step_x * (x + px) + step_y * (y + py) - origin };
 	direction.normalize();
-	return { origin, direction };
+	return with_differentials({ origin, direction });
+}
+
+ray_t camera_basis_t::with_differentials(ray_t ray) const
+{
+	if (!differentials)
+	{
+		return ray;
+	}
+	// scale the direction back to the image plane, then step one pixel across and down
+	const tuple_t plane_normal{ tuple_t::cross(step_x, step_y) };
+	const tuple_t to_plane{ ray.direction * (tuple_t::dot(corner - origin, plane_normal) / tuple_t::dot(ray.direction, plane_normal)) };
+	ray.differentials = {
+		true,
+		ray.origin,
+		tuple_t::normalize(to_plane + step_x),
+		ray.origin,
+		tuple_t::normalize(to_plane + step_y)
+	};
+	return ray;
+}
+
+void camera_basis_t::generate(const int x_start, const int x_end, const int y_start, const int y_end, ray_batch_t& rays, const double px, const double py) const
+{
+	const int width{ std::max(x_end - x_start, 0) };
+	const int height{ std::max(y_end - y_start, 0) };
+	rays.resize(static_cast<std::size_t>(width) * height);
+	std::fill(rays.origin_x.begin(), rays.origin_x.end(), origin.x);
+	std::fill(rays.origin_y.begin(), rays.origin_y.end(), origin.y);
+	std::fill(rays.origin_z.begin(), rays.origin_z.end(), origin.z);
+	std::size_t i{ 0 };
+	for (int y{ y_start }; y < y_end; y++)
+	{
+		// the direction to the start of the row, then one step per pixel
+		const double row_x{ corner.x + step_y.x * (y + py) + step_x.x * (x_start + px) - origin.x };
+		const double row_y{ corner.y + step_y.y * (y + py) + step_x.y * (x_start + px) - origin.y };
+		const double row_z{ corner.z + step_y.z * (y + py) + step_x.z * (x_start + px) - origin.z };
+		for (int x{ 0 }; x < width; x++, i++)
+		{
+			const double dx{ row_x + step_x.x * x };
+			const double dy{ row_y + step_x.y * x };
+			const double dz{ row_z + step_x.z * x };
+			const double length{ std::sqrt(dx * dx + dy * dy + dz * dz) };
+			rays.direction_x[i] = dx / length;
+			rays.direction_y[i] = dy / length;
+			rays.direction_z[i] = dz / length;
+		}
+	}
+}
+
+std::size_t ray_batch_t::size() const
+{
+	return direction_x.size();
+}
+
+void ray_batch_t::resize(const std::size_t count)
+{
+	origin_x.resize(count);
+	origin_y.resize(count);
+	origin_z.resize(count);
+	direction_x.resize(count);
+	direction_y.resize(count);
+	direction_z.resize(count);
+}
+
+ray_t ray_batch_t::ray(const std::size_t index) const
+{
+	return {
+		tuple_t::point(origin_x[index], origin_y[index], origin_z[index]),
+		tuple_t::vector(direction_x[index], direction_y[index], direction_z[index])
+	};
 }
 
 
@@ -82,20 +164,6 @@ ray_t Camera::ray_for_pixel(const int x, const int y) const
 
 canvas_t Camera::render(const World& world) const
 {
-	canvas_t image{ hsize, vsize };
-	auto start = std::chrono::high_resolution_clock::now();
-	for (int y{ 0 }; y < vsize - 1; y++)
-	{
-		for (int x{ 0 }; x < hsize - 1; x++)
-		{
-			const ray_t ray{ ray_for_pixel(x, y) };
-			const colour_t colour{ world.colour_at(ray, MAX_REFLECTION_DEPTH) };
-			image.write_pixel(x, y, colour);
-		}
-	}
-	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> duration = end - start;
-
-	std::cout << "Render time: " << duration.count() << " seconds\n";
-	return image;
-}
\ No newline at end of file
+	RenderManager manager{ *this, RENDER_TILE_SIZE };
+	return manager.render(world);
+}
@@ -1,10 +1,90 @@
 #pragma once
+#include <vector>
 #include "scene_object.h"
 #include "matrix.h"
 #include "ray.h"
 #include "canvas.h"
 #include "world.h"
 
+/**
+ * @struct ray_batch_t
+ * @brief Rays stored as a structure of arrays, for tracing a packet or stream of rays together.
+ */
+struct ray_batch_t
+{
+	std::vector<double> origin_x;		///< X components of the origins.
+	std::vector<double> origin_y;		///< Y components of the origins.
+	std::vector<double> origin_z;		///< Z components of the origins.
+	std::vector<double> direction_x;	///< X components of the normalized directions.
+	std::vector<double> direction_y;	///< Y components of the normalized directions.
+	std::vector<double> direction_z;	///< Z components of the normalized directions.
+
+	/**
+	 * @brief Returns the number of rays.
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @brief Resizes every array, keeping their capacity so a batch can be reused.
+	 * @param count The number of rays.
+	 */
+	void resize(const std::size_t count);
+
+	/**
+	 * @brief Returns one ray of the batch.
+	 * @param index Index of the ray.
+	 */
+	ray_t ray(const std::size_t index) const;
+};
+
+/**
+ * @struct camera_basis_t
+ * @brief The world space image plane of a camera, for generating primary rays without matrix products.
+ *
+ * The camera transform is inverted once when the basis is built. Since the transform
+ * is affine, the point a ray passes through is then the corner of the image plane
+ * plus multiples of the per-pixel steps.
+ */
+struct camera_basis_t
+{
+	tuple_t origin;		///< Position of the camera in world space.
+	tuple_t corner;		///< The top left corner of the image plane in world space.
+	tuple_t step_x;		///< World space offset of one pixel to the right.
+	tuple_t step_y;		///< World space offset of one pixel down.
+	bool differentials{ false };	///< Whether primary rays carry ray differentials.
+
+	/**
+	 * @brief Computes the ray that passes through a point inside the given pixel.
+	 * @param x The horizontal pixel coordinate.
+	 * @param y The vertical pixel coordinate.
+	 * @param px Horizontal position within the pixel in [0, 1) (0.5 is the centre).
+	 * @param py Vertical position within the pixel in [0, 1) (0.5 is the centre).
+	 */
+	ray_t ray_for_pixel(const int x, const int y, const double px = 0.5, const double py = 0.5) const;
+
+	/**
+	 * @brief Adds the rays through the neighbouring pixels to a primary ray, if differentials are enabled.
+	 *
+	 * The offset rays pass through the image plane one pixel step to the right and down
+	 * from where the ray does, so this also works for rays taken from a batch.
+	 * @param ray A ray generated from this basis.
+	 * @return The ray, with differentials if `differentials` is set.
+	 */
+	ray_t with_differentials(ray_t ray) const;
+
+	/**
+	 * @brief Generates the rays of a rectangle of pixels, row by row, into a batch.
+	 * @param x_start First column.
+	 * @param x_end One past the last column.
+	 * @param y_start First row.
+	 * @param y_end One past the last row.
+	 * @param rays Receives the rays, resized to the number of pixels.
+	 * @param px Horizontal position within each pixel in [0, 1) (0.5 is the centre).
+	 * @param py Vertical position within each pixel in [0, 1) (0.5 is the centre).
+	 */
+	void generate(const int x_start, const int x_end, const int y_start, const int y_end, ray_batch_t& rays, const double px = 0.5, const double py = 0.5) const;
+};
+
 /**
  * @class Camera
  * @brief Represents a pinhole camera used to render a scene from a specific viewpoint.
@@ -51,6 +131,13 @@ public:
 	 */
 	matrix_t transform{ matrix_t::identity() };
 
+	/**
+	 * @brief Whether primary rays carry ray differentials, for filtering textures over the pixel footprint.
+	 *
+	 * Off by default, since the offset rays cost some time at every hit.
+	 */
+	bool ray_differentials{ false };
+
 	/**
 	 * @brief Constructs a camera with the given image dimensions and field of view.
 	 * @param hsize The horizontal resolution in pixels.
@@ -67,8 +154,29 @@ public:
 	 */
 	ray_t ray_for_pixel(const int x, const int y) const;
 
+	/**
+	 * @brief Computes the ray that passes through a point inside the given pixel.
+	 * @param x The horizontal pixel coordinate.
+	 * @param y The vertical pixel coordinate.
+	 * @param px Horizontal position within the pixel in [0, 1) (0.5 is the centre).
+	 * @param py Vertical position within the pixel in [0, 1) (0.5 is the centre).
+	 * @return A ray representing the line of sight from the camera through that point.
+	 */
+	ray_t ray_for_pixel(const int x, const int y, const double px, const double py) const;
+
+	/**
+	 * @brief Precomputes the world space image plane for the current transform.
+	 *
+	 * `ray_for_pixel` builds a basis per call; renderers build one per frame and
+	 * generate their rays from it.
+	 * @return The basis, it must be rebuilt if the transform or size changes.
+	 */
+	camera_basis_t basis() const;
+
 	/**
 	 * @brief Renders the given world from the perspective of this camera.
+	 *
+	 * Renders in tiles on the shared thread pool through a `RenderManager`.
 	 * @param world The 3D world to render.
 	 * @return A canvas containing the rendered image.
 	 */
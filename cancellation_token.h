@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+
+/**
+ * @class CancellationToken
+ * @brief A flag one thread sets to ask long running work on other threads to stop.
+ *
+ * The work polls `cancelled()` at convenient points (e.g. between tiles) and stops
+ * cleanly, so a token can be cancelled from a UI thread or a signal handler at any time.
+ */
+class CancellationToken
+{
+public:
+    /**
+     * @brief Requests cancellation.
+     */
+    void cancel()
+    {
+        flag.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns whether cancellation has been requested.
+     */
+    bool cancelled() const
+    {
+        return flag.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Clears the request so the token can be reused.
+     */
+    void reset()
+    {
+        flag.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic_bool flag{ false }; ///< Set once cancellation is requested.
+};
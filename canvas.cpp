@@ -1,19 +1,88 @@
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include "canvas.h"
 #include "ppm.h"
+#include "utils.h"
 
-canvas_t::canvas_t(const int w, const int h)
-	: width{ w }, height{ h }
+/**
+ * @brief Alignment of the pixel storage and granularity of padded rows.
+ */
+static constexpr std::size_t CACHE_LINE{ 64 };
+
+static_assert(std::is_trivially_destructible_v<colour_t>, "canvas storage does not run colour_t destructors");
+
+static std::size_t format_pixel_size(const Canvas_Format format)
+{
+	switch (format)
+	{
+	case Canvas_Format::rgb_float: return 3 * sizeof(float);
+	case Canvas_Format::rgba_half: return 4 * sizeof(std::uint16_t);
+	case Canvas_Format::srgb8: return 4;
+	default: return sizeof(colour_t);
+	}
+}
+
+/**
+ * @brief Encodes a linear channel with the sRGB transfer curve into 8 bits.
+ */
+static std::uint8_t to_srgb8(const double linear)
+{
+	const double c{ std::clamp(linear, 0.0, 1.0) };
+	const double encoded{ c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1 / 2.4) - 0.055 };
+	return static_cast<std::uint8_t>(std::lround(encoded * 255));
+}
+
+/**
+ * @brief Decodes an 8-bit sRGB channel to linear, through a table built once.
+ */
+static double from_srgb8(const std::uint8_t encoded)
+{
+	static const auto table{ []() {
+		std::array<double, 256> values{};
+		for (int i{ 0 }; i < 256; i++)
+		{
+			const double c{ i / 255.0 };
+			values[i] = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+		}
+		return values;
+	}() };
+	return table[encoded];
+}
+
+canvas_t::canvas_t(const int w, const int h, const Canvas_Format format)
+	: width{ w }, height{ h }, format{ format }, pixel_size{ format_pixel_size(format) }
 {
-	colour_t black{ 0, 0, 0 };
-	colour_buffer = new colour_t[width * height];
-	std::fill(colour_buffer, colour_buffer + (width * height), black);
+	// colour_buffer rows stay contiguous, the compact formats pad rows to whole cache lines
+	row_stride = static_cast<std::size_t>(std::max(width, 0)) * pixel_size;
+	if (format != Canvas_Format::rgba_double)
+	{
+		row_stride = (row_stride + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+	}
+	const std::size_t size{ std::max<std::size_t>(row_stride * std::max(height, 0), 1) };
+	storage = std::shared_ptr<std::uint8_t[]>{
+		static_cast<std::uint8_t*>(::operator new[](size, std::align_val_t{ CACHE_LINE })),
+		[](std::uint8_t* p) { ::operator delete[](p, std::align_val_t{ CACHE_LINE }); }
+	};
+	if (format == Canvas_Format::rgba_double)
+	{
+		colour_buffer = reinterpret_cast<colour_t*>(storage.get());
+		std::uninitialized_fill_n(colour_buffer, static_cast<std::size_t>(width) * height, colour_t{ 0, 0, 0 });
+	}
+	else
+	{
+		std::memset(storage.get(), 0, size);
+		fill(colour_t{ 0, 0, 0 });
+	}
 }
 
 canvas_t::canvas_t(const ppm_t& ppm)
-	: width{ ppm.width }, height{ ppm.height }
+	: canvas_t{ ppm.width, ppm.height }
 {
-	colour_buffer = new colour_t[width * height];
 	for (int y{ 0 }; y < height; y++)
 	{
 		for (int x{ 0 }; x < width; x++)
@@ -27,22 +96,99 @@ canvas_t::canvas_t(const ppm_t& ppm)
 void canvas_t::write_pixel(const int x, const int y, const colour_t& colour)
 {
 	const int index{ (width * y) + x };
-	if (index >= 0 && index < (width * height))
+	if (index < 0 || index >= (width * height))
+	{
+		return;
+	}
+	std::uint8_t* pixel{ pixel_address(x, y) };
+	switch (format)
 	{
+	case Canvas_Format::rgba_double:
 		colour_buffer[index] = colour;
+		break;
+	case Canvas_Format::rgb_float:
+	{
+		const float rgb[3]{ static_cast<float>(colour.red), static_cast<float>(colour.green), static_cast<float>(colour.blue) };
+		std::memcpy(pixel, rgb, sizeof(rgb));
+		break;
+	}
+	case Canvas_Format::rgba_half:
+	{
+		const std::uint16_t rgba[4]{ to_half(colour.red), to_half(colour.green), to_half(colour.blue), to_half(colour.alpha) };
+		std::memcpy(pixel, rgba, sizeof(rgba));
+		break;
+	}
+	case Canvas_Format::srgb8:
+		pixel[0] = to_srgb8(colour.red);
+		pixel[1] = to_srgb8(colour.green);
+		pixel[2] = to_srgb8(colour.blue);
+		pixel[3] = static_cast<std::uint8_t>(std::lround(std::clamp(colour.alpha, 0.0, 1.0) * 255));
+		break;
 	}
 }
 
 void canvas_t::fill(const colour_t& colour)
 {
-	std::fill(colour_buffer, colour_buffer + (width * height), colour);
+	if (format == Canvas_Format::rgba_double)
+	{
+		std::fill(colour_buffer, colour_buffer + (width * height), colour);
+		return;
+	}
+	// encode once and copy the bytes to every pixel
+	write_pixel(0, 0, colour);
+	if (width * height == 0) return;
+	const std::uint8_t* first{ pixel_address(0, 0) };
+	for (int y{ 0 }; y < height; y++)
+	{
+		for (int x{ 0 }; x < width; x++)
+		{
+			std::memcpy(pixel_address(x, y), first, pixel_size);
+		}
+	}
 }
 
 colour_t canvas_t::pixel_at(const int x, const int y) const
 {
 	const int index{ (width * y) + x };
-	if (index >= 0 && index < (width * height))
+	if (index < 0 || index >= (width * height))
+	{
+		return { 0, 0, 0 };
+	}
+	const std::uint8_t* pixel{ pixel_address(x, y) };
+	switch (format)
+	{
+	case Canvas_Format::rgb_float:
 	{
+		float rgb[3]{};
+		std::memcpy(rgb, pixel, sizeof(rgb));
+		return { rgb[0], rgb[1], rgb[2] };
+	}
+	case Canvas_Format::rgba_half:
+	{
+		std::uint16_t rgba[4]{};
+		std::memcpy(rgba, pixel, sizeof(rgba));
+		return { from_half(rgba[0]), from_half(rgba[1]), from_half(rgba[2]), from_half(rgba[3]) };
+	}
+	case Canvas_Format::srgb8:
+		return { from_srgb8(pixel[0]), from_srgb8(pixel[1]), from_srgb8(pixel[2]), pixel[3] / 255.0 };
+	default:
 		return colour_buffer[index];
 	}
-}
\ No newline at end of file
+}
+
+canvas_t canvas_t::copy() const
+{
+	canvas_t result{ width, height, format };
+	std::memcpy(result.storage.get(), storage.get(), row_stride * std::max(height, 0));
+	return result;
+}
+
+std::size_t canvas_t::memory_size() const
+{
+	return row_stride * std::max(height, 0);
+}
+
+std::uint8_t* canvas_t::pixel_address(const int x, const int y) const
+{
+	return storage.get() + static_cast<std::size_t>(y) * row_stride + static_cast<std::size_t>(x) * pixel_size;
+}
@@ -1,12 +1,39 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include "colour.h"
 
 struct ppm_t;
+
+/**
+ * @brief How a canvas stores its pixels.
+ */
+enum class Canvas_Format
+{
+	rgba_double,	///< `colour_t`, four doubles (32 bytes), addressable through `colour_buffer`.
+	rgb_float,		///< Three 32-bit floats (12 bytes), alpha is dropped.
+	rgba_half,		///< Four 16-bit half floats (8 bytes).
+	srgb8			///< 8-bit sRGB encoded red, green and blue plus 8-bit linear alpha (4 bytes), clamped to [0, 1].
+};
+
 /**
  * @brief Represents a 2D drawing canvas.
  *
  * A canvas is a rectangular grid of pixels, where each pixel holds a colour value.
  * It is typically used for rendering final images in a raytracer.
+ *
+ * Pixels are converted to and from the storage format in `write_pixel` and `pixel_at`.
+ * In the compact formats every row starts on a cache line and is padded to whole
+ * cache lines, so threads rendering tiles whose columns start on multiples of 16
+ * pixels never write to the same cache line. `TileScheduler` only cuts tiles like
+ * that when the tile size is a multiple of 16, as `RENDER_TILE_SIZE` is; smaller
+ * tiles are still correct but neighbouring tiles may share cache lines.
+ * `rgba_double` rows are not padded, `colour_buffer` stays one contiguous
+ * `width * height` array; its rows start on a cache line only when the width is even.
+ *
+ * Copies of a canvas share its pixels, use `copy` for an independent canvas. The
+ * pixels are freed with the last canvas sharing them.
  */
 struct canvas_t
 {
@@ -24,10 +51,15 @@ struct canvas_t
 	 * @brief Pointer to the colour buffer storing pixel data.
 	 *
 	 * This is a flat array of `colour_t` values with size `width * height`,
-	 * typically laid out in row-major order.
+	 * typically laid out in row-major order. Null unless the format is `rgba_double`.
 	 */
 	colour_t* colour_buffer{ nullptr };
 
+	/**
+	 * @brief How the pixels are stored.
+	 */
+	Canvas_Format format{ Canvas_Format::rgba_double };
+
 	/**
 	 * @brief Constructs a canvas of the given width and height, and initializes
 	 *        all pixels to black.
@@ -38,8 +70,9 @@ struct canvas_t
 	 *
 	 * @param w The width of the canvas.
 	 * @param h The height of the canvas.
+	 * @param format How the pixels are stored.
 	 */
-	canvas_t(const int w, const int h);
+	canvas_t(const int w, const int h, const Canvas_Format format = Canvas_Format::rgba_double);
 
 	/**
 	 * @brief Constructs a canvas_t object from a PPM image.
@@ -96,4 +129,24 @@ struct canvas_t
 	 *       may result in undefined behavior.
 	 */
 	colour_t pixel_at(const int x, const int y) const;
+
+	/**
+	 * @brief Returns an independent copy of the canvas in the same format.
+	 */
+	canvas_t copy() const;
+
+	/**
+	 * @brief Returns the number of bytes allocated for the pixels.
+	 */
+	std::size_t memory_size() const;
+
+private:
+	/**
+	 * @brief Returns the address of a pixel in the storage.
+	 */
+	std::uint8_t* pixel_address(const int x, const int y) const;
+
+	std::shared_ptr<std::uint8_t[]> storage;	///< The pixels, shared by copies of the canvas.
+	std::size_t row_stride{ 0 };				///< Bytes from the start of one row to the next.
+	std::size_t pixel_size{ 0 };				///< Bytes per pixel.
 };
@@ -1,4 +1,5 @@
 ﻿#include <cmath>
+#include <initializer_list>
 #include "checker.h"
 #include "settings.h"
 
@@ -21,6 +22,31 @@ colour_t Checker::at(const tuple_t& point) const
 	return ((int)floor(point.x + EPSILON) + (int)floor(point.y + EPSILON) + (int)floor(point.z + EPSILON)) % 2 ? b : a;
 }
 
+/**
+ * @brief Returns the fraction of `b` in a box, from the fractions of its extents in odd cells.
+ *
+ * The parity of the cell is the product of the per-axis parities (as +1/-1), and the
+ * box filter of a product of separable terms is the product of their box filters.
+ */
+static double b_fraction(std::initializer_list<double> odd_fractions)
+{
+	double parity{ 1 };
+	for (const double fraction : odd_fractions)
+	{
+		parity *= 1 - 2 * fraction;
+	}
+	return (1 - parity) / 2;
+}
+
+colour_t Checker::at(const tuple_t& point, const double width) const
+{
+	const double fraction{ b_fraction({
+		odd_fraction(point.x + EPSILON, width),
+		odd_fraction(point.y + EPSILON, width),
+		odd_fraction(point.z + EPSILON, width) }) };
+	return a * (1 - fraction) + b * fraction;
+}
+
 colour_t Checker::at(const double u, const double v) const
 {
 	int u2{ (int)floor(u * width) };
@@ -34,4 +60,12 @@ colour_t Checker::at(const double u, const double v) const
 	{
 		return a;
 	}
+}
+
+colour_t Checker::at(const double u, const double v, const double footprint) const
+{
+	const double fraction{ b_fraction({
+		odd_fraction(u * width, footprint * width),
+		odd_fraction(v * height, footprint * height) }) };
+	return a * (1 - fraction) + b * fraction;
 }
\ No newline at end of file
@@ -55,6 +55,18 @@ public:
      */
     colour_t at(const tuple_t& point) const override;
 
+    /**
+     * @brief Computes the checker color averaged over a cube around a point.
+     *
+     * The box filter of the checker is separable, so the fraction of the cube in `b`
+     * cells follows from the fractions of its extent in odd cells along each axis.
+     *
+     * @param point A point in pattern (3D object) space.
+     * @param width Edge length of the cube in pattern units.
+     * @return The averaged color.
+     */
+    colour_t at(const tuple_t& point, const double width) const override;
+
     /**
      * @brief Computes the color at a 2D UV coordinate using checker logic.
      *
@@ -66,4 +78,14 @@ public:
      * @return The resulting color at the specified UV coordinate.
      */
     colour_t at(const double u, const double v) const override;
+
+    /**
+     * @brief Computes the checker color averaged over a square footprint in UV space.
+     *
+     * @param u The horizontal texture coordinate.
+     * @param v The vertical texture coordinate.
+     * @param footprint Edge length of the footprint in UV units.
+     * @return The averaged color.
+     */
+    colour_t at(const double u, const double v, const double footprint) const override;
 };
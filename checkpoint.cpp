@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "checkpoint.h"
+
+// On-disk layout of a checkpoint: a header, one byte per grid tile (1 if finished)
+// and then the pixels of every finished tile in tile order, row by row within the
+// tile, as float RGB. Values are stored in native byte order since a checkpoint is
+// resumed by the same build of the renderer.
+static constexpr char CHECKPOINT_MAGIC[4]{ 'R', 'T', 'C', 'K' };
+static constexpr std::uint32_t CHECKPOINT_VERSION{ 1 };
+
+struct checkpoint_header_t
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t scene_hash;
+	std::int32_t width;
+	std::int32_t height;
+	std::int32_t tile_size;
+	std::uint32_t tile_count;
+};
+
+checkpoint_t checkpoint_t::load(const std::string& path)
+{
+	std::ifstream in{ path, std::ios::binary };
+	if (!in)
+	{
+		throw std::runtime_error("Could not open checkpoint " + path);
+	}
+	checkpoint_header_t header{};
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!in || std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || header.version != CHECKPOINT_VERSION)
+	{
+		throw std::runtime_error(path + " is not a render checkpoint");
+	}
+	if (header.tile_count != TileScheduler::grid_size(header.width, header.height, header.tile_size))
+	{
+		throw std::runtime_error("Checkpoint " + path + " is corrupt");
+	}
+
+	checkpoint_t checkpoint{};
+	checkpoint.scene_hash = header.scene_hash;
+	checkpoint.width = header.width;
+	checkpoint.height = header.height;
+	checkpoint.tile_size = header.tile_size;
+	std::vector<std::uint8_t> mask(header.tile_count);
+	in.read(reinterpret_cast<char*>(mask.data()), mask.size());
+	checkpoint.done.assign(mask.begin(), mask.end());
+	checkpoint.pixels.assign(static_cast<std::size_t>(header.width) * header.height, colour_t{ 0, 0, 0 });
+
+	std::vector<float> rgb;
+	for (std::size_t i{ 0 }; i < checkpoint.done.size() && in; i++)
+	{
+		if (!checkpoint.done[i]) continue;
+		const render_tile_t tile{ TileScheduler::grid_tile(header.width, header.height, header.tile_size, i) };
+		rgb.resize(static_cast<std::size_t>(tile.area()) * 3);
+		in.read(reinterpret_cast<char*>(rgb.data()), rgb.size() * sizeof(float));
+		std::size_t offset{ 0 };
+		for (int y{ tile.y_start }; y < tile.y_end; y++)
+		{
+			for (int x{ tile.x_start }; x < tile.x_end; x++, offset += 3)
+			{
+				checkpoint.pixels[static_cast<std::size_t>(y) * header.width + x] = { rgb[offset], rgb[offset + 1], rgb[offset + 2] };
+			}
+		}
+	}
+	if (!in)
+	{
+		throw std::runtime_error("Checkpoint " + path + " is truncated");
+	}
+	return checkpoint;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path, double interval, std::uint64_t scene_hash, const canvas_t& image, int tile_size, const std::vector<bool>& done)
+	: path{ path }, interval{ interval }, scene_hash{ scene_hash }, image{ image }, tile_size{ tile_size }
+{
+	const std::size_t count{ TileScheduler::grid_size(image.width, image.height, tile_size) };
+	this->done = done.size() == count ? done : std::vector<bool>(count, false);
+	pixels_left = std::make_unique<std::atomic<int>[]>(count);
+	for (std::size_t i{ 0 }; i < count; i++)
+	{
+		pixels_left[i] = this->done[i] ? 0 : TileScheduler::grid_tile(image.width, image.height, tile_size, i).area();
+	}
+	writer = std::thread{ &CheckpointWriter::run, this };
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	stop();
+	if (!finished)
+	{
+		write();
+	}
+}
+
+void CheckpointWriter::tile_finished(const render_tile_t& tile)
+{
+	// the last part of a split grid tile to finish marks it done
+	if (pixels_left[tile.source].fetch_sub(tile.area()) == tile.area())
+	{
+		std::lock_guard<std::mutex> lk{ mut };
+		done[tile.source] = true;
+	}
+}
+
+void CheckpointWriter::finish()
+{
+	stop();
+	finished = true;
+	std::error_code ignored;
+	std::filesystem::remove(path, ignored);
+}
+
+std::size_t CheckpointWriter::checkpoints_written() const
+{
+	return written;
+}
+
+void CheckpointWriter::run()
+{
+	std::unique_lock<std::mutex> lk{ mut };
+	while (!stopping)
+	{
+		if (wake.wait_for(lk, std::chrono::duration<double>(interval), [this]() { return stopping; }))
+		{
+			return;
+		}
+		lk.unlock();
+		write();
+		lk.lock();
+	}
+}
+
+void CheckpointWriter::write()
+{
+	std::vector<bool> finished_tiles;
+	{
+		std::lock_guard<std::mutex> lk{ mut };
+		finished_tiles = done;
+	}
+
+	checkpoint_header_t header{};
+	std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	header.version = CHECKPOINT_VERSION;
+	header.scene_hash = scene_hash;
+	header.width = image.width;
+	header.height = image.height;
+	header.tile_size = tile_size;
+	header.tile_count = static_cast<std::uint32_t>(finished_tiles.size());
+
+	// write next to the checkpoint and swap it in, a crash mid-write keeps the old one
+	const std::string temporary{ path + ".tmp" };
+	{
+		std::ofstream out{ temporary, std::ios::binary | std::ios::trunc };
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		const std::vector<std::uint8_t> mask(finished_tiles.begin(), finished_tiles.end());
+		out.write(reinterpret_cast<const char*>(mask.data()), mask.size());
+		std::vector<float> rgb;
+		for (std::size_t i{ 0 }; i < finished_tiles.size(); i++)
+		{
+			if (!finished_tiles[i]) continue;
+			const render_tile_t tile{ TileScheduler::grid_tile(image.width, image.height, tile_size, i) };
+			rgb.clear();
+			for (int y{ tile.y_start }; y < tile.y_end; y++)
+			{
+				for (int x{ tile.x_start }; x < tile.x_end; x++)
+				{
+					const colour_t colour{ image.pixel_at(x, y) };
+					rgb.push_back(static_cast<float>(colour.red));
+					rgb.push_back(static_cast<float>(colour.green));
+					rgb.push_back(static_cast<float>(colour.blue));
+				}
+			}
+			out.write(reinterpret_cast<const char*>(rgb.data()), rgb.size() * sizeof(float));
+		}
+		if (!out)
+		{
+			std::cerr << "Could not write checkpoint " << temporary << "\n";
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::cerr << "Could not replace checkpoint " << path << ": " << error.message() << "\n";
+		return;
+	}
+	written++;
+}
+
+void CheckpointWriter::stop()
+{
+	{
+		std::lock_guard<std::mutex> lk{ mut };
+		stopping = true;
+	}
+	wake.notify_all();
+	if (writer.joinable())
+	{
+		writer.join();
+	}
+}
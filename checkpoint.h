@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "canvas.h"
+#include "tile_scheduler.h"
+
+/**
+ * @struct checkpoint_t
+ * @brief The state of an unfinished render, as saved to a checkpoint file.
+ */
+struct checkpoint_t
+{
+    std::uint64_t scene_hash{ 0 };  ///< Hash of the scene and render settings the tiles were rendered with.
+    int width{ 0 };                 ///< Image width in pixels.
+    int height{ 0 };                ///< Image height in pixels.
+    int tile_size{ 0 };             ///< Width and height of the grid tiles.
+    std::vector<bool> done;         ///< Which grid tiles are finished.
+    std::vector<colour_t> pixels;   ///< The image, pixels of unfinished tiles are black.
+
+    /**
+     * @brief Reads a checkpoint file.
+     *
+     * @param path The checkpoint file.
+     * @throws std::runtime_error if the file cannot be read or is not a checkpoint.
+     */
+    static checkpoint_t load(const std::string& path);
+};
+
+/**
+ * @class CheckpointWriter
+ * @brief Periodically saves the finished tiles of a running render to a checkpoint file.
+ *
+ * Render threads only report finished tiles, which counts their pixels with an atomic
+ * per grid tile. A background thread wakes up every `interval` seconds and copies
+ * the finished tiles out of the canvas (finished tiles are never written again, so
+ * this does not race with the render) and writes them to a temporary file that then
+ * replaces the checkpoint, so a checkpoint is never left half written.
+ *
+ * Pixels are stored as 32-bit floats.
+ */
+class CheckpointWriter
+{
+public:
+    /**
+     * @brief Starts the writer thread.
+     *
+     * @param path The checkpoint file.
+     * @param interval Seconds between checkpoints.
+     * @param scene_hash Hash of the scene and render settings.
+     * @param image The canvas being rendered, it must outlive the writer.
+     * @param tile_size Width and height of the grid tiles.
+     * @param done Grid tiles that are already finished, e.g. restored from a checkpoint (none if empty).
+     */
+    CheckpointWriter(const std::string& path, double interval, std::uint64_t scene_hash, const canvas_t& image, int tile_size, const std::vector<bool>& done = {});
+
+    /**
+     * @brief Stops the writer thread, saving a last checkpoint unless `finish` was called.
+     */
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Reports that the final pixels of a tile (or part of a grid tile) were written.
+     *
+     * @param tile The tile.
+     */
+    void tile_finished(const render_tile_t& tile);
+
+    /**
+     * @brief Stops the writer thread and removes the checkpoint, the render is complete.
+     */
+    void finish();
+
+    /**
+     * @brief Returns the number of checkpoints written so far.
+     */
+    std::size_t checkpoints_written() const;
+
+private:
+    /**
+     * @brief Body of the writer thread.
+     */
+    void run();
+
+    /**
+     * @brief Writes the finished tiles to the checkpoint file.
+     */
+    void write();
+
+    /**
+     * @brief Stops and joins the writer thread.
+     */
+    void stop();
+
+    std::string path;                           ///< The checkpoint file.
+    double interval;                            ///< Seconds between checkpoints.
+    std::uint64_t scene_hash;                   ///< Hash written to the checkpoint.
+    const canvas_t& image;                      ///< The canvas being rendered.
+    int tile_size;                              ///< Width and height of the grid tiles.
+    std::unique_ptr<std::atomic<int>[]> pixels_left; ///< Pixels of each grid tile not finished yet.
+    std::mutex mut;                             ///< Guards `done` and `stopping`.
+    std::condition_variable wake;               ///< Wakes the writer thread early to stop.
+    std::vector<bool> done;                     ///< Finished grid tiles.
+    bool stopping{ false };                     ///< Set to end the writer thread.
+    bool finished{ false };                     ///< Whether the render completed.
+    std::atomic<std::size_t> written{ 0 };      ///< Checkpoints written.
+    std::thread writer;                         ///< The writer thread.
+};
@@ -0,0 +1,171 @@
+#include "cluster_cache.h"
+#include "clustered_mesh.h"
+
+ClusterCache::ClusterCache(std::size_t budget_bytes)
+	: budget{ budget_bytes }, hand{ clock.end() }
+{
+}
+
+ClusterCache& ClusterCache::global()
+{
+	static ClusterCache cache{ std::size_t{ 1 } << 30 };
+	return cache;
+}
+
+ClusterCache::shard_t& ClusterCache::shard_of(const cluster_key_t& key)
+{
+	// the upper bits of the mixed hash, the low bits of a pointer hash are mostly alignment
+	const std::uint64_t mixed{ cluster_key_hash_t{}(key) * 0x9e3779b97f4a7c15ull };
+	return shards[(mixed >> 32) % SHARDS];
+}
+
+std::shared_ptr<const mesh_cluster_t> ClusterCache::acquire(const void* owner, std::uint32_t cluster,
+	const std::function<std::shared_ptr<const mesh_cluster_t>()>& load)
+{
+	const cluster_key_t key{ owner, cluster };
+	shard_t& shard{ shard_of(key) };
+	{
+		std::lock_guard<std::mutex> lk{ shard.mut };
+		const auto found{ shard.resident.find(key) };
+		if (found != shard.resident.end())
+		{
+			++shard.hits;
+			entry_t& entry{ *found->second };
+			// only write when the flag changes so hot clusters are not written on every hit
+			if (!entry.referenced.load(std::memory_order_relaxed))
+			{
+				entry.referenced.store(true, std::memory_order_relaxed);
+			}
+			return entry.cluster;
+		}
+		++shard.misses;
+	}
+
+	std::shared_ptr<const mesh_cluster_t> loaded{ load() };
+	const std::size_t bytes{ loaded->memory_usage() };
+
+	std::lock_guard<std::mutex> lk{ mut };
+	auto entry{ std::make_shared<entry_t>() };
+	{
+		std::lock_guard<std::mutex> shard_lk{ shard.mut };
+		const auto found{ shard.resident.find(key) };
+		if (found != shard.resident.end())
+		{
+			// another thread paged the same cluster in first
+			++counters.wasted_loads;
+			found->second->referenced.store(true, std::memory_order_relaxed);
+			return found->second->cluster;
+		}
+		entry->key = key;
+		entry->cluster = loaded;
+		entry->bytes = bytes;
+		shard.resident.emplace(key, entry);
+	}
+	// new clusters go just behind the hand, the last place it reaches
+	clock.insert(hand, entry);
+	counters.bytes_paged_in += bytes;
+	counters.resident_bytes += bytes;
+	if (counters.resident_bytes > counters.peak_resident_bytes)
+	{
+		counters.peak_resident_bytes = counters.resident_bytes;
+	}
+	evict(entry);
+	return loaded;
+}
+
+void ClusterCache::release(const void* owner)
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	for (auto it{ clock.begin() }; it != clock.end();)
+	{
+		if ((*it)->key.owner == owner)
+		{
+			it = erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ClusterCache::set_budget(std::size_t budget_bytes)
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	budget = budget_bytes;
+	evict(nullptr);
+}
+
+cluster_cache_stats_t ClusterCache::stats() const
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	cluster_cache_stats_t s{ counters };
+	for (shard_t& shard : shards)
+	{
+		std::lock_guard<std::mutex> shard_lk{ shard.mut };
+		s.hits += shard.hits;
+		s.misses += shard.misses;
+	}
+	return s;
+}
+
+void ClusterCache::reset_stats()
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	for (shard_t& shard : shards)
+	{
+		std::lock_guard<std::mutex> shard_lk{ shard.mut };
+		shard.hits = 0;
+		shard.misses = 0;
+	}
+	counters.evictions = 0;
+	counters.bytes_paged_in = 0;
+	counters.wasted_loads = 0;
+	counters.peak_resident_bytes = counters.resident_bytes;
+}
+
+void ClusterCache::report(std::ostream& os) const
+{
+	const cluster_cache_stats_t s{ stats() };
+	const std::uint64_t lookups{ s.hits + s.misses };
+	os << "Cluster cache: " << s.hits << " hits, " << s.misses << " misses ("
+		<< (lookups ? 100.0 * s.hits / lookups : 0.0) << "% hit rate), "
+		<< s.evictions << " evictions, " << s.bytes_paged_in / (1024 * 1024) << " MB paged in, "
+		<< s.wasted_loads << " wasted loads, "
+		<< s.peak_resident_bytes / (1024 * 1024) << " MB peak resident\n";
+}
+
+void ClusterCache::evict(const std::shared_ptr<entry_t>& newest)
+{
+	// hits keep setting the flags while the hand sweeps, after two full turns the hand
+	// evicts whatever it finds so a scene whose clusters are all hot still shrinks
+	std::size_t passed{ 0 };
+	while (counters.resident_bytes > budget && clock.size() > 1)
+	{
+		if (hand == clock.end()) hand = clock.begin();
+		const bool referenced{ (*hand)->referenced.exchange(false, std::memory_order_relaxed) };
+		if (*hand == newest || (referenced && passed < 2 * clock.size()))
+		{
+			++hand;
+			++passed;
+			continue;
+		}
+		++counters.evictions;
+		hand = erase(hand);
+	}
+}
+
+std::list<std::shared_ptr<ClusterCache::entry_t>>::iterator ClusterCache::erase(std::list<std::shared_ptr<entry_t>>::iterator it)
+{
+	const std::shared_ptr<entry_t>& entry{ *it };
+	{
+		shard_t& shard{ shard_of(entry->key) };
+		std::lock_guard<std::mutex> lk{ shard.mut };
+		shard.resident.erase(entry->key);
+	}
+	counters.resident_bytes -= entry->bytes;
+	const bool at_hand{ it == hand };
+	it = clock.erase(it);
+	if (at_hand) hand = it;
+	return it;
+}
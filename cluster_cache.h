@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+struct mesh_cluster_t;
+
+/**
+ * @struct cluster_cache_stats_t
+ * @brief Counters describing how well the resident set of mesh clusters is working.
+ */
+struct cluster_cache_stats_t
+{
+    /** @brief Lookups that found the cluster already resident. */
+    std::uint64_t hits{ 0 };
+
+    /** @brief Lookups that had to page the cluster in. */
+    std::uint64_t misses{ 0 };
+
+    /** @brief Clusters dropped to stay within the memory budget. */
+    std::uint64_t evictions{ 0 };
+
+    /** @brief Total bytes of the clusters paged in and kept resident. */
+    std::uint64_t bytes_paged_in{ 0 };
+
+    /** @brief Clusters paged in by a thread that lost the race to another thread loading the same cluster, and discarded. */
+    std::uint64_t wasted_loads{ 0 };
+
+    /** @brief Bytes currently held by resident clusters. */
+    std::size_t resident_bytes{ 0 };
+
+    /** @brief Largest value `resident_bytes` has reached. */
+    std::size_t peak_resident_bytes{ 0 };
+};
+
+/**
+ * @class ClusterCache
+ * @brief Keeps the most recently used mesh clusters resident within a memory budget.
+ *
+ * Clusters are identified by their owning mesh and their index within it. When a
+ * cluster is requested that is not resident it is loaded by the supplied callback,
+ * and clusters that have not been used recently are evicted until the budget is met
+ * again. Evicted clusters are only freed once the last ray still using them lets go,
+ * the budget therefore bounds the cache rather than being a hard limit.
+ *
+ * Lookups are spread over shards by key, each with its own lock, and a hit only
+ * marks its cluster as referenced. Recency is approximated with the CLOCK algorithm
+ * rather than an exact LRU list, so a hit never has to reorder shared state; only
+ * misses take the cache-wide lock to insert and evict.
+ *
+ * A single process-wide cache (`global()`) is shared by all clustered meshes so the
+ * budget applies across the whole scene.
+ */
+class ClusterCache
+{
+public:
+    /**
+     * @brief Constructs a cache.
+     * @param budget_bytes Maximum number of bytes of resident cluster data.
+     */
+    explicit ClusterCache(std::size_t budget_bytes);
+
+    /**
+     * @brief Returns the process-wide cache (1 GB budget unless changed).
+     */
+    static ClusterCache& global();
+
+    /**
+     * @brief Returns a resident cluster, paging it in with `load` on a miss.
+     *
+     * The cluster is loaded without holding a lock, so several threads may page in
+     * different clusters at the same time. If two threads race to load the same
+     * cluster the first one to finish wins and the other copy is discarded (counted
+     * in `wasted_loads`).
+     *
+     * @param owner The mesh the cluster belongs to.
+     * @param cluster Index of the cluster within its mesh.
+     * @param load Builds the cluster from its backing storage.
+     * @return The resident cluster.
+     */
+    std::shared_ptr<const mesh_cluster_t> acquire(const void* owner, std::uint32_t cluster,
+        const std::function<std::shared_ptr<const mesh_cluster_t>()>& load);
+
+    /**
+     * @brief Drops every resident cluster of a mesh, e.g. when the mesh is destroyed.
+     * @param owner The mesh whose clusters are released.
+     */
+    void release(const void* owner);
+
+    /**
+     * @brief Changes the memory budget, evicting clusters if it shrinks.
+     * @param budget_bytes Maximum number of bytes of resident cluster data.
+     */
+    void set_budget(std::size_t budget_bytes);
+
+    /**
+     * @brief Returns a snapshot of the statistics.
+     */
+    cluster_cache_stats_t stats() const;
+
+    /**
+     * @brief Clears the hit, miss, eviction, page-in and wasted load counters (resident data is kept).
+     */
+    void reset_stats();
+
+    /**
+     * @brief Writes a one line summary of the statistics.
+     * @param os The stream to write to.
+     */
+    void report(std::ostream& os) const;
+
+private:
+    /** @brief Identifies one cluster of one mesh. */
+    struct cluster_key_t
+    {
+        const void* owner;
+        std::uint32_t cluster;
+
+        bool operator==(const cluster_key_t& k) const
+        {
+            return owner == k.owner && cluster == k.cluster;
+        }
+    };
+
+    struct cluster_key_hash_t
+    {
+        std::size_t operator()(const cluster_key_t& k) const
+        {
+            return std::hash<const void*>{}(k.owner) ^ (std::hash<std::uint32_t>{}(k.cluster) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    /** @brief A resident cluster. */
+    struct entry_t
+    {
+        cluster_key_t key;
+        std::shared_ptr<const mesh_cluster_t> cluster;
+        std::size_t bytes;
+
+        /** @brief Set by every hit, cleared as the clock hand passes; unset entries are evicted. */
+        std::atomic<bool> referenced{ true };
+    };
+
+    /** @brief The resident clusters of a subset of the keys, with the lookup counters of those keys. */
+    struct shard_t
+    {
+        std::mutex mut;
+        std::unordered_map<cluster_key_t, std::shared_ptr<entry_t>, cluster_key_hash_t> resident;
+        std::uint64_t hits{ 0 };
+        std::uint64_t misses{ 0 };
+    };
+
+    /** @brief Number of shards, a power of two. */
+    static constexpr std::size_t SHARDS{ 16 };
+
+    /**
+     * @brief Returns the shard of a key.
+     */
+    shard_t& shard_of(const cluster_key_t& key);
+
+    /**
+     * @brief Evicts clusters the clock hand finds unreferenced until the budget is met (`mut` must be held).
+     *
+     * The cluster inserted last is never evicted so a single oversized cluster can
+     * still be rendered.
+     *
+     * @param newest The cluster inserted last.
+     */
+    void evict(const std::shared_ptr<entry_t>& newest);
+
+    /**
+     * @brief Removes a resident cluster, moving the clock hand on if it points at it (`mut` must be held).
+     * @param it The cluster's place on the clock.
+     * @return The next place on the clock.
+     */
+    std::list<std::shared_ptr<entry_t>>::iterator erase(std::list<std::shared_ptr<entry_t>>::iterator it);
+
+    mutable std::mutex mut;                             ///< Guards the clock, the budget and `counters`; taken before a shard lock.
+    std::size_t budget;
+    std::list<std::shared_ptr<entry_t>> clock;          ///< Every resident cluster, in insertion order around the clock.
+    std::list<std::shared_ptr<entry_t>>::iterator hand; ///< Next entry the clock looks at.
+    mutable std::array<shard_t, SHARDS> shards;
+    cluster_cache_stats_t counters{};                   ///< Every counter except the per-shard hits and misses.
+};
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "clustered_mesh.h"
+#include "intersection.h"
+
+// On-disk layout of a mesh cache: a header, the cluster table and then, per
+// cluster, its vertices followed by its triangles. Values are stored in native
+// byte order since the cache is meant to be built on the machine that renders.
+static constexpr char CACHE_MAGIC[4]{ 'R', 'T', 'M', 'C' };
+static constexpr std::uint32_t CACHE_VERSION{ 1 };
+
+/**
+ * @brief Maximum number of clusters in a leaf of the BVH over the cluster bounds.
+ */
+static constexpr std::uint32_t CLUSTER_BVH_LEAF{ 2 };
+
+static constexpr std::uint32_t TRIANGLE_HAS_UVS{ 1 };
+static constexpr std::uint32_t TRIANGLE_HAS_NORMALS{ 2 };
+
+struct cache_header_t
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t cluster_count;
+	std::uint32_t reserved;
+};
+
+struct cache_cluster_t
+{
+	double min[3];
+	double max[3];
+	std::uint64_t offset;
+	std::uint32_t vertex_count;
+	std::uint32_t triangle_count;
+};
+
+struct cache_vertex_t
+{
+	double position[3];
+	double normal[3];
+	double uv[2];
+};
+
+struct cache_triangle_t
+{
+	std::uint32_t indices[3];
+	std::uint32_t flags;
+};
+
+std::size_t mesh_cluster_t::memory_usage() const
+{
+	// triangles are allocated together with their control block by make_shared, the
+	// BVH counts its own references to them
+	const std::size_t per_triangle{ sizeof(MeshTriangle) + sizeof(std::shared_ptr<MeshTriangle>) + 16 };
+	return sizeof(*this) + vertex_buffer->memory_usage() + triangles.size() * per_triangle + (bvh ? bvh->memory_usage() : 0);
+}
+
+void mesh_cluster_t::local_intersect(const ray_t& local_ray, intersections_t& intersections) const
+{
+	if (bvh)
+	{
+		bvh->local_intersect(local_ray, intersections);
+		return;
+	}
+	for (const auto& triangle : triangles)
+	{
+		triangle->local_intersect(local_ray, intersections);
+	}
+}
+
+ClusteredMesh::ClusteredMesh(const char* cache_filename, int bvh_threshold, ClusterCache& cache)
+	: file{ cache_filename }, bvh_threshold{ bvh_threshold }, cache{ cache }
+{
+	const auto invalid = [cache_filename]() {
+		return std::runtime_error(std::string{ cache_filename } + " is not a valid mesh cache");
+	};
+
+	cache_header_t header{};
+	if (file.size() < sizeof(header)) throw invalid();
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION)
+	{
+		throw invalid();
+	}
+	if ((file.size() - sizeof(header)) / sizeof(cache_cluster_t) < header.cluster_count) throw invalid();
+
+	clusters.reserve(header.cluster_count);
+	const unsigned char* table{ file.data() + sizeof(header) };
+	for (std::uint32_t i{ 0 }; i < header.cluster_count; i++)
+	{
+		cache_cluster_t record{};
+		std::memcpy(&record, table + i * sizeof(record), sizeof(record));
+		const std::uint64_t payload{
+			std::uint64_t{ record.vertex_count } * sizeof(cache_vertex_t) +
+			std::uint64_t{ record.triangle_count } * sizeof(cache_triangle_t)
+		};
+		if (record.offset > file.size() || payload > file.size() - record.offset) throw invalid();
+
+		cluster_record_t cluster{ {}, record.offset, record.vertex_count, record.triangle_count };
+		cluster.bbox.add(tuple_t::point(record.min[0], record.min[1], record.min[2]),
+			tuple_t::point(record.max[0], record.max[1], record.max[2]));
+		bbox += cluster.bbox;
+		clusters.push_back(cluster);
+	}
+
+	cluster_order.resize(clusters.size());
+	for (std::uint32_t i{ 0 }; i < clusters.size(); i++) cluster_order[i] = i;
+	if (!clusters.empty())
+	{
+		cluster_nodes.reserve(2 * clusters.size());
+		build_cluster_bvh(0, static_cast<std::uint32_t>(clusters.size()));
+	}
+}
+
+std::uint32_t ClusteredMesh::build_cluster_bvh(std::uint32_t begin, std::uint32_t end)
+{
+	const auto centre = [this](std::uint32_t cluster) {
+		const bbox_t& box{ clusters[cluster].bbox };
+		return tuple_t::point((box.min.x + box.max.x) / 2, (box.min.y + box.max.y) / 2, (box.min.z + box.max.z) / 2);
+	};
+
+	const std::uint32_t index{ static_cast<std::uint32_t>(cluster_nodes.size()) };
+	cluster_nodes.push_back({});
+	bbox_t box{};
+	bbox_t centre_bounds{};
+	for (std::uint32_t i{ begin }; i < end; i++)
+	{
+		box += clusters[cluster_order[i]].bbox;
+		centre_bounds.add(centre(cluster_order[i]));
+	}
+	cluster_nodes[index].bbox = box;
+	if (end - begin <= CLUSTER_BVH_LEAF)
+	{
+		cluster_nodes[index].first = begin;
+		cluster_nodes[index].count = end - begin;
+		return index;
+	}
+
+	// same split as write_cache uses for the triangles: the median along the longest axis
+	const tuple_t extent{ centre_bounds.max - centre_bounds.min };
+	const int axis{ extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2 };
+	const auto key = [&centre, axis](std::uint32_t cluster) {
+		const tuple_t c{ centre(cluster) };
+		return axis == 0 ? c.x : axis == 1 ? c.y : c.z;
+	};
+	const std::uint32_t middle{ begin + (end - begin) / 2 };
+	std::nth_element(cluster_order.begin() + begin, cluster_order.begin() + middle, cluster_order.begin() + end,
+		[&key](std::uint32_t a, std::uint32_t b) { return key(a) < key(b); });
+	build_cluster_bvh(begin, middle);
+	const std::uint32_t second{ build_cluster_bvh(middle, end) };
+	cluster_nodes[index].first = second;
+	cluster_nodes[index].count = 0;
+	return index;
+}
+
+ClusteredMesh::~ClusteredMesh()
+{
+	cache.release(this);
+}
+
+std::shared_ptr<ClusteredMesh> ClusteredMesh::create(const char* cache_filename, int bvh_threshold, ClusterCache& cache)
+{
+	return std::make_shared<ClusteredMesh>(cache_filename, bvh_threshold, cache);
+}
+
+void ClusteredMesh::write_cache(const wavefront_t& obj, const char* cache_filename, bool smooth, std::size_t cluster_triangles)
+{
+	if (cluster_triangles == 0)
+	{
+		throw std::invalid_argument("Clusters need at least one triangle");
+	}
+	const vertex_buffer_t buffer{ obj, smooth };
+	const std::size_t triangle_count{ buffer.triangle_count() };
+
+	std::vector<tuple_t> centroids;
+	centroids.reserve(triangle_count);
+	for (std::size_t i{ 0 }; i < triangle_count; i++)
+	{
+		const tuple_t a{ buffer.position(buffer.indices[i * 3]) };
+		const tuple_t b{ buffer.position(buffer.indices[i * 3 + 1]) };
+		const tuple_t c{ buffer.position(buffer.indices[i * 3 + 2]) };
+		centroids.push_back(tuple_t::point((a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3, (a.z + b.z + c.z) / 3));
+	}
+
+	// Split at the centroid median of the longest axis until the clusters are small enough
+	std::vector<std::uint32_t> order(triangle_count);
+	for (std::size_t i{ 0 }; i < triangle_count; i++) order[i] = static_cast<std::uint32_t>(i);
+	std::vector<std::pair<std::size_t, std::size_t>> ranges;
+	const std::function<void(std::size_t, std::size_t)> split = [&](std::size_t begin, std::size_t end) {
+		if (end - begin <= cluster_triangles)
+		{
+			ranges.emplace_back(begin, end);
+			return;
+		}
+		bbox_t centroid_bounds{};
+		for (std::size_t i{ begin }; i < end; i++) centroid_bounds.add(centroids[order[i]]);
+		const tuple_t extent{ centroid_bounds.max - centroid_bounds.min };
+		const int axis{ extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2 };
+		const auto key = [&centroids, axis](std::uint32_t t) {
+			return axis == 0 ? centroids[t].x : axis == 1 ? centroids[t].y : centroids[t].z;
+		};
+		const std::size_t middle{ begin + (end - begin) / 2 };
+		std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+			[&key](std::uint32_t a, std::uint32_t b) { return key(a) < key(b); });
+		split(begin, middle);
+		split(middle, end);
+	};
+	if (triangle_count > 0) split(0, triangle_count);
+
+	std::ofstream out{ cache_filename, std::ios::binary | std::ios::trunc };
+	if (!out)
+	{
+		throw std::runtime_error("Could not write " + std::string{ cache_filename });
+	}
+
+	cache_header_t header{};
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.cluster_count = static_cast<std::uint32_t>(ranges.size());
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// Build every cluster's local vertices first so the table can be written up front
+	std::vector<cache_cluster_t> table(ranges.size());
+	std::vector<std::vector<cache_vertex_t>> cluster_vertices(ranges.size());
+	std::vector<std::vector<cache_triangle_t>> cluster_triangles_data(ranges.size());
+	std::uint64_t offset{ sizeof(header) + ranges.size() * sizeof(cache_cluster_t) };
+	for (std::size_t c{ 0 }; c < ranges.size(); c++)
+	{
+		std::unordered_map<std::uint32_t, std::uint32_t> local_index;
+		bbox_t box{};
+		for (std::size_t i{ ranges[c].first }; i < ranges[c].second; i++)
+		{
+			const std::uint32_t t{ order[i] };
+			const face_t& face{ obj.faces[t] };
+			cache_triangle_t triangle{};
+			triangle.flags = (face.has_uvs() ? TRIANGLE_HAS_UVS : 0) | (face.has_normals() && smooth ? TRIANGLE_HAS_NORMALS : 0);
+			for (int corner{ 0 }; corner < 3; corner++)
+			{
+				const std::uint32_t global{ buffer.indices[t * 3 + corner] };
+				const auto [found, inserted] = local_index.try_emplace(global, static_cast<std::uint32_t>(cluster_vertices[c].size()));
+				if (inserted)
+				{
+					const tuple_t p{ buffer.position(global) };
+					const tuple_t n{ buffer.normal(global) };
+					const auto uv{ buffer.uv(global) };
+					cluster_vertices[c].push_back({ { p.x, p.y, p.z }, { n.x, n.y, n.z }, { uv.first, uv.second } });
+					box.add(p);
+				}
+				triangle.indices[corner] = found->second;
+			}
+			cluster_triangles_data[c].push_back(triangle);
+		}
+		table[c] = {
+			{ box.min.x, box.min.y, box.min.z },
+			{ box.max.x, box.max.y, box.max.z },
+			offset,
+			static_cast<std::uint32_t>(cluster_vertices[c].size()),
+			static_cast<std::uint32_t>(cluster_triangles_data[c].size())
+		};
+		offset += cluster_vertices[c].size() * sizeof(cache_vertex_t) + cluster_triangles_data[c].size() * sizeof(cache_triangle_t);
+	}
+
+	out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(cache_cluster_t));
+	for (std::size_t c{ 0 }; c < ranges.size(); c++)
+	{
+		out.write(reinterpret_cast<const char*>(cluster_vertices[c].data()), cluster_vertices[c].size() * sizeof(cache_vertex_t));
+		out.write(reinterpret_cast<const char*>(cluster_triangles_data[c].data()), cluster_triangles_data[c].size() * sizeof(cache_triangle_t));
+	}
+	if (!out)
+	{
+		throw std::runtime_error("Could not write " + std::string{ cache_filename });
+	}
+}
+
+std::size_t ClusteredMesh::cluster_count() const
+{
+	return clusters.size();
+}
+
+std::shared_ptr<const mesh_cluster_t> ClusteredMesh::load_cluster(std::uint32_t cluster) const
+{
+	const cluster_record_t& record{ clusters[cluster] };
+	const unsigned char* data{ file.data() + record.offset };
+
+	std::vector<mesh_vertex_t> vertices;
+	vertices.reserve(record.vertex_count);
+	for (std::uint32_t i{ 0 }; i < record.vertex_count; i++)
+	{
+		cache_vertex_t v{};
+		std::memcpy(&v, data + i * sizeof(v), sizeof(v));
+		vertices.push_back({
+			tuple_t::point(v.position[0], v.position[1], v.position[2]),
+			tuple_t::vector(v.normal[0], v.normal[1], v.normal[2]),
+			{ v.uv[0], v.uv[1] }
+		});
+	}
+	data += std::size_t{ record.vertex_count } * sizeof(cache_vertex_t);
+
+	std::vector<cache_triangle_t> records(record.triangle_count);
+	std::memcpy(records.data(), data, records.size() * sizeof(cache_triangle_t));
+	std::vector<std::uint32_t> indices;
+	indices.reserve(records.size() * 3);
+	for (const auto& triangle : records)
+	{
+		// the constructor only checked that the cluster lies within the file
+		for (const std::uint32_t index : triangle.indices)
+		{
+			if (index >= record.vertex_count)
+			{
+				throw std::runtime_error("Mesh cache cluster " + std::to_string(cluster) + " references a vertex outside the cluster");
+			}
+		}
+		indices.insert(indices.end(), std::begin(triangle.indices), std::end(triangle.indices));
+	}
+
+	auto result{ std::make_shared<mesh_cluster_t>() };
+	result->vertex_buffer = std::make_shared<vertex_buffer_t>(std::move(vertices), std::move(indices));
+
+	// the mesh is logically const while paging, its triangles just need a parent
+	const std::shared_ptr<SceneObject> self{ std::const_pointer_cast<SceneObject>(shared_from_this()) };
+	result->triangles.reserve(records.size());
+	for (std::size_t i{ 0 }; i < records.size(); i++)
+	{
+		std::shared_ptr<MeshTriangle> tri{ MeshTriangle::create(result->vertex_buffer, static_cast<std::uint32_t>(i)) };
+		tri->has_uvs = (records[i].flags & TRIANGLE_HAS_UVS) != 0;
+		tri->has_vertex_normals = (records[i].flags & TRIANGLE_HAS_NORMALS) != 0;
+		tri->parent = self;
+		tri->material = material;
+		result->triangles.push_back(tri);
+	}
+
+	if (result->triangles.size() > static_cast<std::size_t>(bvh_threshold))
+	{
+		result->bvh = std::make_unique<bvh_t>();
+		for (const auto& tri : result->triangles)
+		{
+			result->bvh->add(tri);
+		}
+		result->bvh->build(bvh_threshold);
+	}
+	return result;
+}
+
+void ClusteredMesh::local_intersect(const ray_t& local_ray, intersections_t& intersections) const
+{
+	if (cluster_nodes.empty()) return;
+
+	// depth first through the cluster BVH, the median split keeps it shallow
+	std::uint32_t stack[64];
+	std::size_t depth{ 0 };
+	stack[depth++] = 0;
+	while (depth > 0)
+	{
+		const std::uint32_t index{ stack[--depth] };
+		const cluster_node_t& node{ cluster_nodes[index] };
+		if (!node.bbox.intersect(local_ray)) continue;
+		if (node.count == 0)
+		{
+			stack[depth++] = node.first;
+			stack[depth++] = index + 1;
+			continue;
+		}
+		for (std::uint32_t i{ node.first }; i < node.first + node.count; i++)
+		{
+			const std::uint32_t c{ cluster_order[i] };
+			if (node.count > 1 && !clusters[c].bbox.intersect(local_ray)) continue;
+			const std::shared_ptr<const mesh_cluster_t> cluster{
+				cache.acquire(this, c, [this, c]() { return load_cluster(c); })
+			};
+			cluster->local_intersect(local_ray, intersections);
+		}
+	}
+}
+
+tuple_t ClusteredMesh::local_normal_at(const tuple_t& local_point, const double, const double, const double) const
+{
+	// never called, the intersections refer to the cluster triangles
+	return tuple_t::vector(local_point.x, local_point.y, local_point.z);
+}
+
+bbox_t ClusteredMesh::bounds() const
+{
+	return bbox;
+}
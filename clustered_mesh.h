@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "geometry.h"
+#include "mesh_triangle.h"
+#include "wavefront_obj.h"
+#include "vertex_buffer.h"
+#include "bvh.h"
+#include "mapped_file.h"
+#include "cluster_cache.h"
+
+/**
+ * @struct mesh_cluster_t
+ * @brief A spatially coherent group of triangles paged in from a mesh cache file.
+ *
+ * A cluster owns its own welded vertex buffer and, above the BVH threshold, its own
+ * BVH, so it can be built and dropped independently of the rest of the mesh.
+ */
+struct mesh_cluster_t
+{
+    /** @brief Vertices referenced by the triangles of this cluster. */
+    std::shared_ptr<vertex_buffer_t> vertex_buffer;
+
+    /** @brief The triangles of the cluster. */
+    std::vector<std::shared_ptr<MeshTriangle>> triangles;
+
+    /** @brief BVH over the triangles, null for small clusters. */
+    std::unique_ptr<bvh_t> bvh;
+
+    /**
+     * @brief Returns an estimate of the bytes held by the cluster.
+     */
+    std::size_t memory_usage() const;
+
+    /**
+     * @brief Intersects a ray with the triangles of the cluster.
+     * @param local_ray The ray in the mesh's local space.
+     * @param intersections A container to collect all resulting intersections.
+     */
+    void local_intersect(const ray_t& local_ray, intersections_t& intersections) const;
+};
+
+/**
+ * @class ClusteredMesh
+ * @brief A triangle mesh that is paged in from a binary cache file on demand.
+ *
+ * `write_cache` converts a parsed OBJ into a binary cache made of spatially coherent
+ * clusters. A ClusteredMesh memory maps that file and only keeps the cluster table in
+ * memory; a cluster's triangles and BVH are built the first time a ray enters its
+ * bounds and are kept in a `ClusterCache`, which evicts the least recently used
+ * clusters once its memory budget is exceeded. This allows rendering meshes that are
+ * larger than the available memory, at the cost of rebuilding evicted clusters.
+ */
+class ClusteredMesh : public Geometry
+{
+public:
+    /**
+     * @brief Opens a mesh cache file.
+     * @param cache_filename Path of a file written by `write_cache`.
+     * @param bvh_threshold The threshold (number of tris) for creating a cluster's BVH.
+     * @param cache The cache holding the resident clusters.
+     * @throws std::runtime_error if the file is missing or not a valid mesh cache.
+     */
+    ClusteredMesh(const char* cache_filename, int bvh_threshold = 128, ClusterCache& cache = ClusterCache::global());
+
+    /**
+     * @brief Releases the mesh's resident clusters from the cache.
+     */
+    ~ClusteredMesh();
+
+    /**
+     * @brief Factory method to create a shared pointer to a ClusteredMesh.
+     * @param cache_filename Path of a file written by `write_cache`.
+     * @param bvh_threshold The threshold (number of tris) for creating a cluster's BVH.
+     * @param cache The cache holding the resident clusters.
+     * @return Shared pointer to the newly created ClusteredMesh.
+     */
+    static std::shared_ptr<ClusteredMesh> create(const char* cache_filename, int bvh_threshold = 128, ClusterCache& cache = ClusterCache::global());
+
+    /**
+     * @brief Writes a binary mesh cache with the triangles grouped into clusters.
+     *
+     * The triangles are split recursively at the median of their centroids along the
+     * longest axis until no group holds more than `cluster_triangles`, then every
+     * group is written with its own welded vertices.
+     *
+     * @param obj The parsed Wavefront OBJ data.
+     * @param cache_filename Path of the file to write.
+     * @param smooth Whether to store vertex normals for smooth shading.
+     * @param cluster_triangles Maximum number of triangles per cluster.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    static void write_cache(const wavefront_t& obj, const char* cache_filename, bool smooth = true, std::size_t cluster_triangles = 4096);
+
+    /**
+     * @brief Returns the number of clusters in the cache file.
+     */
+    std::size_t cluster_count() const;
+
+    /**
+     * @brief Intersects a ray with every cluster whose bounds it enters, paging clusters in as needed.
+     *
+     * The clusters the ray may enter are found through a BVH over their bounds, so
+     * the cost does not grow linearly with the number of clusters.
+     * @param local_ray The ray in the mesh's local space.
+     * @param intersections A container to collect all resulting intersections.
+     */
+    void local_intersect(const ray_t& local_ray, intersections_t& intersections) const override;
+
+    /**
+     * @brief Should never be called, intersections refer to the cluster triangles instead.
+     */
+    tuple_t local_normal_at(const tuple_t& local_point, const double alpha = 0, const double beta = 0, const double gamma = 0) const override;
+
+    /**
+     * @brief Returns the bounding box of the whole mesh (read from the cluster table).
+     */
+    bbox_t bounds() const override;
+
+private:
+    /** @brief Bounds of one cluster and where its data lives in the file. */
+    struct cluster_record_t
+    {
+        bbox_t bbox;
+        std::uint64_t offset;
+        std::uint32_t vertex_count;
+        std::uint32_t triangle_count;
+    };
+
+    /**
+     * @brief A node of the BVH over the cluster bounds.
+     *
+     * Nodes are stored depth first: the first child of an inner node directly follows it.
+     */
+    struct cluster_node_t
+    {
+        bbox_t bbox;
+        std::uint32_t first;  ///< Leaf: first entry in `cluster_order`. Inner node: index of the second child.
+        std::uint32_t count;  ///< Number of clusters of a leaf, 0 for an inner node.
+    };
+
+    /**
+     * @brief Builds the subtree over `cluster_order[begin, end)`, splitting at the median of the cluster centres.
+     * @return Index of the subtree's root node.
+     */
+    std::uint32_t build_cluster_bvh(std::uint32_t begin, std::uint32_t end);
+
+    /**
+     * @brief Builds a cluster from the mapped file.
+     * @param cluster Index of the cluster.
+     * @throws std::runtime_error if a triangle references a vertex outside the cluster.
+     */
+    std::shared_ptr<const mesh_cluster_t> load_cluster(std::uint32_t cluster) const;
+
+    MappedFile file;                             ///< The mapped cache file.
+    std::vector<cluster_record_t> clusters;      ///< Cluster table.
+    std::vector<cluster_node_t> cluster_nodes;   ///< BVH over the cluster bounds, the root first.
+    std::vector<std::uint32_t> cluster_order;    ///< Cluster indices, each leaf owns a contiguous run.
+    bbox_t bbox{};                               ///< Union of the cluster bounds.
+    int bvh_threshold;                           ///< BVH threshold used when building clusters.
+    ClusterCache& cache;                         ///< Cache the clusters are kept in.
+};
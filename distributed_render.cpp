@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "distributed_render.h"
+#include "settings.h"
+#include "thread_pool.h"
+#include "tile_scheduler.h"
+
+/**
+ * @brief Types of the messages exchanged between the coordinator and the workers.
+ */
+enum class Message_Type : std::uint32_t
+{
+	hello = 1,  ///< worker -> coordinator: number of render threads
+	job,        ///< coordinator -> worker: image size, tile size and scene description
+	assign,     ///< coordinator -> worker: tile indices to render
+	tile,       ///< worker -> coordinator: tile index and its pixels as float RGB
+	done,       ///< coordinator -> worker: the render is finished, exit
+	error       ///< worker -> coordinator: why the worker gives up
+};
+
+/** @brief Largest payload accepted, a guard against a corrupt stream. */
+static constexpr std::uint32_t MAX_MESSAGE_SIZE{ 1u << 30 };
+
+struct message_t
+{
+	Message_Type type;
+	std::vector<std::uint8_t> payload;
+};
+
+template<typename T>
+static void put(std::vector<std::uint8_t>& out, const T value)
+{
+	const std::size_t offset{ out.size() };
+	out.resize(offset + sizeof(T));
+	std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template<typename T>
+static T get(const std::vector<std::uint8_t>& in, std::size_t& offset)
+{
+	if (offset + sizeof(T) > in.size())
+	{
+		throw std::runtime_error("Truncated render message");
+	}
+	T value{};
+	std::memcpy(&value, in.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return value;
+}
+
+static void send_message(const TcpSocket& socket, const Message_Type type, const std::vector<std::uint8_t>& payload = {})
+{
+	std::vector<std::uint8_t> frame;
+	frame.reserve(8 + payload.size());
+	put(frame, static_cast<std::uint32_t>(type));
+	put(frame, static_cast<std::uint32_t>(payload.size()));
+	frame.insert(frame.end(), payload.begin(), payload.end());
+	socket.send_all(frame.data(), frame.size());
+}
+
+/**
+ * @brief Receives one message.
+ *
+ * @return false if the connection closed or the message is malformed.
+ */
+static bool receive_message(const TcpSocket& socket, message_t& message)
+{
+	std::uint32_t header[2]{};
+	if (!socket.receive_all(header, sizeof(header)) || header[1] > MAX_MESSAGE_SIZE)
+	{
+		return false;
+	}
+	message.type = static_cast<Message_Type>(header[0]);
+	message.payload.resize(header[1]);
+	return socket.receive_all(message.payload.data(), message.payload.size());
+}
+
+RenderCoordinator::RenderCoordinator(const std::string& scene, int width, int height, int tile_size, const coordinator_options_t& options)
+	: scene{ scene }, width{ width }, height{ height }, tile_size{ tile_size }, options{ options },
+	listener{ TcpSocket::listen(options.port) }
+{
+	if (TileScheduler::grid_size(width, height, tile_size) == 0)
+	{
+		throw std::invalid_argument("Distributed render needs a positive image and tile size");
+	}
+}
+
+std::uint16_t RenderCoordinator::port() const
+{
+	return listener.local_port();
+}
+
+canvas_t RenderCoordinator::render()
+{
+	canvas_t image{ width, height };
+	const std::size_t count{ TileScheduler::grid_size(width, height, tile_size) };
+	std::vector<bool> done(count, false);
+	std::size_t remaining{ count };
+	pending.clear();
+	for (std::size_t i{ 0 }; i < count; i++)
+	{
+		pending.push_back(i);
+	}
+	seen = 0;
+	reassigned = 0;
+
+	std::vector<std::unique_ptr<connection_t>> workers;
+	auto idle_since = std::chrono::steady_clock::now();
+	while (remaining > 0)
+	{
+		std::vector<const TcpSocket*> watched{ &listener };
+		for (const auto& worker : workers)
+		{
+			watched.push_back(&worker->socket);
+		}
+		for (const std::size_t ready : TcpSocket::wait_readable(watched, 0.1))
+		{
+			if (ready == 0)
+			{
+				auto worker{ std::make_unique<connection_t>() };
+				worker->socket = listener.accept();
+				// the sockets are polled, but a worker stalling halfway through a message must not block the render
+				worker->socket.set_receive_timeout(options.worker_timeout);
+				worker->last_heard = std::chrono::steady_clock::now();
+				std::vector<std::uint8_t> job;
+				put(job, static_cast<std::uint32_t>(width));
+				put(job, static_cast<std::uint32_t>(height));
+				put(job, static_cast<std::uint32_t>(tile_size));
+				job.insert(job.end(), scene.begin(), scene.end());
+				try
+				{
+					send_message(worker->socket, Message_Type::job, job);
+					workers.push_back(std::move(worker));
+					seen++;
+				}
+				catch (const std::runtime_error&)
+				{
+				}
+			}
+			else if (!receive(*workers[ready - 1], image, done, remaining))
+			{
+				drop(*workers[ready - 1], done);
+			}
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		for (const auto& worker : workers)
+		{
+			if (!worker->socket.is_open()) continue;
+			const std::chrono::duration<double> silent = now - worker->last_heard;
+			if (!worker->assigned.empty() && silent.count() > options.worker_timeout)
+			{
+				drop(*worker, done);
+				continue;
+			}
+			try
+			{
+				assign(*worker);
+			}
+			catch (const std::runtime_error&)
+			{
+				drop(*worker, done);
+			}
+		}
+		workers.erase(std::remove_if(workers.begin(), workers.end(), [](const auto& worker) {
+			return !worker->socket.is_open();
+		}), workers.end());
+
+		if (!workers.empty())
+		{
+			idle_since = now;
+		}
+		else if (std::chrono::duration<double>(now - idle_since).count() > options.idle_timeout)
+		{
+			throw std::runtime_error("No render workers connected");
+		}
+	}
+
+	// release the workers, including any that connected too late to get work
+	while (!TcpSocket::wait_readable({ &listener }, 0).empty())
+	{
+		auto worker{ std::make_unique<connection_t>() };
+		worker->socket = listener.accept();
+		workers.push_back(std::move(worker));
+	}
+	for (const auto& worker : workers)
+	{
+		try
+		{
+			send_message(worker->socket, Message_Type::done);
+		}
+		catch (const std::runtime_error&)
+		{
+		}
+	}
+	return image;
+}
+
+bool RenderCoordinator::receive(connection_t& worker, canvas_t& image, std::vector<bool>& done, std::size_t& remaining)
+{
+	message_t message{};
+	if (!receive_message(worker.socket, message))
+	{
+		return false;
+	}
+	worker.last_heard = std::chrono::steady_clock::now();
+	try
+	{
+		std::size_t offset{ 0 };
+		switch (message.type)
+		{
+		case Message_Type::hello:
+			worker.threads = std::max(get<std::uint32_t>(message.payload, offset), 1u);
+			return true;
+		case Message_Type::tile:
+		{
+			const std::size_t index{ get<std::uint32_t>(message.payload, offset) };
+			if (index >= done.size()) return false;
+			const render_tile_t tile{ TileScheduler::grid_tile(width, height, tile_size, index) };
+			if (message.payload.size() != offset + static_cast<std::size_t>(tile.area()) * 3 * sizeof(float)) return false;
+			if (!done[index])
+			{
+				for (int y{ tile.y_start }; y < tile.y_end; y++)
+				{
+					for (int x{ tile.x_start }; x < tile.x_end; x++)
+					{
+						const float red{ get<float>(message.payload, offset) };
+						const float green{ get<float>(message.payload, offset) };
+						const float blue{ get<float>(message.payload, offset) };
+						image.write_pixel(x, y, colour_t{ red, green, blue });
+					}
+				}
+				done[index] = true;
+				remaining--;
+			}
+			worker.assigned.erase(std::remove(worker.assigned.begin(), worker.assigned.end(), index), worker.assigned.end());
+			return true;
+		}
+		case Message_Type::error:
+			std::cerr << "Render worker failed: " << std::string{ message.payload.begin(), message.payload.end() } << "\n";
+			return false;
+		default:
+			return false;
+		}
+	}
+	catch (const std::runtime_error&)
+	{
+		return false;
+	}
+}
+
+void RenderCoordinator::assign(connection_t& worker)
+{
+	// top the worker up before it runs dry, so it never waits for the next batch
+	if (worker.threads == 0 || worker.assigned.size() >= worker.threads || pending.empty())
+	{
+		return;
+	}
+	std::vector<std::uint8_t> batch;
+	std::vector<std::size_t> tiles;
+	while (tiles.size() < worker.threads && !pending.empty())
+	{
+		tiles.push_back(pending.front());
+		pending.pop_front();
+	}
+	put(batch, static_cast<std::uint32_t>(tiles.size()));
+	for (const std::size_t index : tiles)
+	{
+		put(batch, static_cast<std::uint32_t>(index));
+	}
+	worker.assigned.insert(worker.assigned.end(), tiles.begin(), tiles.end());
+	send_message(worker.socket, Message_Type::assign, batch);
+}
+
+void RenderCoordinator::drop(connection_t& worker, const std::vector<bool>& done)
+{
+	for (auto tile{ worker.assigned.rbegin() }; tile != worker.assigned.rend(); ++tile)
+	{
+		if (!done[*tile])
+		{
+			pending.push_front(*tile);
+			reassigned++;
+		}
+	}
+	worker.assigned.clear();
+	worker.socket.close();
+}
+
+std::size_t RenderCoordinator::workers_seen() const
+{
+	return seen;
+}
+
+std::size_t RenderCoordinator::tiles_reassigned() const
+{
+	return reassigned;
+}
+
+void run_render_worker(const std::string& host, std::uint16_t port, const scene_loader_t& load_scene, const worker_options_t& options)
+{
+	const TcpSocket socket{ TcpSocket::connect(host, port) };
+	ThreadPool& pool{ ThreadPool::shared() };
+	std::vector<std::uint8_t> hello;
+	put(hello, static_cast<std::uint32_t>(pool.thread_count() + 1));
+	send_message(socket, Message_Type::hello, hello);
+
+	// a render that finished before this worker was accepted just sends done
+	message_t message{};
+	if (!receive_message(socket, message) || message.type != Message_Type::job)
+	{
+		return;
+	}
+	std::size_t offset{ 0 };
+	const int width{ static_cast<int>(get<std::uint32_t>(message.payload, offset)) };
+	const int height{ static_cast<int>(get<std::uint32_t>(message.payload, offset)) };
+	const int tile_size{ static_cast<int>(get<std::uint32_t>(message.payload, offset)) };
+	const std::string name{ message.payload.begin() + offset, message.payload.end() };
+
+	scene_t scene{ [&]() {
+		try
+		{
+			return load_scene(name);
+		}
+		catch (const std::exception& e)
+		{
+			const std::string reason{ e.what() };
+			send_message(socket, Message_Type::error, { reason.begin(), reason.end() });
+			throw;
+		}
+	}() };
+	if (scene.camera.hsize != width || scene.camera.vsize != height)
+	{
+		const std::string reason{ "Scene " + name + " does not match the image size" };
+		send_message(socket, Message_Type::error, { reason.begin(), reason.end() });
+		throw std::runtime_error(reason);
+	}
+
+	const camera_basis_t view{ scene.camera.basis() };
+	std::mutex send_mutex;
+	std::size_t sent{ 0 };
+	const auto limit_reached = [&options, &sent]() {
+		return options.max_tiles > 0 && sent >= options.max_tiles;
+	};
+	while (receive_message(socket, message))
+	{
+		if (message.type != Message_Type::assign)
+		{
+			return;
+		}
+		offset = 0;
+		const std::size_t count{ get<std::uint32_t>(message.payload, offset) };
+		if (message.payload.size() != offset + count * sizeof(std::uint32_t))
+		{
+			throw std::runtime_error("Malformed render assignment");
+		}
+		std::vector<std::size_t> tiles(count);
+		for (auto& index : tiles)
+		{
+			index = get<std::uint32_t>(message.payload, offset);
+			if (index >= TileScheduler::grid_size(width, height, tile_size))
+			{
+				throw std::runtime_error("Render assignment holds a tile outside the image");
+			}
+		}
+		pool.parallel_for(0, tiles.size(), 1, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i{ begin }; i < end; i++)
+			{
+				const render_tile_t tile{ TileScheduler::grid_tile(width, height, tile_size, tiles[i]) };
+				std::vector<std::uint8_t> payload;
+				payload.reserve(4 + static_cast<std::size_t>(tile.area()) * 3 * sizeof(float));
+				put(payload, static_cast<std::uint32_t>(tiles[i]));
+				ray_batch_t rays;
+				view.generate(tile.x_start, tile.x_end, tile.y_start, tile.y_end, rays);
+				for (std::size_t r{ 0 }; r < rays.size(); r++)
+				{
+					const colour_t colour{ scene.world.colour_at(view.with_differentials(rays.ray(r)), MAX_REFLECTION_DEPTH) };
+					put(payload, static_cast<float>(colour.red));
+					put(payload, static_cast<float>(colour.green));
+					put(payload, static_cast<float>(colour.blue));
+				}
+				std::lock_guard<std::mutex> lk{ send_mutex };
+				if (limit_reached()) return;
+				send_message(socket, Message_Type::tile, payload);
+				sent++;
+			}
+		});
+		if (limit_reached())
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include "camera.h"
+#include "canvas.h"
+#include "world.h"
+#include "tcp_socket.h"
+
+/**
+ * @struct scene_t
+ * @brief A world together with the camera it is rendered through.
+ */
+struct scene_t
+{
+    World world;    ///< The scene.
+    Camera camera;  ///< The view, its size must match the distributed render.
+};
+
+/**
+ * @brief Builds a scene from its description (a name or a path), on every worker.
+ *
+ * Scenes are built in code, so the coordinator sends the description rather than the
+ * scene itself and each worker process builds its own copy.
+ */
+using scene_loader_t = std::function<scene_t(const std::string& scene)>;
+
+/**
+ * @struct coordinator_options_t
+ * @brief Settings of a `RenderCoordinator`.
+ */
+struct coordinator_options_t
+{
+    /** @brief Port workers connect to on the loopback interface, 0 picks a free one. */
+    std::uint16_t port{ 0 };
+
+    /**
+     * @brief Seconds a worker with tiles assigned may stay silent before it is dropped and its tiles reassigned.
+     *
+     * Also the longest wait for the rest of a message a worker has started sending.
+     */
+    double worker_timeout{ 30 };
+
+    /** @brief Seconds `render` waits with tiles left but no worker connected before it gives up. */
+    double idle_timeout{ 60 };
+};
+
+/**
+ * @struct worker_options_t
+ * @brief Settings of `run_render_worker`.
+ */
+struct worker_options_t
+{
+    /** @brief Number of tiles after which the worker disconnects (0 for no limit), e.g. to recycle worker processes. */
+    std::size_t max_tiles{ 0 };
+};
+
+/**
+ * @class RenderCoordinator
+ * @brief Renders an image by handing its tiles to worker processes over TCP.
+ *
+ * Workers (`run_render_worker`, usually in another process or on another host
+ * through a tunnel) connect to the coordinator, receive the scene description and
+ * are then handed batches of grid tiles, as many per batch as they have threads.
+ * Each finished tile is streamed back as soon as it is rendered, and a new batch is
+ * sent before the worker runs out of work. A worker that disconnects, stays silent
+ * or stalls within a message longer than `worker_timeout` is dropped and its
+ * unfinished tiles are handed to the next worker asking for work. Workers may join
+ * at any time during the render.
+ *
+ * Messages are a 32-bit type and a 32-bit length followed by the payload, in host
+ * byte order, so the coordinator and the workers must share an architecture.
+ */
+class RenderCoordinator
+{
+public:
+    /**
+     * @brief Starts listening for workers.
+     *
+     * @param scene Description of the scene passed to the workers' scene loader.
+     * @param width Image width in pixels.
+     * @param height Image height in pixels.
+     * @param tile_size Width and height of the tiles in pixels.
+     * @param options Port and timeouts.
+     * @throws std::runtime_error if the port cannot be opened.
+     */
+    RenderCoordinator(const std::string& scene, int width, int height, int tile_size, const coordinator_options_t& options = {});
+
+    /**
+     * @brief Returns the port workers should connect to.
+     */
+    std::uint16_t port() const;
+
+    /**
+     * @brief Renders the image with the workers that are or become connected.
+     *
+     * Workers are told to exit once every tile has arrived.
+     *
+     * @return canvas_t The assembled image.
+     * @throws std::runtime_error if no worker is connected for longer than `idle_timeout`
+     * while tiles are left.
+     */
+    canvas_t render();
+
+    /**
+     * @brief Returns the number of workers that connected during the last `render`.
+     */
+    std::size_t workers_seen() const;
+
+    /**
+     * @brief Returns the number of tiles of the last `render` that had to be handed to another worker.
+     */
+    std::size_t tiles_reassigned() const;
+
+private:
+    /**
+     * @struct connection_t
+     * @brief State of one connected worker.
+     */
+    struct connection_t
+    {
+        TcpSocket socket;                   ///< Connection to the worker.
+        unsigned threads{ 0 };              ///< Threads the worker renders with, 0 until it said hello.
+        std::vector<std::size_t> assigned;  ///< Tiles handed to the worker and not received yet.
+        std::chrono::steady_clock::time_point last_heard; ///< When the worker last sent a message.
+    };
+
+    /**
+     * @brief Handles one message from a worker.
+     *
+     * @param worker The worker that sent the message.
+     * @param image Receives the pixels of finished tiles.
+     * @param done Which tiles have arrived.
+     * @param remaining Number of tiles that have not arrived.
+     * @return false if the worker has to be dropped.
+     */
+    bool receive(connection_t& worker, canvas_t& image, std::vector<bool>& done, std::size_t& remaining);
+
+    /**
+     * @brief Hands a batch of tiles to a worker that is running low on work.
+     */
+    void assign(connection_t& worker);
+
+    /**
+     * @brief Closes a worker's connection and puts its unfinished tiles back in the queue.
+     */
+    void drop(connection_t& worker, const std::vector<bool>& done);
+
+    std::string scene;                  ///< Scene description sent to the workers.
+    int width;                          ///< Image width in pixels.
+    int height;                         ///< Image height in pixels.
+    int tile_size;                      ///< Width and height of the tiles.
+    coordinator_options_t options;      ///< Port and timeouts.
+    TcpSocket listener;                 ///< Socket workers connect to.
+    std::deque<std::size_t> pending;    ///< Tiles not assigned to a worker.
+    std::size_t seen{ 0 };              ///< Workers connected during the last render.
+    std::size_t reassigned{ 0 };        ///< Tiles handed out more than once during the last render.
+};
+
+/**
+ * @brief Connects to a coordinator and renders the tiles it hands out until told to stop.
+ *
+ * Tiles are rendered on the shared thread pool and each one is sent back as soon as it
+ * is finished.
+ *
+ * @param host Host of the coordinator.
+ * @param port Port of the coordinator.
+ * @param load_scene Builds the scene the coordinator names.
+ * @param options Worker settings.
+ * @throws std::runtime_error if the connection cannot be made, the scene does not match the render or
+ * an assignment is malformed.
+ */
+void run_render_worker(const std::string& host, std::uint16_t port, const scene_loader_t& load_scene, const worker_options_t& options = {});
@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "../threadsafe_queue.h"
+#include "../lock_free_queue.h"
+#include "../join_threads.h"
+
+/**
+ * @brief Moves `items` integers through a queue and returns the throughput in millions of items per second.
+ *
+ * With a single thread the thread alternates between pushing and popping, otherwise
+ * half the threads push and the other half pop.
+ *
+ * @tparam Queue A queue with `push(int)` and `wait_and_pop(int&)`.
+ * @param queue The queue under test.
+ * @param thread_count Total number of threads.
+ * @param items Number of items to move through the queue.
+ */
+template<typename Queue>
+double measure_queue(Queue& queue, const unsigned thread_count, const int items)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    if (thread_count == 1)
+    {
+        int value{};
+        for (int i{ 0 }; i < items; i++)
+        {
+            queue.push(i);
+            queue.wait_and_pop(value);
+        }
+    }
+    else
+    {
+        const unsigned producers{ thread_count / 2 };
+        const unsigned consumers{ thread_count - producers };
+        std::vector<std::thread> threads;
+        {
+            JoinThreads joiner{ threads };
+            for (unsigned p{ 0 }; p < producers; p++)
+            {
+                // spread the remainder over the first threads so exactly `items` are moved
+                const int count{ items / static_cast<int>(producers) + (p < items % producers ? 1 : 0) };
+                threads.emplace_back([&queue, count]() {
+                    for (int i{ 0 }; i < count; i++) queue.push(i);
+                });
+            }
+            for (unsigned c{ 0 }; c < consumers; c++)
+            {
+                const int count{ items / static_cast<int>(consumers) + (c < items % consumers ? 1 : 0) };
+                threads.emplace_back([&queue, count]() {
+                    int value{};
+                    for (int i{ 0 }; i < count; i++) queue.wait_and_pop(value);
+                });
+            }
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double> duration = end - start;
+    return items / duration.count() / 1e6;
+}
+
+/**
+ * @brief Contention microbenchmark of LockFreeQueue against the mutex based ThreadsafeQueue.
+ *
+ * Prints the throughput of both queues at 1 to 64 threads.
+ */
+void queue_benchmark_exercise()
+{
+    const int items{ 2'000'000 };
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "mutex Mops/s" << std::setw(20) << "lock-free Mops/s" << "\n";
+    for (unsigned thread_count{ 1 }; thread_count <= 64; thread_count *= 2)
+    {
+        ThreadsafeQueue<int> mutex_queue{};
+        LockFreeQueue<int> lock_free_queue{ 1024 };
+        const double mutex_rate{ measure_queue(mutex_queue, thread_count, items) };
+        const double lock_free_rate{ measure_queue(lock_free_queue, thread_count, items) };
+        std::cout << std::setw(8) << thread_count
+            << std::setw(16) << std::fixed << std::setprecision(2) << mutex_rate
+            << std::setw(20) << lock_free_rate << "\n";
+    }
+}
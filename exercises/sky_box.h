@@ -7,10 +7,18 @@
 #include "../cube.h"
 #include "../cube_map.h"
 #include "../pattern_file.h"
+#include "../asset_registry.h"
 
 // magick convert .\negx.jpg - compress none negx.ppm
 void sky_box_exercise()
 {
+    // === Textures, loaded on the pool while the scene is assembled ===
+    for (const char* face : { ".\\assets\\negx.ppm", ".\\assets\\negy.ppm", ".\\assets\\negz.ppm",
+        ".\\assets\\posx.ppm", ".\\assets\\posy.ppm", ".\\assets\\posz.ppm" })
+    {
+        AssetRegistry::global().prefetch_texture(face, Texture_Format::rgb_float);
+    }
+
     // === Camera ===
     Camera camera{ 1600, 800, 1.2 };
     camera.transform = matrix_t::view_transform(
@@ -52,6 +52,9 @@ intersection_state intersection_t::prepare(const ray_t& r, const intersections_t
 	state.over_point = state.point + (state.normal * EPSILON);
 	state.under_point = state.point - (state.normal * EPSILON);
 
+	// Footprint of the pixel on the surface, if the ray carries differentials
+	state.compute_differentials(r);
+
 	// Used to track which objects the ray is inside of as it moves through intersections
 	std::vector<const Geometry*> containers{};
 
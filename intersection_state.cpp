@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <cmath>
 #include "intersection_state.h"
 #include "tuple.h"
+#include "settings.h"
 
 double intersection_state::schlick() const
 {
@@ -36,3 +38,98 @@ double intersection_state::schlick() const
 	// Apply the Schlick approximation formula to estimate reflectance at the given angle
 	return r0 + (1 - r0) * pow((1 - cos), 5);
 }
+
+double surface_differentials_t::uv_footprint() const
+{
+	return std::max(std::hypot(du_dx, dv_dx), std::hypot(du_dy, dv_dy));
+}
+
+/**
+ * @brief Returns the difference of two texture coordinates, across the seam of wrapping mappings.
+ */
+static double uv_delta(const double from, const double to)
+{
+	const double delta{ to - from };
+	return delta - std::round(delta);
+}
+
+void intersection_state::compute_differentials(const ray_t& r)
+{
+	differentials = {};
+	const ray_differentials_t& rays{ r.differentials };
+	if (!rays.valid)
+	{
+		return;
+	}
+	// intersect the offset rays with the tangent plane at the hit
+	const double dx_cos{ tuple_t::dot(normal, rays.dx_direction) };
+	const double dy_cos{ tuple_t::dot(normal, rays.dy_direction) };
+	if (std::fabs(dx_cos) < EPSILON || std::fabs(dy_cos) < EPSILON)
+	{
+		return;
+	}
+	const double tx{ tuple_t::dot(normal, point - rays.dx_origin) / dx_cos };
+	const double ty{ tuple_t::dot(normal, point - rays.dy_origin) / dy_cos };
+	differentials.dpdx = rays.dx_origin + rays.dx_direction * tx - point;
+	differentials.dpdy = rays.dy_origin + rays.dy_direction * ty - point;
+	differentials.dx_direction = rays.dx_direction;
+	differentials.dy_direction = rays.dy_direction;
+	differentials.valid = true;
+
+	if (object->has_uvs)
+	{
+		// map the offset points like the hit, UV mappings have no analytic derivatives
+		const uv_t uv{ object->get_uv(object->world_to_object(point)) };
+		const uv_t uv_x{ object->get_uv(object->world_to_object(point + differentials.dpdx)) };
+		const uv_t uv_y{ object->get_uv(object->world_to_object(point + differentials.dpdy)) };
+		differentials.du_dx = uv_delta(uv.u, uv_x.u);
+		differentials.dv_dx = uv_delta(uv.v, uv_x.v);
+		differentials.du_dy = uv_delta(uv.u, uv_y.u);
+		differentials.dv_dy = uv_delta(uv.v, uv_y.v);
+	}
+}
+
+ray_differentials_t intersection_state::reflected_differentials() const
+{
+	if (!differentials.valid)
+	{
+		return {};
+	}
+	return {
+		true,
+		over_point + differentials.dpdx,
+		differentials.dx_direction.reflect(normal),
+		over_point + differentials.dpdy,
+		differentials.dy_direction.reflect(normal)
+	};
+}
+
+/**
+ * @brief Refracts a direction through a surface with Snell's law, false on total internal reflection.
+ */
+static bool refract(const tuple_t& direction, const tuple_t& normal, const double n_ratio, tuple_t& refracted)
+{
+	const double cos_i{ -tuple_t::dot(direction, normal) };
+	const double sin2_t{ n_ratio * n_ratio * (1 - cos_i * cos_i) };
+	if (sin2_t > 1)
+	{
+		return false;
+	}
+	refracted = normal * (n_ratio * cos_i - std::sqrt(1.0 - sin2_t)) + direction * n_ratio;
+	return true;
+}
+
+ray_differentials_t intersection_state::refracted_differentials(const double n_ratio) const
+{
+	ray_differentials_t rays{};
+	if (!differentials.valid ||
+		!refract(differentials.dx_direction, normal, n_ratio, rays.dx_direction) ||
+		!refract(differentials.dy_direction, normal, n_ratio, rays.dy_direction))
+	{
+		return {};
+	}
+	rays.valid = true;
+	rays.dx_origin = under_point + differentials.dpdx;
+	rays.dy_origin = under_point + differentials.dpdy;
+	return rays;
+}
@@ -1,7 +1,35 @@
 #pragma once
 #include "geometry.h"
+#include "ray.h"
 #include "tuple.h"
 
+/**
+ * @struct surface_differentials_t
+ * @brief How the surface position and UV coordinates change from one pixel to the next.
+ *
+ * Computed from the ray differentials at a hit, for filtering textures and band-limiting
+ * patterns over the area of the surface a pixel covers.
+ */
+struct surface_differentials_t
+{
+	bool valid{ false };		///< Whether the differentials are set, they are optional.
+	tuple_t dpdx{};				///< Change of the hit point one pixel to the right, in world space.
+	tuple_t dpdy{};				///< Change of the hit point one pixel down, in world space.
+	tuple_t dx_direction{};		///< Direction of the incoming ray one pixel to the right.
+	tuple_t dy_direction{};		///< Direction of the incoming ray one pixel down.
+	double du_dx{ 0 };			///< Change of u one pixel to the right.
+	double dv_dx{ 0 };			///< Change of v one pixel to the right.
+	double du_dy{ 0 };			///< Change of u one pixel down.
+	double dv_dy{ 0 };			///< Change of v one pixel down.
+
+	/**
+	 * @brief Returns the width of the pixel footprint in UV units.
+	 *
+	 * @return The longer of the UV steps to the neighbouring pixels.
+	 */
+	double uv_footprint() const;
+};
+
 /**
  * @struct intersection_state
  * @brief Stores precomputed information about a ray-object intersection for shading.
@@ -93,6 +121,38 @@ struct intersection_state
 	 */
 	double n2;
 
+	/**
+	 * @brief The footprint of the pixel on the surface, valid if the ray had differentials.
+	 */
+	surface_differentials_t differentials;
+
+	/**
+	 * @brief Computes the surface differentials from the offset rays of the incoming ray.
+	 *
+	 * The offset rays are intersected with the tangent plane at the hit. The UV
+	 * derivatives are only computed for objects with UV coordinates. The differentials
+	 * stay invalid if an offset ray is parallel to the plane.
+	 *
+	 * @param r The incoming ray, in world space.
+	 */
+	void compute_differentials(const ray_t& r);
+
+	/**
+	 * @brief Returns the offset rays of the reflected ray.
+	 *
+	 * The offset rays start at the offset hit points and are reflected about the normal
+	 * at the hit (the change of the normal over the footprint is ignored).
+	 */
+	ray_differentials_t reflected_differentials() const;
+
+	/**
+	 * @brief Returns the offset rays of the refracted ray.
+	 *
+	 * @param n_ratio Ratio of the refractive indices, n1 / n2.
+	 * @return The offset rays, invalid if an offset ray is totally internally reflected.
+	 */
+	ray_differentials_t refracted_differentials(const double n_ratio) const;
+
 	/**
 	 * @brief Computes the reflectance at the intersection using the Schlick approximation.
 	 *
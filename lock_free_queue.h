@@ -0,0 +1,235 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @brief A bounded, lock-free multi-producer/multi-consumer queue.
+ *
+ * A ring buffer in the style of Dmitry Vyukov's bounded MPMC queue. Every cell
+ * carries a sequence number that tells producers and consumers whether the cell is
+ * free for the lap they are on, so a successful push or pop costs one
+ * compare-and-swap on the shared position plus one store on the cell, and never
+ * takes a lock. No other shared state is written or read.
+ *
+ * The surface mirrors `ThreadsafeQueue`: `push` and `wait_and_pop` block when the
+ * queue is full or empty, while `try_push` and `try_pop` never block. Blocked calls
+ * are not notified, that would put a check for sleepers on every push and pop;
+ * they yield a few times and then poll with sleeps doubling up to `MAX_BACKOFF`,
+ * which bounds how late they notice the queue change.
+ *
+ * @tparam T The type of elements stored in the queue (must be default constructible and movable).
+ */
+template<typename T>
+class LockFreeQueue
+{
+public:
+    /**
+     * @brief Constructs an empty queue.
+     *
+     * @param capacity Maximum number of elements, rounded up to a power of two (at least 2).
+     */
+    explicit LockFreeQueue(std::size_t capacity)
+    {
+        std::size_t size{ 2 };
+        while (size < capacity)
+        {
+            if (size > (static_cast<std::size_t>(-1) >> 2)) throw std::length_error("LockFreeQueue capacity too large");
+            size <<= 1;
+        }
+        mask = size - 1;
+        buffer = std::make_unique<cell_t[]>(size);
+        for (std::size_t i{ 0 }; i < size; i++)
+        {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    /**
+     * @brief Tries to push a value without blocking.
+     *
+     * @param new_value The value to be added. It is only moved from if the push succeeds.
+     * @return true if the value was pushed, false if the queue was full.
+     */
+    bool try_push(T& new_value)
+    {
+        cell_t* cell;
+        std::size_t pos{ enqueue_pos.load(std::memory_order_relaxed) };
+        for (;;)
+        {
+            cell = &buffer[pos & mask];
+            const std::size_t seq{ cell->sequence.load(std::memory_order_acquire) };
+            const std::ptrdiff_t diff{ static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos) };
+            if (diff == 0)
+            {
+                // the cell is free on this lap, claim it
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                // the cell still holds the value from the previous lap
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(new_value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pushes a value, waiting for space if the queue is full.
+     *
+     * @param new_value The value to be added. It will be moved into the queue.
+     */
+    void push(T new_value)
+    {
+        for (int attempt{ 0 }; !try_push(new_value); attempt++)
+        {
+            back_off(attempt);
+        }
+    }
+
+    /**
+     * @brief Tries to pop a value without blocking.
+     *
+     * @param value Reference to store the value if available.
+     * @return true if a value was popped, false if the queue was empty.
+     */
+    bool try_pop(T& value)
+    {
+        cell_t* cell;
+        std::size_t pos{ dequeue_pos.load(std::memory_order_relaxed) };
+        for (;;)
+        {
+            cell = &buffer[pos & mask];
+            const std::size_t seq{ cell->sequence.load(std::memory_order_acquire) };
+            const std::ptrdiff_t diff{ static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1) };
+            if (diff == 0)
+            {
+                // the cell has been filled on this lap, claim it
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                // nothing has been pushed into the cell yet
+                return false;
+            }
+            else
+            {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        // free the cell for the producer on the next lap
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Blocks until a value is available, then pops it into the provided reference.
+     *
+     * @param value Reference to store the popped value.
+     */
+    void wait_and_pop(T& value)
+    {
+        for (int attempt{ 0 }; !try_pop(value); attempt++)
+        {
+            back_off(attempt);
+        }
+    }
+
+    /**
+     * @brief Checks whether the queue is empty.
+     *
+     * Only a snapshot, other threads may push or pop at the same time. A value that
+     * is still being pushed or popped counts as queued.
+     *
+     * @return true if the queue is empty, false otherwise.
+     */
+    bool empty() const
+    {
+        // read the consumers' position first, so it cannot have moved past the producers' one
+        const std::size_t dequeued{ dequeue_pos.load(std::memory_order_acquire) };
+        return enqueue_pos.load(std::memory_order_acquire) == dequeued;
+    }
+
+    /**
+     * @brief Returns the maximum number of elements the queue can hold.
+     */
+    std::size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    /**
+     * @brief Number of times a blocking call retries (yielding in between) before it sleeps.
+     */
+    static constexpr int SPIN_ATTEMPTS{ 16 };
+
+    /**
+     * @brief Longest sleep between two retries of a blocking call.
+     */
+    static constexpr std::chrono::microseconds MAX_BACKOFF{ 1000 };
+
+    /**
+     * @brief Waits before the next retry of a blocked push or pop.
+     *
+     * @param attempt Number of failed attempts so far.
+     */
+    static void back_off(const int attempt)
+    {
+        if (attempt < SPIN_ATTEMPTS)
+        {
+            std::this_thread::yield();
+            return;
+        }
+        const int doublings{ std::min(attempt - SPIN_ATTEMPTS, 10) };
+        std::this_thread::sleep_for(std::min(std::chrono::microseconds{ 1 << doublings }, MAX_BACKOFF));
+    }
+
+    /**
+     * @brief Assumed cache line size, the positions each get their own line.
+     */
+    static constexpr std::size_t cache_line{ 64 };
+
+    /**
+     * @brief A slot of the ring buffer and the lap it is ready for.
+     */
+    struct cell_t
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    /**
+     * @brief The ring buffer.
+     */
+    std::unique_ptr<cell_t[]> buffer;
+
+    /**
+     * @brief Capacity minus one, used to wrap positions into the buffer.
+     */
+    std::size_t mask;
+
+    /**
+     * @brief Next position to push to, kept on its own cache line to avoid false sharing with consumers.
+     */
+    alignas(cache_line) std::atomic<std::size_t> enqueue_pos{ 0 };
+
+    /**
+     * @brief Next position to pop from.
+     */
+    alignas(cache_line) std::atomic<std::size_t> dequeue_pos{ 0 };
+};
@@ -0,0 +1,99 @@
+#include <stdexcept>
+#include <string>
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+MappedFile::MappedFile(const char* filename)
+{
+	HANDLE file{ CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr) };
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Could not open " + std::string{ filename });
+	}
+	file_handle = file;
+
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Could not read the size of " + std::string{ filename });
+	}
+	length = static_cast<std::size_t>(file_size.QuadPart);
+	if (length == 0) return;
+
+	HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+	if (!mapping)
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Could not map " + std::string{ filename });
+	}
+	mapping_handle = mapping;
+
+	bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!bytes)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error("Could not map " + std::string{ filename });
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping_handle) CloseHandle(mapping_handle);
+	if (file_handle) CloseHandle(file_handle);
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char* filename)
+{
+	file_descriptor = open(filename, O_RDONLY);
+	if (file_descriptor < 0)
+	{
+		throw std::runtime_error("Could not open " + std::string{ filename });
+	}
+
+	struct stat file_stat {};
+	if (fstat(file_descriptor, &file_stat) != 0)
+	{
+		close(file_descriptor);
+		throw std::runtime_error("Could not read the size of " + std::string{ filename });
+	}
+	length = static_cast<std::size_t>(file_stat.st_size);
+	if (length == 0) return;
+
+	void* view{ mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file_descriptor, 0) };
+	if (view == MAP_FAILED)
+	{
+		close(file_descriptor);
+		throw std::runtime_error("Could not map " + std::string{ filename });
+	}
+	bytes = static_cast<const unsigned char*>(view);
+}
+
+MappedFile::~MappedFile()
+{
+	if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+	if (file_descriptor >= 0) close(file_descriptor);
+}
+#endif
+
+const unsigned char* MappedFile::data() const
+{
+	return bytes;
+}
+
+std::size_t MappedFile::size() const
+{
+	return length;
+}
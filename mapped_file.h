@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The operating system pages the file in on demand as the mapped bytes are touched
+ * and may drop clean pages again under memory pressure, so very large files can be
+ * read without holding them in process memory.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Maps a file into memory.
+     * @param filename The path of the file to map.
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const char* filename);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Returns the first byte of the mapping (nullptr for an empty file).
+     */
+    const unsigned char* data() const;
+
+    /**
+     * @brief Returns the size of the mapping in bytes.
+     */
+    std::size_t size() const;
+
+private:
+    const unsigned char* bytes{ nullptr };  ///< Start of the mapped view.
+    std::size_t length{ 0 };                ///< Size of the mapped view in bytes.
+#ifdef _WIN32
+    void* file_handle{ nullptr };           ///< Handle of the open file.
+    void* mapping_handle{ nullptr };        ///< Handle of the file mapping object.
+#else
+    int file_descriptor{ -1 };              ///< Descriptor of the open file.
+#endif
+};
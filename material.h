@@ -4,6 +4,7 @@
 #include "tuple.h"
 
 class Geometry;
+struct surface_differentials_t;
 
 /**
  * @class Material
@@ -53,6 +54,34 @@ public:
         const double intensity
     ) const = 0;
 
+    /**
+     * @brief Calculates the color of the material, given the footprint of the pixel on the surface.
+     *
+     * Materials that filter their textures over the footprint override this. The default
+     * ignores the footprint.
+     *
+     * @param light The light source affecting the material.
+     * @param geo Pointer to the geometry object the material is applied to.
+     * @param position The point on the surface where the lighting calculation is performed.
+     * @param eye_vector The direction from the surface point toward the eye (camera/viewer).
+     * @param normal_vector The surface normal at the point of intersection.
+     * @param intensity Light intensity at point.
+     * @param differentials The footprint of the pixel, may be invalid.
+     * @return colour_t The final color resulting from the lighting model applied at the given point.
+     */
+    virtual colour_t lighting
+    (
+        Light& light,
+        const Geometry* geo,
+        const tuple_t& position,
+        const tuple_t& eye_vector,
+        const tuple_t& normal_vector,
+        const double intensity,
+        const surface_differentials_t& /* differentials */
+    ) const
+    {
+        return lighting(light, geo, position, eye_vector, normal_vector, intensity);
+    }
 
     /**
      * @brief Compares this material with another for equality.
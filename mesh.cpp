@@ -1,67 +1,94 @@
+#include "asset_registry.h"
 #include "mesh.h"
 #include "triangle.h"
 #include "phong.h"
 #include "bvh.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Number of triangles created per parallel task when building a mesh.
+ */
+static constexpr std::size_t MESH_BUILD_GRAIN{ 4096 };
 
 Mesh::Mesh() = default;
 
 
-Mesh::Mesh(const wavefront_t& obj, bool smooth)
-	: smooth{ smooth }
+/**
+ * @brief Builds the vertex buffer of a mesh asset, compressing it before it is shared read-only.
+ */
+static std::shared_ptr<const vertex_buffer_t> build_vertex_buffer(const wavefront_t& obj, bool smooth, double weld_epsilon, bool compress)
 {
-	for (const auto& face : obj.faces)
+	auto vertex_buffer{ std::make_shared<vertex_buffer_t>(obj, smooth, weld_epsilon) };
+	if (compress)
 	{
-		std::shared_ptr<Triangle> tri{ Triangle::create(
-					obj.vertices.at(face.a - 1),
-					obj.vertices.at(face.b - 1),
-					obj.vertices.at(face.c - 1)
-				) };
-		if (face.has_uvs())
-		{
-			tri->v1_uv = obj.uvs.at(face.a_uv.value() - 1);
-			tri->v2_uv = obj.uvs.at(face.b_uv.value() - 1);
-			tri->v3_uv = obj.uvs.at(face.c_uv.value() - 1);
-			tri->has_uvs = true;
-		}
-		if (face.has_normals() && smooth)
+		vertex_buffer->compress();
+	}
+	return vertex_buffer;
+}
+
+mesh_asset_t::mesh_asset_t(const wavefront_t& obj, bool smooth, double weld_epsilon, bool compress)
+	: vertex_buffer{ build_vertex_buffer(obj, smooth, weld_epsilon, compress) }, face_attributes(obj.faces.size()), smooth{ smooth }
+{
+	for (std::size_t i{ 0 }; i < obj.faces.size(); i++)
+	{
+		face_attributes[i] = (obj.faces[i].has_uvs() ? 1 : 0) | (obj.faces[i].has_normals() ? 2 : 0);
+	}
+}
+
+std::size_t mesh_asset_t::memory_usage() const
+{
+	return vertex_buffer->memory_usage() + face_attributes.size();
+}
+
+Mesh::Mesh(const wavefront_t& obj, bool smooth, double weld_epsilon, bool compress)
+	: Mesh{ mesh_asset_t{ obj, smooth, weld_epsilon, compress } }
+{
+}
+
+Mesh::Mesh(const mesh_asset_t& asset)
+	: vertex_buffer{ asset.vertex_buffer }, smooth{ asset.smooth }
+{
+	// triangles only reference their face, every attribute is read from the shared,
+	// welded vertex buffer
+	triangles.resize(asset.face_attributes.size());
+	ThreadPool::shared().parallel_for(0, asset.face_attributes.size(), MESH_BUILD_GRAIN, [this, &asset](std::size_t begin, std::size_t end) {
+		for (std::size_t i{ begin }; i < end; i++)
 		{
-			tri->n1 = obj.vertex_normals_avg.at(face.a - 1);
-			tri->n2 = obj.vertex_normals_avg.at(face.b - 1);
-			tri->n3 = obj.vertex_normals_avg.at(face.c - 1);
+			std::shared_ptr<MeshTriangle> tri{ MeshTriangle::create(vertex_buffer, static_cast<std::uint32_t>(i)) };
+			tri->has_uvs = (asset.face_attributes[i] & 1) != 0;
+			tri->has_vertex_normals = (asset.face_attributes[i] & 2) != 0 && smooth;
+			triangles[i] = tri;
 		}
-		triangles.push_back(tri);
-	}
+	});
 	bbox = bounds();
 }
 
-Mesh::Mesh(const char* obj_filename, bool smooth)
-	: Mesh{ wavefront_t{obj_filename}, smooth }
+Mesh::Mesh(const char* obj_filename, bool smooth, double weld_epsilon, bool compress)
+	: Mesh{ *AssetRegistry::global().mesh(obj_filename, { smooth, weld_epsilon, compress }) }
 {
 }
 
-std::shared_ptr<Mesh> Mesh::create(const wavefront_t& obj, bool smooth, int bvh_threshold)
+std::shared_ptr<Mesh> Mesh::create(const wavefront_t& obj, bool smooth, int bvh_threshold, double weld_epsilon, bool compress, bool lazy_bvh)
 {
-	auto mesh{ std::make_shared<Mesh>(obj, smooth) };
-	for (auto& tri : mesh->triangles) {
-		tri->parent = mesh;
-		tri->material = mesh->material;
-	}
-	mesh->create_bvh(bvh_threshold);
-	return mesh;
+	return create(mesh_asset_t{ obj, smooth, weld_epsilon, compress }, bvh_threshold, lazy_bvh);
 }
 
-std::shared_ptr<Mesh> Mesh::create(const char* obj_filename, bool smooth, int bvh_threshold)
+std::shared_ptr<Mesh> Mesh::create(const mesh_asset_t& asset, int bvh_threshold, bool lazy_bvh)
 {
-	auto mesh{ std::make_shared<Mesh>(obj_filename, smooth) };
-	auto phong = std::dynamic_pointer_cast<Phong>(mesh->material);
+	auto mesh{ std::make_shared<Mesh>(asset) };
 	for (auto& tri : mesh->triangles) {
 		tri->parent = mesh;
 		tri->material = mesh->material;
 	}
-	mesh->create_bvh(bvh_threshold);
+	mesh->create_bvh(bvh_threshold, lazy_bvh);
 	return mesh;
 }
 
+std::shared_ptr<Mesh> Mesh::create(const char* obj_filename, bool smooth, int bvh_threshold, double weld_epsilon, bool compress, bool lazy_bvh)
+{
+	return create(*AssetRegistry::global().mesh(obj_filename, { smooth, weld_epsilon, compress }), bvh_threshold, lazy_bvh);
+}
+
 void Mesh::local_intersect(const ray_t& local_ray, intersections_t& intersections) const
 {
 	if (bvh)
@@ -96,12 +123,56 @@ bbox_t Mesh::bounds() const
 	return box;
 }
 
-void Mesh::create_bvh(int threshold) {
+void Mesh::create_bvh(int threshold, bool lazy) {
 	if (triangles.size() <= threshold) return;
 
 	bvh = std::make_unique<bvh_t>();
 	for (const auto& tri : triangles) {
 		bvh->add(tri);
 	}
-	bvh->build(threshold);
+	if (lazy) {
+		bvh->build_lazy(threshold);
+	}
+	else {
+		bvh->build(threshold);
+	}
+}
+
+std::size_t Mesh::memory_usage() const
+{
+	// triangles are allocated together with their control block by make_shared, each
+	// with the heap rows of its transform, and referenced from the mesh and a BVH leaf
+	std::size_t bytes{ sizeof(*this) + triangles.capacity() * sizeof(triangles[0]) };
+	for (const auto& triangle : triangles)
+	{
+		bytes += (dynamic_cast<const MeshTriangle*>(triangle.get()) ? sizeof(MeshTriangle) : sizeof(Triangle)) + 16;
+		bytes += triangle->transform.data.capacity() * sizeof(std::vector<double>);
+		for (const auto& row : triangle->transform.data)
+		{
+			bytes += row.capacity() * sizeof(double);
+		}
+	}
+	if (vertex_buffer)
+	{
+		bytes += vertex_buffer->memory_usage();
+	}
+	if (bvh)
+	{
+		bytes += bvh->memory_usage();
+	}
+	return bytes;
+}
+
+mesh_stats_t Mesh::stats() const
+{
+	mesh_stats_t stats{};
+	stats.triangles = triangles.size();
+	stats.bytes = memory_usage();
+	if (vertex_buffer)
+	{
+		stats.vertices = vertex_buffer->vertex_count();
+		stats.vertex_buffer_bytes = vertex_buffer->memory_usage();
+		stats.compressed = vertex_buffer->compressed;
+	}
+	return stats;
 }
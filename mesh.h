@@ -1,10 +1,69 @@
 #pragma once
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include "geometry.h"
 #include "triangle.h"
+#include "mesh_triangle.h"
 #include "wavefront_obj.h"
+#include "vertex_buffer.h"
 #include "bvh.h"
 
+/**
+ * @struct mesh_asset_t
+ * @brief The loaded data of an OBJ file, shared by every mesh created from it.
+ *
+ * Holds what building a mesh needs from the file without the parsed OBJ itself: the
+ * welded (and optionally compressed) vertex buffer and which faces have UVs and normals.
+ */
+struct mesh_asset_t
+{
+    /** @brief Welded vertices and 32-bit indices, shared with the triangles of every mesh. */
+    std::shared_ptr<const vertex_buffer_t> vertex_buffer;
+
+    /** @brief Per face, bit 0 is set if it has UVs and bit 1 if it has normals. */
+    std::vector<std::uint8_t> face_attributes;
+
+    /** @brief Whether the vertex buffer was built for smooth shading. */
+    bool smooth;
+
+    /**
+     * @brief Builds the mesh data from a parsed OBJ.
+     * @param obj The parsed Wavefront OBJ data.
+     * @param smooth Whether to use smooth shading.
+     * @param weld_epsilon Maximum difference for two vertices to be welded (0 welds exact duplicates only).
+     * @param compress Whether to quantise the vertex buffer (see vertex_buffer_t::compress).
+     */
+    mesh_asset_t(const wavefront_t& obj, bool smooth, double weld_epsilon = 0, bool compress = false);
+
+    /**
+     * @brief Returns the number of bytes held.
+     */
+    std::size_t memory_usage() const;
+};
+
+/**
+ * @struct mesh_stats_t
+ * @brief Size of a mesh and of the memory it holds.
+ */
+struct mesh_stats_t
+{
+    /** @brief Triangles in the mesh. */
+    std::size_t triangles{ 0 };
+
+    /** @brief Welded vertices in the vertex buffer, 0 without one. */
+    std::size_t vertices{ 0 };
+
+    /** @brief Bytes held by the whole mesh, see Mesh::memory_usage. */
+    std::size_t bytes{ 0 };
+
+    /** @brief Bytes held by the vertex buffer alone. */
+    std::size_t vertex_buffer_bytes{ 0 };
+
+    /** @brief Whether the vertex buffer is quantised. */
+    bool compressed{ false };
+};
+
 /**
  * @class Mesh
  * @brief Represents a 3D mesh composed of triangles, typically loaded from a Wavefront OBJ file.
@@ -16,11 +75,19 @@
 class Mesh : public Geometry
 {
 public:
-    /** @brief A collection of triangle primitives making up the mesh geometry. */
-    std::vector<std::shared_ptr<Triangle>> triangles;
+    /**
+     * @brief A collection of triangle primitives making up the mesh geometry.
+     *
+     * Meshes built from OBJ data hold `MeshTriangle`s referencing `vertex_buffer`,
+     * standalone `Triangle`s can also be added.
+     */
+    std::vector<std::shared_ptr<Geometry>> triangles;
 
     std::unique_ptr<bvh_t> bvh;
 
+    /** @brief Welded vertices and 32-bit indices shared by all the triangles of the mesh. */
+    std::shared_ptr<const vertex_buffer_t> vertex_buffer;
+
     /** @brief Whether the mesh should use smooth shading (per-vertex normals). */
     bool smooth{ false };
     
@@ -38,33 +105,62 @@ public:
      * @brief Constructs a mesh from a parsed wavefront OBJ structure.
      * @param obj The parsed Wavefront OBJ data.
      * @param smooth Whether to use smooth shading (default is true).
+     * @param weld_epsilon Maximum difference for two vertices to be welded (0 welds exact duplicates only).
+     * @param compress Whether to quantise the vertex buffer (see vertex_buffer_t::compress).
      */
-    Mesh(const wavefront_t& obj, bool smooth = true);
+    Mesh(const wavefront_t& obj, bool smooth = true, double weld_epsilon = 0, bool compress = false);
 
     /**
-     * @brief Constructs a mesh by loading and parsing an OBJ file.
+     * @brief Constructs a mesh from loaded mesh data, sharing its vertex buffer.
+     * @param asset The mesh data.
+     */
+    explicit Mesh(const mesh_asset_t& asset);
+
+    /**
+     * @brief Constructs a mesh from an OBJ file, loaded through `AssetRegistry::global()`.
      * @param obj_filename The path to the OBJ file.
      * @param smooth Whether to use smooth shading (default is true).
+     * @param weld_epsilon Maximum difference for two vertices to be welded (0 welds exact duplicates only).
+     * @param compress Whether to quantise the vertex buffer (see vertex_buffer_t::compress).
      */
-    Mesh(const char* obj_filename, bool smooth = true);
+    Mesh(const char* obj_filename, bool smooth = true, double weld_epsilon = 0, bool compress = false);
 
     /**
      * @brief Factory method to create a shared pointer to a Mesh from parsed OBJ data.
      * @param obj The parsed Wavefront OBJ data.
      * @param smooth Whether to use smooth shading (default is true).
      * @param bvh_threshold The threshold (number of tris) for creating bounding volume hierarchy
+     * @param weld_epsilon Maximum difference for two vertices to be welded (0 welds exact duplicates only).
+     * @param compress Whether to quantise the vertex buffer (see vertex_buffer_t::compress).
+     * @param lazy_bvh Whether to build the BVH on demand as rays reach it (see bvh_t::build_lazy).
      * @return Shared pointer to the newly created Mesh.
      */
-    static std::shared_ptr<Mesh> create(const wavefront_t& obj, bool smooth = true, int bvh_threshold = 128);
+    static std::shared_ptr<Mesh> create(const wavefront_t& obj, bool smooth = true, int bvh_threshold = 128, double weld_epsilon = 0, bool compress = false, bool lazy_bvh = false);
+
+    /**
+     * @brief Factory method to create a shared pointer to a Mesh from loaded mesh data.
+     * @param asset The mesh data, its vertex buffer is shared.
+     * @param bvh_threshold The threshold (number of tris) for creating bounding volume hierarchy
+     * @param lazy_bvh Whether to build the BVH on demand as rays reach it (see bvh_t::build_lazy).
+     * @return Shared pointer to the newly created Mesh.
+     */
+    static std::shared_ptr<Mesh> create(const mesh_asset_t& asset, int bvh_threshold = 128, bool lazy_bvh = false);
 
     /**
      * @brief Factory method to create a shared pointer to a Mesh from a file.
+     *
+     * The file is loaded once per set of load options through `AssetRegistry::global()`,
+     * meshes of the same file share its vertex buffer. Each mesh has its own triangles
+     * and BVH since those belong to its place in the scene.
      * @param obj_filename The path to the OBJ file.
      * @param smooth Whether to use smooth shading (default is true).
      * @param bvh_threshold The threshold (number of tris) for creating bounding volume hierarchy
+     * @param weld_epsilon Maximum difference for two vertices to be welded (0 welds exact duplicates only).
+     * @param compress Whether to quantise the vertex buffer (see vertex_buffer_t::compress).
+     * @param lazy_bvh Whether to build the BVH on demand as rays reach it (see bvh_t::build_lazy).
      * @return Shared pointer to the newly created Mesh.
      */
-    static std::shared_ptr<Mesh> create(const char* obj_filename, bool smooth = true, int bvh_threshold = 128);
+    static std::shared_ptr<Mesh> create(const char* obj_filename, bool smooth = true, int bvh_threshold = 128, double weld_epsilon = 0, bool compress = false, bool lazy_bvh = false);
 
     /**
      * @brief Computes the intersection(s) between a ray and all triangles in the mesh.
@@ -101,7 +197,20 @@ public:
      * exceeds the given threshold.
      *
      * @param threshold Maximum number of triangles allowed per BVH node before it is split.
+     * @param lazy Whether to defer splitting each node until a ray first enters it.
+     */
+    void create_bvh(int threshold, bool lazy = false);
+
+    /**
+     * @brief Returns the bytes held by the whole mesh: its vertex buffer, triangles and BVH.
+     *
+     * The vertex buffer is counted in full even if it is shared with other meshes.
+     */
+    std::size_t memory_usage() const;
+
+    /**
+     * @brief Returns the triangle and vertex counts and the memory held by the mesh.
      */
-    void create_bvh(int threshold);
+    mesh_stats_t stats() const;
 
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <cmath>
+#include <stdexcept>
+#include "mesh_triangle.h"
+#include "settings.h"
+#include "intersection.h"
+#include "vertex_buffer.h"
+
+MeshTriangle::MeshTriangle(std::shared_ptr<const vertex_buffer_t> vertex_buffer, const std::uint32_t face)
+	: vertex_buffer{ std::move(vertex_buffer) }, face{ face }
+{
+}
+
+std::shared_ptr<MeshTriangle> MeshTriangle::create(std::shared_ptr<const vertex_buffer_t> vertex_buffer, const std::uint32_t face)
+{
+	return std::make_shared<MeshTriangle>(std::move(vertex_buffer), face);
+}
+
+std::uint32_t MeshTriangle::vertex_index(const int vertex) const
+{
+	return vertex_buffer->indices[std::size_t{ face } * 3 + vertex];
+}
+
+tuple_t MeshTriangle::vertex_position(const int vertex) const
+{
+	return vertex_buffer->position(vertex_index(vertex));
+}
+
+std::optional<tuple_t> MeshTriangle::vertex_normal(const int vertex) const
+{
+	if (!has_vertex_normals) return std::nullopt;
+	return vertex_buffer->normal(vertex_index(vertex));
+}
+
+std::pair<double, double> MeshTriangle::vertex_uv(const int vertex) const
+{
+	return vertex_buffer->uv(vertex_index(vertex));
+}
+
+void MeshTriangle::local_intersect(const ray_t& local_ray, intersections_t& intersections) const
+{
+	// same test as Triangle::local_intersect, with the edges derived from the buffer's positions
+	const tuple_t p1{ vertex_position(0) };
+	const tuple_t e1{ vertex_position(1) - p1 };
+	const tuple_t e2{ vertex_position(2) - p1 };
+
+	const tuple_t dir_cross_e2{ tuple_t::cross(local_ray.direction, e2) };
+	const double determinant{ tuple_t::dot(e1, dir_cross_e2) };
+	if (std::abs(determinant) < EPSILON)
+	{
+		return;
+	}
+
+	const double f{ 1.0 / determinant };
+	const tuple_t p1_to_origin{ local_ray.origin - p1 };
+	const double beta{ f * tuple_t::dot(p1_to_origin, dir_cross_e2) };
+	if (beta < 0 || beta > 1)
+	{
+		return;
+	}
+
+	const tuple_t origin_cross_e1{ tuple_t::cross(p1_to_origin, e1) };
+	const double gamma{ f * tuple_t::dot(local_ray.direction, origin_cross_e1) };
+	if (gamma < 0 || (beta + gamma) > 1)
+	{
+		return;
+	}
+
+	const double t{ f * tuple_t::dot(e2, origin_cross_e1) };
+	intersections.add(t, std::static_pointer_cast<const MeshTriangle>(shared_from_this()), 1 - beta - gamma, beta, gamma);
+}
+
+tuple_t MeshTriangle::local_normal_at(const tuple_t& local_point, const double alpha, const double beta, const double gamma) const
+{
+	if (has_vertex_normals)
+	{
+		// compressed buffers decode the normals here, at the point of use
+		return {
+			vertex_buffer->normal(vertex_index(0)) * alpha +
+			vertex_buffer->normal(vertex_index(1)) * beta +
+			vertex_buffer->normal(vertex_index(2)) * gamma
+		};
+	}
+	const tuple_t p1{ vertex_position(0) };
+	tuple_t normal{ tuple_t::cross(vertex_position(2) - p1, vertex_position(1) - p1) };
+	normal.normalize();
+	return normal;
+}
+
+bbox_t MeshTriangle::bounds() const
+{
+	bbox_t box{};
+	box.add(vertex_position(0), vertex_position(1), vertex_position(2));
+	return box;
+}
+
+uv_t MeshTriangle::get_uv(const tuple_t& point) const
+{
+	if (!has_uvs)
+	{
+		throw std::runtime_error("Triangle does not support UV mapping");
+	}
+
+	const tuple_t a{ vertex_position(0) };
+	const tuple_t b{ vertex_position(1) };
+	const tuple_t c{ vertex_position(2) };
+
+	// Barycentric weights from the areas of the sub-triangles opposite each vertex
+	const double area_abc{ tuple_t::cross(b - a, c - a).magnitude() };
+	const double alpha{ tuple_t::cross(c - point, b - point).magnitude() / area_abc };
+	const double beta{ tuple_t::cross(a - point, c - point).magnitude() / area_abc };
+	const double gamma{ 1.0 - alpha - beta };
+
+	const std::pair<double, double> uv1{ vertex_uv(0) };
+	const std::pair<double, double> uv2{ vertex_uv(1) };
+	const std::pair<double, double> uv3{ vertex_uv(2) };
+	return {
+		alpha * uv1.first + beta * uv2.first + gamma * uv3.first,
+		alpha * uv1.second + beta * uv2.second + gamma * uv3.second
+	};
+}
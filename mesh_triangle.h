@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include "geometry.h"
+
+struct intersections_t;
+struct vertex_buffer_t;
+
+/**
+ * @class MeshTriangle
+ * @brief A triangle of a mesh, stored as a reference into the mesh's vertex buffer.
+ *
+ * Unlike `Triangle`, which keeps its own vertices, edges, normals and uvs, a mesh
+ * triangle only holds the shared vertex buffer and the index of its face in it. Every
+ * attribute is fetched (and, for a compressed buffer, decoded) from the buffer when
+ * it is needed, so the triangles of a large mesh add little beyond the buffer itself.
+ */
+class MeshTriangle : public Geometry
+{
+public:
+    /**
+     * @brief Vertex buffer of the owning mesh.
+     *
+     * Shared so the buffer stays alive while an intersection still refers to the
+     * triangle, even if a paged out mesh cluster has already been evicted.
+     */
+    std::shared_ptr<const vertex_buffer_t> vertex_buffer;
+
+    /** @brief Index of the triangle's face, its vertex indices start at `3 * face` in the buffer's index list. */
+    std::uint32_t face;
+
+    /** @brief Whether the normals in `vertex_buffer` are interpolated for smooth shading. */
+    bool has_vertex_normals{ false };
+
+    /**
+     * @brief Constructs the triangle of a face of a vertex buffer.
+     * @param vertex_buffer The buffer holding the face.
+     * @param face The index of the face.
+     */
+    MeshTriangle(std::shared_ptr<const vertex_buffer_t> vertex_buffer, const std::uint32_t face);
+
+    /**
+     * @brief Factory method to create a shared pointer to a MeshTriangle.
+     * @param vertex_buffer The buffer holding the face.
+     * @param face The index of the face.
+     * @return Shared pointer to the newly created MeshTriangle.
+     */
+    static std::shared_ptr<MeshTriangle> create(std::shared_ptr<const vertex_buffer_t> vertex_buffer, const std::uint32_t face);
+
+    /**
+     * @brief Returns the position of one of the triangle's vertices.
+     * @param vertex The vertex index (0, 1 or 2).
+     */
+    tuple_t vertex_position(const int vertex) const;
+
+    /**
+     * @brief Returns the vertex normal at one of the triangle's vertices.
+     * @param vertex The vertex index (0, 1 or 2).
+     * @return The vertex normal, or std::nullopt if the triangle is flat shaded.
+     */
+    std::optional<tuple_t> vertex_normal(const int vertex) const;
+
+    /**
+     * @brief Returns the texture coordinates at one of the triangle's vertices.
+     * @param vertex The vertex index (0, 1 or 2).
+     * @return The uv pair of the vertex.
+     */
+    std::pair<double, double> vertex_uv(const int vertex) const;
+
+    /**
+     * @brief Computes the intersection(s) between a ray and the triangle in local space.
+     * @param local_ray The ray in the object's local space.
+     * @param intersections A container to store the resulting intersection(s), if any.
+     */
+    void local_intersect(const ray_t& local_ray, intersections_t& intersections) const override;
+
+    /**
+     * @brief Computes the surface normal at a point, interpolating the vertex normals for smooth shading.
+     * @param local_point The point on the triangle in local space (unused).
+     * @param alpha Barycentric weight of the first vertex.
+     * @param beta Barycentric weight of the second vertex.
+     * @param gamma Barycentric weight of the third vertex.
+     * @return The normal vector at the given point.
+     */
+    tuple_t local_normal_at(const tuple_t& local_point, const double alpha = 0, const double beta = 0, const double gamma = 0) const override;
+
+    /**
+     * @brief Returns the bounding box of the triangle.
+     *
+     * @return bbox_t The bounding box of the object.
+     */
+    bbox_t bounds() const override;
+
+    /**
+     * @brief Computes the UV coordinates for a point on the triangle's surface.
+     *
+     * Interpolates the vertex uvs with the barycentric weights of the point.
+     *
+     * @param point A point on the triangle in local space.
+     * @return uv_t The corresponding UV coordinates.
+     */
+    uv_t get_uv(const tuple_t& point) const override;
+
+private:
+    /**
+     * @brief Returns the buffer index of one of the triangle's vertices.
+     */
+    std::uint32_t vertex_index(const int vertex) const;
+};
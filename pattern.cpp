@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+#include "intersection_state.h"
 #include "pattern.h"
 
 Pattern::Pattern() {}
@@ -12,6 +15,16 @@ colour_t Pattern::at(const double u, const double v) const
 	return { 0, 0, 0 };
 }
 
+colour_t Pattern::at(const double u, const double v, const double footprint) const
+{
+	return at(u, v);
+}
+
+colour_t Pattern::at(const tuple_t& point, const double width) const
+{
+	return at(point);
+}
+
 bool Pattern::supports_uv() const
 {
 	return false;
@@ -30,4 +43,38 @@ colour_t Pattern::at_object(const Geometry* geo, const tuple_t& point) const
 	{
 		return at(pattern_space_point);
 	}
-}
\ No newline at end of file
+}
+
+colour_t Pattern::at_object(const Geometry* geo, const tuple_t& point, const surface_differentials_t& differentials) const
+{
+	if (!differentials.valid)
+	{
+		return at_object(geo, point);
+	}
+	const tuple_t obj_space_point{ geo->world_to_object(point) };
+	if (supports_uv() && geo->has_uvs)
+	{
+		const uv_t uv{ geo->get_uv(obj_space_point) };
+		return at(uv.u, uv.v, differentials.uv_footprint());
+	}
+	// the footprint in pattern space, scaled by the object and pattern transforms
+	const matrix_t to_pattern{ transform.inverse() };
+	const tuple_t pattern_space_point{ to_pattern * obj_space_point };
+	const tuple_t dx{ to_pattern * geo->world_to_object(point + differentials.dpdx) - pattern_space_point };
+	const tuple_t dy{ to_pattern * geo->world_to_object(point + differentials.dpdy) - pattern_space_point };
+	return at(pattern_space_point, std::max(dx.magnitude(), dy.magnitude()));
+}
+
+double Pattern::odd_fraction(const double x, const double width)
+{
+	if (!(width > 0))
+	{
+		return static_cast<long long>(std::floor(x)) % 2 ? 1.0 : 0.0;
+	}
+	// length of the odd cells in [0, t), an antiderivative of the odd cell indicator
+	const auto odd_length{ [](const double t) {
+		const double pairs{ std::floor(t / 2) };
+		return pairs + std::max(t - 2 * pairs - 1, 0.0);
+	} };
+	return std::clamp((odd_length(x + width / 2) - odd_length(x - width / 2)) / width, 0.0, 1.0);
+}
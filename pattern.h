@@ -4,6 +4,8 @@
 #include "matrix.h"
 #include "geometry.h"
 
+struct surface_differentials_t;
+
 /**
  * @class Pattern
  * @brief Abstract base class representing a color pattern applied to a geometry's surface.
@@ -49,6 +51,19 @@ public:
      */
     virtual colour_t at(const tuple_t& point) const = 0;
 
+    /**
+     * @brief Computes the pattern color averaged over a cube around a point in pattern space.
+     *
+     * Default implementation ignores the width and calls `at(point)`. Patterns with hard
+     * edges override it to blend their colours where an edge crosses the cube, which
+     * removes the aliasing of minified patterns.
+     *
+     * @param point A point in pattern-local coordinates (after transforms).
+     * @param width Edge length of the averaged cube in pattern units, e.g. the size of a pixel.
+     * @return colour_t The averaged color.
+     */
+    virtual colour_t at(const tuple_t& point, const double width) const;
+
     /**
      * @brief Computes the pattern color using 2D UV coordinates.
      *
@@ -60,6 +75,19 @@ public:
      */
     virtual colour_t at(const double u, const double v) const;
 
+    /**
+     * @brief Computes the pattern color using 2D UV coordinates, filtered over a footprint.
+     *
+     * Default implementation ignores the footprint and calls `at(u, v)`. Image textures
+     * override it to average the texels the footprint covers.
+     *
+     * @param u Horizontal texture coordinate, typically in [0, 1].
+     * @param v Vertical texture coordinate, typically in [0, 1].
+     * @param footprint Width of the sampled area in UV units, e.g. the UV size of a pixel.
+     * @return colour_t The color at the specified UV coordinate.
+     */
+    virtual colour_t at(const double u, const double v, const double footprint) const;
+
     /**
      * @brief Indicates whether the pattern supports UV coordinate mapping.
      *
@@ -81,7 +109,32 @@ public:
      */
     virtual colour_t at_object(const Geometry* geo, const tuple_t& point) const;
 
+    /**
+     * @brief Computes the pattern color at a point on a geometry object, filtered over the pixel footprint.
+     *
+     * UV patterns are sampled with the UV footprint of the differentials, other patterns
+     * with the size of the footprint transformed into pattern space. Without valid
+     * differentials this is `at_object(geo, point)`.
+     *
+     * @param geo Pointer to the geometry object the pattern is applied to.
+     * @param point A point in world space.
+     * @param differentials The footprint of the pixel on the surface.
+     * @return colour_t The resulting pattern color at the specified point.
+     */
+    colour_t at_object(const Geometry* geo, const tuple_t& point, const surface_differentials_t& differentials) const;
+
 protected:
+    /**
+     * @brief Returns the fraction of an interval that lies in odd unit cells, floor(x) odd.
+     *
+     * Used by patterns alternating per unit cell to box filter their edges.
+     *
+     * @param x Centre of the interval.
+     * @param width Length of the interval, the cell of x decides if it is not positive.
+     * @return double The fraction in [0, 1].
+     */
+    static double odd_fraction(const double x, const double width);
+
     /**
      * @brief Constructs a pattern with specified primary and secondary colors.
      *
@@ -1,13 +1,74 @@
+#include <algorithm>
+#include <cmath>
+#include "asset_registry.h"
 #include "ppm.h"
 #include "canvas.h"
 #include "pattern_file.h"
+#include "thread_pool.h"
 
+/**
+ * @brief Rows of a mip level averaged per parallel_for task.
+ */
+static constexpr std::size_t MIP_ROW_GRAIN{ 16 };
 
-PatternFile::PatternFile(const char* filepath)
-	: file{filepath}, canvas {canvas_t{ ppm_t{ filepath } }
+/**
+ * @brief Linear blend of two colours, alpha included (colour_t arithmetic clamps alpha sums).
+ */
+static colour_t blend(const colour_t& a, const colour_t& b, const double t)
+{
+	return {
+		a.red + (b.red - a.red) * t,
+		a.green + (b.green - a.green) * t,
+		a.blue + (b.blue - a.blue) * t,
+		a.alpha + (b.alpha - a.alpha) * t
+	};
 }
+
+/**
+ * @brief Averages 2x2 texel blocks of a level into the next, smaller level.
+ *
+ * Odd sizes clamp the blocks to the last row and column of the source.
+ */
+static canvas_t downsample(const canvas_t& source)
 {
+	canvas_t level{ std::max(source.width / 2, 1), std::max(source.height / 2, 1), source.format };
+	ThreadPool::shared().parallel_for(0, level.height, MIP_ROW_GRAIN, [&level, &source](std::size_t begin, std::size_t end) {
+		for (std::size_t row{ begin }; row < end; row++)
+		{
+			const int y{ static_cast<int>(row) };
+			const int y0{ std::min(y * 2, source.height - 1) };
+			const int y1{ std::min(y * 2 + 1, source.height - 1) };
+			for (int x{ 0 }; x < level.width; x++)
+			{
+				const int x0{ std::min(x * 2, source.width - 1) };
+				const int x1{ std::min(x * 2 + 1, source.width - 1) };
+				const colour_t top{ blend(source.pixel_at(x0, y0), source.pixel_at(x1, y0), 0.5) };
+				const colour_t bottom{ blend(source.pixel_at(x0, y1), source.pixel_at(x1, y1), 0.5) };
+				level.write_pixel(x, y, blend(top, bottom, 0.5));
+			}
+		}
+	});
+	return level;
+}
+
+PatternFile::PatternFile(const char* filepath, const Texture_Filter filter, const Texture_Format format)
+	: file{filepath}, levels{ *AssetRegistry::global().texture(filepath, format) }, filter{ filter }
+{
+
+}
 
+std::vector<Texture> PatternFile::load_levels(const char* filepath, const Texture_Format format)
+{
+	// PPM files have no alpha, so the levels are built in 12-byte float texels rather than colour_t
+	std::vector<Texture> levels{};
+	canvas_t level{ read_image(filepath, Canvas_Format::rgb_float) };
+	levels.emplace_back(level, format);
+	while (level.width > 1 || level.height > 1)
+	{
+		level = downsample(level);
+		levels.emplace_back(level, format);
+	}
+	return levels;
 }
 
 bool PatternFile::supports_uv() const
@@ -22,8 +83,46 @@ colour_t PatternFile::at(const tuple_t& point) const
 
 colour_t PatternFile::at(const double u, const double v) const
 {
-	int x = static_cast<int>(u * (canvas.width - 1) + 0.5);
-	int y = static_cast<int>((1 - v) * (canvas.height - 1) + 0.5);
-	return canvas.pixel_at(x, y);
+	if (filter != Texture_Filter::nearest)
+	{
+		return bilinear(levels[0], u, v);
+	}
+	int x = static_cast<int>(u * (levels[0].width - 1) + 0.5);
+	int y = static_cast<int>((1 - v) * (levels[0].height - 1) + 0.5);
+	return levels[0].pixel_at(x, y);
+}
 
-}
\ No newline at end of file
+colour_t PatternFile::at(const double u, const double v, const double footprint) const
+{
+	if (filter == Texture_Filter::nearest || !(footprint > 0))
+	{
+		return at(u, v);
+	}
+	// the level whose texels are as wide as the footprint
+	const double texels{ footprint * std::max(levels[0].width, levels[0].height) };
+	const double lod{ std::clamp(std::log2(std::max(texels, 1.0)), 0.0, static_cast<double>(levels.size() - 1)) };
+	if (filter == Texture_Filter::bilinear)
+	{
+		return bilinear(levels[static_cast<std::size_t>(std::lround(lod))], u, v);
+	}
+	const std::size_t lower{ static_cast<std::size_t>(lod) };
+	const std::size_t upper{ std::min(lower + 1, levels.size() - 1) };
+	const double t{ lod - lower };
+	return blend(bilinear(levels[lower], u, v), bilinear(levels[upper], u, v), t);
+}
+
+colour_t PatternFile::bilinear(const Texture& level, const double u, const double v) const
+{
+	// texel centres span [0, 1] as with the nearest lookup, edges clamp
+	const double fx{ std::clamp(u, 0.0, 1.0) * (level.width - 1) };
+	const double fy{ (1 - std::clamp(v, 0.0, 1.0)) * (level.height - 1) };
+	const int x0{ static_cast<int>(fx) };
+	const int y0{ static_cast<int>(fy) };
+	const int x1{ std::min(x0 + 1, level.width - 1) };
+	const int y1{ std::min(y0 + 1, level.height - 1) };
+	const double tx{ fx - x0 };
+	const double ty{ fy - y0 };
+	const colour_t top{ blend(level.pixel_at(x0, y0), level.pixel_at(x1, y0), tx) };
+	const colour_t bottom{ blend(level.pixel_at(x0, y1), level.pixel_at(x1, y1), tx) };
+	return blend(top, bottom, ty);
+}
@@ -1,14 +1,26 @@
 #pragma once
+#include <vector>
 #include "canvas.h"
 #include "pattern.h"
+#include "texture.h"
+
+/**
+ * @brief How `PatternFile` reconstructs a colour between texels.
+ */
+enum class Texture_Filter
+{
+    nearest,    ///< The nearest texel of the full resolution image.
+    bilinear,   ///< Bilinear blend of the 4 nearest texels of the mip level closest to the footprint.
+    trilinear   ///< Bilinear samples of the two mip levels around the footprint, blended.
+};
 
 /**
  * @class PatternFile
  * @brief A pattern that maps image data from a file onto geometry surfaces using UV coordinates.
  *
  * PatternFile loads an image from disk and samples its pixels based on UV coordinates provided during rendering.
- * It supports full UV-based color lookups and is useful for texture mapping. The image data is stored internally
- * in a canvas, which handles resolution, pixel access, and interpolation if needed.
+ * It supports full UV-based color lookups and is useful for texture mapping. The image and its mip levels are
+ * stored internally as block-tiled textures, optionally compressed.
  */
 class PatternFile : public Pattern
 {
@@ -21,21 +33,33 @@ public:
     const char* file;
 
     /**
-     * @brief The canvas holding the image pixel data.
+     * @brief The mip pyramid, level 0 holds the image.
      *
-     * Internally stores the loaded image and provides color sampling functionality.
+     * Each level halves the size of the previous one (rounding down, at least 1 texel)
+     * and averages its 2x2 texel blocks, down to a single texel. The levels are averaged
+     * at full precision before they are encoded.
+     */
+    std::vector<Texture> levels;
+
+    /**
+     * @brief The filter used by `at(u, v)` and `at(u, v, footprint)`.
      */
-    canvas_t canvas;
+    Texture_Filter filter;
 
     /**
      * @brief Constructs a PatternFile by loading an image from disk.
      *
-     * Loads the image at the specified file path into the internal canvas. The image
+     * Loads the image at the specified file path into the internal textures. The image
      * must be in a supported format (e.g., PPM, PNG, etc. depending on implementation).
      *
+     * The mip levels are loaded through `AssetRegistry::global()`, so patterns of the
+     * same file and format share them, and built in parallel on the shared pool.
+     *
      * @param filepath Path to the image file to load as a texture pattern.
+     * @param filter How texels are filtered, nearest by default.
+     * @param format How the texels are stored, e.g. `Texture_Format::bc1` for large textures.
      */
-    PatternFile(const char* filepath);
+    PatternFile(const char* filepath, const Texture_Filter filter = Texture_Filter::nearest, const Texture_Format format = Texture_Format::rgb_float);
 
     /**
      * @brief Indicates that this pattern supports UV coordinate mapping.
@@ -60,7 +84,7 @@ public:
     /**
      * @brief Computes the color at the given UV coordinates from the loaded image.
      *
-     * Samples the canvas using the UV coordinates, typically in [0, 1] range, to
+     * Samples the texture using the UV coordinates, typically in [0, 1] range, to
      * retrieve the corresponding pixel color.
      *
      * @param u Horizontal UV coordinate.
@@ -68,5 +92,34 @@ public:
      * @return colour_t The color from the image at the specified UV.
      */
     colour_t at(const double u, const double v) const override;
+
+    /**
+     * @brief Computes the filtered color of the image over a footprint around the UV coordinates.
+     *
+     * The footprint selects the mip level whose texels are about as wide as the
+     * footprint, so a minified texture averages the texels it covers instead of
+     * aliasing. The nearest filter ignores the footprint.
+     *
+     * @param u Horizontal UV coordinate.
+     * @param v Vertical UV coordinate.
+     * @param footprint Width of the sampled area in UV units.
+     * @return colour_t The filtered color.
+     */
+    colour_t at(const double u, const double v, const double footprint) const override;
+
+    /**
+     * @brief Loads an image and builds its mip levels, used by the asset registry.
+     *
+     * @param filepath Path to the image file.
+     * @param format How the texels are stored.
+     * @return std::vector<Texture> The mip levels, level 0 is the image.
+     */
+    static std::vector<Texture> load_levels(const char* filepath, const Texture_Format format);
+
+private:
+    /**
+     * @brief Blends the 4 texels of a mip level around the UV coordinates.
+     */
+    colour_t bilinear(const Texture& level, const double u, const double v) const;
 };
 
@@ -1,4 +1,5 @@
 #include <cmath>
+#include "intersection_state.h"
 #include "phong.h"
 #include "settings.h"
 
@@ -11,11 +12,25 @@ colour_t Phong::lighting
 	const tuple_t& normal_vector,
 	const double intensity
 ) const
+{
+	return lighting(light, geo, position, eye_vector, normal_vector, intensity, surface_differentials_t{});
+}
+
+colour_t Phong::lighting
+(
+	Light& light,
+	const Geometry* geo,
+	const tuple_t& position,
+	const tuple_t& eye_vector,
+	const tuple_t& normal_vector,
+	const double intensity,
+	const surface_differentials_t& differentials
+) const
 {
 	colour_t material_coluur{ colour };
 	if (pattern)
 	{
-		material_coluur = pattern->at_object(geo, position);
+		material_coluur = pattern->at_object(geo, position, differentials);
 	}
 	// combine the surface color with the light's color/intensity
 	colour_t effective_colour{ material_coluur * light.intensity };
@@ -128,6 +128,29 @@ public:
         const double intensity
     ) const override;
 
+    /**
+     * @brief Computes the color at a given point, filtering the pattern over the pixel footprint.
+     *
+     * @param light The light source affecting the material.
+     * @param geo Pointer to the geometry this material is applied to.
+     * @param position The point on the surface being illuminated.
+     * @param eye_vector The direction from the point to the viewer.
+     * @param normal_vector The normal vector at the surface point.
+     * @param intensity Light intensity at point.
+     * @param differentials The footprint of the pixel, the pattern is not filtered if invalid.
+     * @return colour_t The resulting color after applying lighting effects.
+     */
+    virtual colour_t lighting
+    (
+        Light& light,
+        const Geometry* geo,
+        const tuple_t& position,
+        const tuple_t& eye_vector,
+        const tuple_t& normal_vector,
+        const double intensity,
+        const surface_differentials_t& differentials
+    ) const override;
+
     /**
      * @brief Checks equality between this Phong material and another Material.
      *
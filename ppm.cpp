@@ -1,9 +1,22 @@
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <stdexcept>
 #include <filesystem>
 #include <vector>
 #include "ppm.h"
+#include "mapped_file.h"
 #include "utils.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Number of rows encoded per parallel task.
+ */
+static constexpr std::size_t PPM_ROW_GRAIN{ 16 };
 
 ppm_t::ppm_t(const canvas_t& canvas, int max_chars)
 {
@@ -11,49 +24,58 @@ ppm_t::ppm_t(const canvas_t& canvas, int max_chars)
 	data += std::to_string(canvas.width) + " " + std::to_string(canvas.height) + "\n";
 	data += "255\n";
 
-	for (int y{ 0 }; y < canvas.height; y++)
-	{
-		std::string line{};
-		for (int x{ 0 }; x < canvas.width; x++)
+	// rows are encoded independently in parallel and then joined in order
+	std::vector<std::string> rows(canvas.height);
+	ThreadPool::shared().parallel_for(0, canvas.height, PPM_ROW_GRAIN, [&canvas, &rows, max_chars](std::size_t begin, std::size_t end) {
+		for (std::size_t y{ begin }; y < end; y++)
 		{
-			const colour_t colour{ canvas.pixel_at(x, y) };
-			std::string rgb_255{ colour.to_rgb_255() };
-			line += rgb_255;
-			if (x != canvas.width - 1)
+			std::string& row{ rows[y] };
+			std::string line{};
+			for (int x{ 0 }; x < canvas.width; x++)
 			{
-				line += " ";
+				const colour_t colour{ canvas.pixel_at(x, static_cast<int>(y)) };
+				std::string rgb_255{ colour.to_rgb_255() };
+				line += rgb_255;
+				if (x != canvas.width - 1)
+				{
+					line += " ";
+				}
 			}
-		}
-		if (line.size() <= max_chars)
-		{
-			data += line + "\n";
-		}
-		else
-		{
-			std::vector<std::string> splitz{ split(line, " ") };
-			std::string line_fixed_size{};
-			for (const auto& value : splitz)
+			if (line.size() <= max_chars)
+			{
+				row += line + "\n";
+			}
+			else
 			{
-				if (line_fixed_size.size() <= (max_chars - 5)) //colour value will be max 3 chars + line termination \n 2 chars so - 5
+				std::vector<std::string> splitz{ split(line, " ") };
+				std::string line_fixed_size{};
+				for (const auto& value : splitz)
 				{
-					line_fixed_size += value + " ";
+					if (line_fixed_size.size() <= (max_chars - 5)) //colour value will be max 3 chars + line termination \n 2 chars so - 5
+					{
+						line_fixed_size += value + " ";
+					}
+					else
+					{
+						line_fixed_size.pop_back(); // remove whitespace
+						row += line_fixed_size + "\n";
+						line_fixed_size.clear();
+						line_fixed_size += value + " ";
+					}
 				}
-				else
+				if (line_fixed_size.size())
 				{
 					line_fixed_size.pop_back(); // remove whitespace
-					data += line_fixed_size + "\n";
-					line_fixed_size.clear();
-					line_fixed_size += value + " ";
+					row += line_fixed_size + "\n";
 				}
 			}
-			if (line_fixed_size.size())
-			{
-				line_fixed_size.pop_back(); // remove whitespace
-				data += line_fixed_size + "\n";
-			}
-			
 		}
-	}
+	});
+
+	std::size_t size{ data.size() + 1 };
+	for (const auto& row : rows) size += row.size();
+	data.reserve(size);
+	for (const auto& row : rows) data += row;
 	data += "\n";
 }
 
@@ -121,4 +143,217 @@ void ppm_t::write_to_file(const char* filepath) const
 	{
 		std::runtime_error("Error while writing PPM file");
 	}
-}
\ No newline at end of file
+}
+
+std::size_t encoded_pixel_size(const Image_Format format)
+{
+	switch (format)
+	{
+	case Image_Format::ppm16: return 6;
+	case Image_Format::pfm: return 3 * sizeof(float);
+	default: return 3;
+	}
+}
+
+std::string encoded_header(const Image_Format format, const int width, const int height)
+{
+	const std::string size{ std::to_string(width) + " " + std::to_string(height) + "\n" };
+	switch (format)
+	{
+	case Image_Format::ppm16: return "P6\n" + size + "65535\n";
+	// a negative scale marks little endian floats
+	case Image_Format::pfm: return "PF\n" + size + (std::endian::native == std::endian::little ? "-1.0\n" : "1.0\n");
+	default: return "P6\n" + size + "255\n";
+	}
+}
+
+void encode_pixel(const Image_Format format, const colour_t& colour, std::uint8_t* out)
+{
+	const double channels[3]{ colour.red, colour.green, colour.blue };
+	switch (format)
+	{
+	case Image_Format::ppm16:
+		for (int i{ 0 }; i < 3; i++)
+		{
+			const int value{ std::clamp(static_cast<int>(std::round(channels[i] * 65535)), 0, 65535) };
+			out[2 * i] = static_cast<std::uint8_t>(value >> 8);
+			out[2 * i + 1] = static_cast<std::uint8_t>(value & 0xff);
+		}
+		break;
+	case Image_Format::pfm:
+	{
+		const float rgb[3]{ static_cast<float>(channels[0]), static_cast<float>(channels[1]), static_cast<float>(channels[2]) };
+		std::memcpy(out, rgb, sizeof(rgb));
+		break;
+	}
+	default:
+		// rounded and clamped as colour_t::to_rgb_255 does
+		for (int i{ 0 }; i < 3; i++)
+		{
+			out[i] = static_cast<std::uint8_t>(std::clamp(static_cast<int>(std::round(channels[i] * 255)), 0, 255));
+		}
+		break;
+	}
+}
+
+std::string encode_image(const canvas_t& canvas, const Image_Format format)
+{
+	const std::string header{ encoded_header(format, canvas.width, canvas.height) };
+	const std::size_t pixel_size{ encoded_pixel_size(format) };
+	const std::size_t row_size{ static_cast<std::size_t>(canvas.width) * pixel_size };
+	std::string data(header.size() + row_size * canvas.height, '\0');
+	std::memcpy(data.data(), header.data(), header.size());
+
+	// every row is encoded straight into its place in the buffer
+	std::uint8_t* pixels{ reinterpret_cast<std::uint8_t*>(data.data() + header.size()) };
+	ThreadPool::shared().parallel_for(0, canvas.height, PPM_ROW_GRAIN, [&canvas, format, pixels, pixel_size, row_size](std::size_t begin, std::size_t end) {
+		for (std::size_t y{ begin }; y < end; y++)
+		{
+			// PFM stores the bottom row first
+			const std::size_t row{ format == Image_Format::pfm ? canvas.height - 1 - y : y };
+			std::uint8_t* out{ pixels + row * row_size };
+			for (int x{ 0 }; x < canvas.width; x++, out += pixel_size)
+			{
+				encode_pixel(format, canvas.pixel_at(x, static_cast<int>(y)), out);
+			}
+		}
+	});
+	return data;
+}
+
+void write_image(const canvas_t& canvas, const std::string& filepath, const Image_Format format)
+{
+	const std::string data{ encode_image(canvas, format) };
+	std::ofstream outfile(filepath, std::ios::binary | std::ios::trunc);
+	if (!outfile)
+	{
+		throw std::runtime_error("Could not create " + filepath);
+	}
+	outfile.write(data.data(), data.size());
+	outfile.close();
+	if (!outfile)
+	{
+		throw std::runtime_error("Error while writing " + filepath);
+	}
+}
+
+/**
+ * @brief Reads PPM header fields and ASCII pixel values from a mapped file.
+ */
+struct ppm_reader_t
+{
+	const unsigned char* position;
+	const unsigned char* end;
+
+	/**
+	 * @brief Skips whitespace and comments (from '#' to the end of the line).
+	 */
+	void skip_space()
+	{
+		while (position < end)
+		{
+			if (*position == '#')
+			{
+				while (position < end && *position != '\n') position++;
+			}
+			else if (std::isspace(*position))
+			{
+				position++;
+			}
+			else
+			{
+				return;
+			}
+		}
+	}
+
+	/**
+	 * @brief Reads the next non-negative decimal number.
+	 */
+	int number()
+	{
+		skip_space();
+		if (position == end || !std::isdigit(*position))
+		{
+			throw std::invalid_argument("PPM file holds an invalid number");
+		}
+		long long value{ 0 };
+		while (position < end && std::isdigit(*position))
+		{
+			value = value * 10 + (*position++ - '0');
+			if (value > std::numeric_limits<int>::max())
+			{
+				throw std::invalid_argument("PPM file holds a number out of range");
+			}
+		}
+		return static_cast<int>(value);
+	}
+};
+
+canvas_t read_image(const char* filepath, const Canvas_Format format)
+{
+	const MappedFile file{ filepath };
+	ppm_reader_t reader{ file.data(), file.data() + file.size() };
+	if (file.size() < 2 || reader.position[0] != 'P' || (reader.position[1] != '3' && reader.position[1] != '6'))
+	{
+		throw std::invalid_argument("PPM file must start with P3 or P6");
+	}
+	const bool binary{ reader.position[1] == '6' };
+	reader.position += 2;
+	const int width{ reader.number() };
+	const int height{ reader.number() };
+	const int max_colour_value{ reader.number() };
+	if (width <= 0 || height <= 0 || max_colour_value <= 0 || max_colour_value > 65535)
+	{
+		throw std::invalid_argument("Invalid width/height/max_color_value");
+	}
+
+	canvas_t canvas{ width, height, format };
+	const double scale{ 1.0 / max_colour_value };
+	if (!binary)
+	{
+		for (int y{ 0 }; y < height; y++)
+		{
+			for (int x{ 0 }; x < width; x++)
+			{
+				const int r{ reader.number() };
+				const int g{ reader.number() };
+				const int b{ reader.number() };
+				canvas.write_pixel(x, y, colour_t{ r * scale, g * scale, b * scale });
+			}
+		}
+		return canvas;
+	}
+
+	// a single whitespace byte separates the header from the pixels
+	if (reader.position == reader.end || !std::isspace(*reader.position))
+	{
+		throw std::invalid_argument("PPM header must end with whitespace");
+	}
+	reader.position++;
+	const std::size_t channel_size{ max_colour_value < 256 ? 1u : 2u };
+	const std::size_t row_size{ static_cast<std::size_t>(width) * 3 * channel_size };
+	if (static_cast<std::size_t>(reader.end - reader.position) < row_size * height)
+	{
+		throw std::runtime_error("PPM file is truncated");
+	}
+	const unsigned char* pixels{ reader.position };
+	ThreadPool::shared().parallel_for(0, height, PPM_ROW_GRAIN, [&canvas, pixels, row_size, channel_size, scale](std::size_t begin, std::size_t end) {
+		for (std::size_t y{ begin }; y < end; y++)
+		{
+			const unsigned char* in{ pixels + y * row_size };
+			for (int x{ 0 }; x < canvas.width; x++)
+			{
+				double channels[3]{};
+				for (double& channel : channels)
+				{
+					// 16-bit samples are big endian
+					channel = (channel_size == 1 ? in[0] : (in[0] << 8 | in[1])) * scale;
+					in += channel_size;
+				}
+				canvas.write_pixel(x, static_cast<int>(y), colour_t{ channels[0], channels[1], channels[2] });
+			}
+		}
+	});
+	return canvas;
+}
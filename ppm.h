@@ -1,9 +1,81 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "canvas.h"
 #include "colour.h"
 
+/**
+ * @brief Binary image file formats written by `write_image` and `StreamingImageWriter`.
+ */
+enum class Image_Format
+{
+    ppm,    ///< Binary PPM (P6), 8 bits per channel, clamped to [0, 1].
+    ppm16,  ///< Binary PPM (P6), 16 bits per channel (big endian), clamped to [0, 1].
+    pfm     ///< Portable float map (PF), 32-bit float RGB in host byte order, unclamped, bottom row first.
+};
+
+/**
+ * @brief Returns the number of bytes a pixel is encoded in.
+ *
+ * @param format The file format.
+ */
+std::size_t encoded_pixel_size(const Image_Format format);
+
+/**
+ * @brief Returns the header of an image file.
+ *
+ * @param format The file format.
+ * @param width Image width in pixels.
+ * @param height Image height in pixels.
+ */
+std::string encoded_header(const Image_Format format, const int width, const int height);
+
+/**
+ * @brief Encodes one pixel.
+ *
+ * @param format The file format.
+ * @param colour The pixel.
+ * @param out Receives `encoded_pixel_size(format)` bytes.
+ */
+void encode_pixel(const Image_Format format, const colour_t& colour, std::uint8_t* out);
+
+/**
+ * @brief Encodes a canvas into a binary image file's contents.
+ *
+ * The buffer is sized once and its rows are encoded in parallel on the shared pool.
+ *
+ * @param canvas The image.
+ * @param format The file format.
+ * @return std::string The header followed by the pixels.
+ */
+std::string encode_image(const canvas_t& canvas, const Image_Format format);
+
+/**
+ * @brief Encodes a canvas and writes it to a file with a single write.
+ *
+ * @param canvas The image.
+ * @param filepath The target file, overwritten if it exists.
+ * @param format The file format.
+ * @throws std::runtime_error If the file cannot be opened or written.
+ */
+void write_image(const canvas_t& canvas, const std::string& filepath, const Image_Format format);
+
+/**
+ * @brief Reads a P3 or P6 (8 or 16-bit) PPM file straight into a canvas.
+ *
+ * The file is memory-mapped and its pixels are decoded from the mapping into the
+ * canvas, without reading it into a string or splitting it into tokens first. The
+ * rows of a binary file are decoded in parallel on the shared pool.
+ *
+ * @param filepath Path to the PPM file.
+ * @param format How the canvas stores its pixels.
+ * @return canvas_t The image, channels scaled to [0, 1].
+ * @throws std::runtime_error If the file cannot be opened or is truncated.
+ * @throws std::invalid_argument If the file is not a valid P3 or P6 PPM.
+ */
+canvas_t read_image(const char* filepath, const Canvas_Format format = Canvas_Format::rgba_double);
+
 /**
  * @struct ppm_t
  * @brief Represents an image encoded in the PPM (Portable Pixmap) format.
@@ -2,6 +2,23 @@
 #include "tuple.h"
 #include "matrix.h"
 
+/**
+ * @struct ray_differentials_t
+ * @brief The rays through the neighbouring pixels, for estimating the footprint of a ray.
+ *
+ * The offset rays follow the main ray through reflections and refractions. Where the
+ * main ray hits a surface, the offset rays hit its tangent plane one pixel to the right
+ * and one pixel down, which gives the area of the surface the pixel covers.
+ */
+struct ray_differentials_t
+{
+	bool valid{ false };		///< Whether the offset rays are set, they are optional.
+	tuple_t dx_origin{};		///< Origin of the ray one pixel to the right.
+	tuple_t dx_direction{};		///< Direction of the ray one pixel to the right.
+	tuple_t dy_origin{};		///< Origin of the ray one pixel down.
+	tuple_t dy_direction{};		///< Direction of the ray one pixel down.
+};
+
 /**
  * @brief Represents a ray in 3D space with an origin and direction.
  *
@@ -34,6 +51,14 @@ struct ray_t
 	 */
 	tuple_t inv_direction{};
 
+	/**
+	 * @brief Optional offset rays, in world space.
+	 *
+	 * Set by cameras with ray differentials enabled and carried to secondary rays by
+	 * `World`. `transform` drops them since intersection tests do not use them.
+	 */
+	ray_differentials_t differentials{};
+
 	/**
 	 * @brief Constructs a ray with a given origin and direction.
 	 *
@@ -1,66 +1,697 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <iostream>
-#include <future>
+#include <memory>
+#include <stdexcept>
+#include <typeinfo>
+#include <utility>
 #include "render_manager.h"
+#include "checkpoint.h"
 #include "settings.h"
+#include "asset_registry.h"
+#include "cluster_cache.h"
 
-RenderManager::RenderManager(const Camera& camera, const int tile_size)
-	: render_camera{ camera }, tile_size{ tile_size }
+/**
+ * @brief Position within the pixel of sample `index`, from the R2 low discrepancy sequence.
+ *
+ * Sample 0 is the pixel centre and successive samples cover the pixel evenly, so any
+ * number of them is close to stratified.
+ */
+static std::pair<double, double> sample_position(const int index)
 {
-	int full_tiles_x{ render_camera.hsize / tile_size };
-	int left_over_x{ render_camera.hsize % tile_size };
-	int full_tiles_y{ render_camera.vsize / tile_size };
-	int left_over_y{ render_camera.vsize % tile_size };
-	int x_max{ left_over_x ? full_tiles_x + 1 : full_tiles_x };
-	int y_max{ left_over_y ? full_tiles_y + 1 : full_tiles_y };
-	render_tiles.reserve(x_max * y_max);
-	for (int y{ 0 }; y < y_max; y++)
+	return {
+		std::fmod(0.5 + index * 0.7548776662466927, 1.0),
+		std::fmod(0.5 + index * 0.5698402909980532, 1.0)
+	};
+}
+
+/**
+ * @brief Divides the colour channels of a sum of samples by the sample count (alpha is not summed).
+ */
+static colour_t average(const colour_t& sum, const int count)
+{
+	return { sum.red / count, sum.green / count, sum.blue / count };
+}
+
+/**
+ * @brief Returns whether any channel of two colours differs by more than the threshold.
+ */
+static bool differs(const colour_t& a, const colour_t& b, const double threshold)
+{
+	return std::fabs(a.red - b.red) > threshold ||
+		std::fabs(a.green - b.green) > threshold ||
+		std::fabs(a.blue - b.blue) > threshold;
+}
+
+/**
+ * @brief Folds bytes into an FNV-1a hash.
+ */
+static void hash_bytes(std::uint64_t& hash, const void* data, const std::size_t size)
+{
+	const unsigned char* bytes{ static_cast<const unsigned char*>(data) };
+	for (std::size_t i{ 0 }; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+}
+
+template<typename T>
+static void hash_value(std::uint64_t& hash, const T& value)
+{
+	hash_bytes(hash, &value, sizeof(T));
+}
+
+static void hash_matrix(std::uint64_t& hash, const matrix_t& matrix)
+{
+	for (const auto& row : matrix.data)
+	{
+		hash_bytes(hash, row.data(), row.size() * sizeof(double));
+	}
+}
+
+/**
+ * @brief Records the objects the calling thread's rays touch into a mask while it lives.
+ *
+ * The thread's previous mask is restored afterwards rather than cleared: a worker can
+ * render a tile while it helps inside a wait of another tile, and the outer tile must
+ * keep recording once the inner one is done.
+ */
+struct touch_recording_t
+{
+	object_mask_t* previous;
+
+	explicit touch_recording_t(object_mask_t* mask)
+		: previous{ World::record_touched(mask) }
+	{
+	}
+
+	~touch_recording_t()
+	{
+		World::record_touched(previous);
+	}
+
+	touch_recording_t(const touch_recording_t&) = delete;
+	touch_recording_t& operator=(const touch_recording_t&) = delete;
+};
+
+/**
+ * @brief Running statistics of the samples of one pixel.
+ */
+struct pixel_samples_t
+{
+	colour_t sum{ 0, 0, 0 };
+	colour_t sum_squares{ 0, 0, 0 };
+	int count{ 0 };
+
+	void add(const colour_t& c)
+	{
+		sum += c;
+		sum_squares += c * c;
+		count++;
+	}
+
+	/**
+	 * @brief Largest per channel standard error of the mean (0 below two samples).
+	 */
+	double standard_error() const
+	{
+		if (count < 2) return 0;
+		const colour_t mean{ average(sum, count) };
+		const colour_t mean_squares{ average(sum_squares, count) };
+		const double variance{ std::max({
+			mean_squares.red - mean.red * mean.red,
+			mean_squares.green - mean.green * mean.green,
+			mean_squares.blue - mean.blue * mean.blue,
+			0.0 }) * count / (count - 1) };
+		return std::sqrt(variance / count);
+	}
+};
+
+RenderManager::RenderManager(const Camera& camera, const int tile_size, const unsigned max_threads, const Task_Priority priority)
+	: render_camera{ camera }, tile_size{ tile_size }, job{ priority, max_threads }
+{
+}
+
+canvas_t RenderManager::render(const World& world)
+{
+	return render_selected(world, {}, checkpoint.path);
+}
+
+canvas_t RenderManager::render_incremental(World& world)
+{
+	const std::size_t grid{ grid_tile_count() };
+	const bool full{ world.needs_full_render() || !frame_reusable || tile_touches.size() != grid };
+	std::vector<bool> selection;
+	if (!full)
 	{
-		int y_start{ y * tile_size };
-		int y_end{ y_start + tile_size };
-		if (left_over_y && y == full_tiles_y) y_end = y_start + left_over_y;
-		y_end = y_end <= render_camera.vsize ? y_end : render_camera.vsize;
-		for (int x{ 0 }; x < x_max; x++)
+		selection.assign(grid, false);
+		for (std::size_t i{ 0 }; i < grid; i++)
 		{
-			int x_start{ x * tile_size };
-			int x_end{ x_start + tile_size };
-			if (left_over_x && x == full_tiles_x) x_end = x_start + left_over_x;
-			x_end = x_end <= render_camera.hsize ? x_end : render_camera.hsize;
-			render_tiles.emplace_back(x_start, x_end, y_start, y_end);
+			selection[i] = tile_touches[i].intersects(world.changed_objects());
 		}
 	}
+	canvas_t image{ render_selected(world, selection, checkpoint.path) };
+	world.clear_changes();
+	return image;
 }
 
-canvas_t RenderManager::render(const World& world)
+canvas_t RenderManager::resume(const World& world, const std::string& path)
 {
-	canvas_t image{ render_camera.hsize, render_camera.vsize };
+	const checkpoint_t saved{ checkpoint_t::load(path) };
+	if (saved.width != render_camera.hsize || saved.height != render_camera.vsize || saved.tile_size != tile_size)
+	{
+		throw std::runtime_error("Checkpoint " + path + " was made with another image or tile size");
+	}
+	if (saved.scene_hash != scene_hash(world))
+	{
+		throw std::runtime_error("Checkpoint " + path + " was made with another scene or render settings");
+	}
+	{
+		canvas_t restored{ saved.width, saved.height, canvas_format };
+		for (int y{ 0 }; y < saved.height; y++)
+		{
+			for (int x{ 0 }; x < saved.width; x++)
+			{
+				restored.write_pixel(x, y, saved.pixels[static_cast<std::size_t>(y) * saved.width + x]);
+			}
+		}
+		std::lock_guard<std::mutex> lk{ snapshot_mutex };
+		snapshot_image = restored;
+	}
+	// restored tiles have no record of the objects they touched
+	tile_touches.assign(grid_tile_count(), {});
+	std::vector<bool> selection(saved.done.size(), false);
+	for (std::size_t i{ 0 }; i < selection.size(); i++)
+	{
+		selection[i] = !saved.done[i];
+	}
+	canvas_t image{ render_selected(world, selection, path) };
+	frame_reusable = false;
+	return image;
+}
+
+canvas_t RenderManager::render_selected(const World& world, const std::vector<bool>& selection, const std::string& checkpoint_path)
+{
+	canvas_t image{ render_camera.hsize, render_camera.vsize, canvas_format };
+	const std::size_t grid{ grid_tile_count() };
+	if (selection.empty())
+	{
+		tile_touches.assign(grid, {});
+	}
+	else
+	{
+		// tiles that are not selected keep the previous frame
+		std::lock_guard<std::mutex> lk{ snapshot_mutex };
+		if (snapshot_image.width == image.width && snapshot_image.height == image.height && snapshot_image.format == image.format)
+		{
+			image = snapshot_image.copy();
+		}
+		for (std::size_t i{ 0 }; i < grid; i++)
+		{
+			if (selection[i]) tile_touches[i] = {};
+		}
+	}
+	const std::vector<double> previous_costs{ cost_hints };
 	auto start = std::chrono::high_resolution_clock::now();
 
-	std::vector<std::future<void>> futures;
+	// tiles that are not selected are final already
+	std::unique_ptr<CheckpointWriter> writer;
+	if (!checkpoint_path.empty())
+	{
+		std::vector<bool> done(selection.size());
+		for (std::size_t i{ 0 }; i < selection.size(); i++)
+		{
+			done[i] = !selection[i];
+		}
+		writer = std::make_unique<CheckpointWriter>(checkpoint_path, checkpoint.interval, scene_hash(world), image, tile_size, done);
+	}
 
-	for (auto& tile : render_tiles)
+	if (antialiasing.max_samples > 1)
+	{
+		render_antialiased(world, image, selection, writer.get());
+	}
+	else
 	{
-		std::packaged_task<void()> task{ [this, &tile, &world, &image]() {
+		const camera_basis_t view{ render_camera.basis() };
+		render_tiles([&world, &image, &writer, &view](const render_tile_t& tile) {
+			// generate the tile's primary rays in one batch, then trace them
+			ray_batch_t rays;
+			view.generate(tile.x_start, tile.x_end, tile.y_start, tile.y_end, rays);
+			std::size_t i{ 0 };
 			for (int y{ tile.y_start }; y < tile.y_end; y++)
 			{
-				for (int x{ tile.x_start }; x < tile.x_end; x++)
+				for (int x{ tile.x_start }; x < tile.x_end; x++, i++)
 				{
-						const ray_t ray{ render_camera.ray_for_pixel(x, y) };
-						const colour_t colour{ world.colour_at(ray, MAX_REFLECTION_DEPTH) };
-						image.write_pixel(x, y, colour);
+					const colour_t colour{ world.colour_at(view.with_differentials(rays.ray(i)), MAX_REFLECTION_DEPTH) };
+					image.write_pixel(x, y, colour);
 				}
 			}
-		} };
-		futures.push_back(task.get_future());
-		thread_pool.submit(std::move(task));
+			if (writer) writer->tile_finished(tile);
+		}, []() { return false; }, cost_hints, selection);
+		average_samples = 1;
 	}
-	for (auto& future : futures)
+	if (writer)
 	{
-		future.get();
+		writer->finish();
 	}
+	// skipped tiles keep their cost from the frame they were rendered in
+	if (!selection.empty() && previous_costs.size() == cost_hints.size())
+	{
+		for (std::size_t i{ 0 }; i < grid; i++)
+		{
+			if (!selection[i]) cost_hints[i] = previous_costs[i];
+		}
+	}
+
 	auto end = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<double> duration = end - start;
 
+	rendered_tiles = selection.empty() ? grid : static_cast<std::size_t>(std::count(selection.begin(), selection.end(), true));
+	std::cout << "Render time: " << duration.count() << " seconds\n";
+	if (!selection.empty())
+	{
+		std::cout << "Re-rendered " << rendered_tiles << " of " << grid << " tiles\n";
+	}
+	if (antialiasing.max_samples > 1)
+	{
+		std::cout << "Samples per pixel: " << average_samples << "\n";
+	}
+	if (report_stats && ClusterCache::global().stats().misses > 0)
+	{
+		ClusterCache::global().report(std::cout);
+	}
+	if (report_stats && AssetRegistry::global().stats().requests > 0)
+	{
+		AssetRegistry::global().report(std::cout);
+	}
+	publish(image);
+	frame_reusable = true;
+	return image;
+}
+
+void RenderManager::render_to(const World& world, TileSink& sink)
+{
+	frame_reusable = false;
+	tile_touches.assign(grid_tile_count(), {});
+	const camera_basis_t view{ render_camera.basis() };
+	const int batch{ antialiasing.min_samples };
+	const int max_samples{ antialiasing.max_samples };
+	const double threshold{ antialiasing.threshold };
+	std::atomic<std::size_t> samples{ 0 };
+	auto start = std::chrono::high_resolution_clock::now();
+
+	sink.begin(render_camera.hsize, render_camera.vsize);
+	render_tiles([&](const render_tile_t& tile) {
+		std::vector<colour_t> pixels(tile.area(), colour_t{ 0, 0, 0 });
+		if (max_samples <= 1)
+		{
+			ray_batch_t rays;
+			view.generate(tile.x_start, tile.x_end, tile.y_start, tile.y_end, rays);
+			for (std::size_t i{ 0 }; i < rays.size(); i++)
+			{
+				pixels[i] = world.colour_at(view.with_differentials(rays.ray(i)), MAX_REFLECTION_DEPTH);
+			}
+			samples += pixels.size();
+		}
+		else
+		{
+			std::size_t i{ 0 };
+			std::size_t tile_samples{ 0 };
+			for (int y{ tile.y_start }; y < tile.y_end; y++)
+			{
+				for (int x{ tile.x_start }; x < tile.x_end; x++, i++)
+				{
+					pixel_samples_t pixel{};
+					do
+					{
+						for (int s{ std::min(batch, max_samples - pixel.count) }; s > 0; s--)
+						{
+							const auto [px, py] = sample_position(pixel.count);
+							pixel.add(world.colour_at(view.ray_for_pixel(x, y, px, py), MAX_REFLECTION_DEPTH));
+						}
+					} while (pixel.count < max_samples && pixel.standard_error() > threshold);
+					pixels[i] = average(pixel.sum, pixel.count);
+					tile_samples += pixel.count;
+				}
+			}
+			samples += tile_samples;
+		}
+		sink.write_tile(tile, pixels.data());
+	}, []() { return false; }, cost_hints, {}, true);
+	sink.finish();
+
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end - start;
+	rendered_tiles = grid_tile_count();
+	average_samples = static_cast<double>(samples) / (static_cast<double>(render_camera.hsize) * render_camera.vsize);
 	std::cout << "Render time: " << duration.count() << " seconds\n";
+}
+
+canvas_t RenderManager::render_progressive(const World& world, const progressive_options_t& options)
+{
+	const int width{ render_camera.hsize };
+	const int height{ render_camera.vsize };
+	canvas_t image{ width, height, canvas_format };
+	// a partial or multi-sample frame cannot be patched by render_incremental
+	frame_reusable = false;
+	tile_touches.assign(grid_tile_count(), {});
+	// sum of the samples of each pixel once the coarse passes are over
+	std::vector<colour_t> sums(static_cast<std::size_t>(width) * height, colour_t{ 0, 0, 0 });
+	publish(image);
+
+	int block{ 1 };
+	while (block * 2 <= options.coarse_block_size) block *= 2;
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto elapsed = [&start]() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	const auto stop = [&options, &elapsed]() {
+		return (options.cancel && options.cancel->cancelled()) ||
+			(options.time_budget > 0 && elapsed() > options.time_budget);
+	};
+	const auto cancelled = [&options]() {
+		return options.cancel && options.cancel->cancelled();
+	};
+
+	const camera_basis_t view{ render_camera.basis() };
+	int samples{ 0 };
+	std::vector<double> pass_costs;
+	for (int pass{ 0 }; samples < std::max(options.target_samples, 1); pass++)
+	{
+		bool complete{ false };
+		const int pass_block{ samples == 0 ? block : 1 };
+		if (samples == 0)
+		{
+			// coarse pass: trace the first pixel of every block not traced by a bigger block
+			// and fill the block with it, blocks never overlap so tiles cannot race
+			const int size{ block };
+			const bool first{ pass == 0 };
+			complete = render_tiles([&, size, first](const render_tile_t& tile) {
+				const int y_first{ (tile.y_start + size - 1) / size * size };
+				const int x_first{ (tile.x_start + size - 1) / size * size };
+				for (int y{ y_first }; y < tile.y_end; y += size)
+				{
+					for (int x{ x_first }; x < tile.x_end; x += size)
+					{
+						if (!first && x % (2 * size) == 0 && y % (2 * size) == 0) continue;
+						const colour_t colour{ world.colour_at(view.ray_for_pixel(x, y), MAX_REFLECTION_DEPTH) };
+						sums[static_cast<std::size_t>(y) * width + x] = colour;
+						for (int by{ y }; by < std::min(y + size, height); by++)
+						{
+							for (int bx{ x }; bx < std::min(x + size, width); bx++)
+							{
+								image.write_pixel(bx, by, colour);
+							}
+						}
+					}
+				}
+			}, first ? std::function<bool()>{ cancelled } : std::function<bool()>{ stop }, pass_costs);
+			if (complete && block == 1) samples = 1;
+			if (complete && block > 1) block /= 2;
+		}
+		else
+		{
+			// refinement pass: one more sample per pixel at the next jittered position
+			const std::pair<double, double> position{ sample_position(samples) };
+			const int count{ samples + 1 };
+			complete = render_tiles([&, position, count](const render_tile_t& tile) {
+				for (int y{ tile.y_start }; y < tile.y_end; y++)
+				{
+					for (int x{ tile.x_start }; x < tile.x_end; x++)
+					{
+						colour_t& sum{ sums[static_cast<std::size_t>(y) * width + x] };
+						sum += world.colour_at(view.ray_for_pixel(x, y, position.first, position.second), MAX_REFLECTION_DEPTH);
+						image.write_pixel(x, y, average(sum, count));
+					}
+				}
+			}, stop, pass_costs);
+			if (complete) samples = count;
+		}
+
+		publish(image);
+		if (options.on_pass)
+		{
+			options.on_pass(image, { pass, pass_block, samples, elapsed(), complete });
+		}
+		if (!complete) break;
+	}
 	return image;
-}
\ No newline at end of file
+}
+
+canvas_t RenderManager::snapshot() const
+{
+	std::lock_guard<std::mutex> lk{ snapshot_mutex };
+	if (snapshot_image.width != render_camera.hsize || snapshot_image.height != render_camera.vsize)
+	{
+		return { render_camera.hsize, render_camera.vsize, canvas_format };
+	}
+	return snapshot_image.copy();
+}
+
+bool RenderManager::render_tiles(const std::function<void(const render_tile_t&)>& render_tile, const std::function<bool()>& stop, std::vector<double>& costs, const std::vector<bool>& selection, const bool scanline)
+{
+	// every pool thread plus the waiting caller renders tiles, the scheduler decides
+	// their order and when to split them
+	ThreadPool& pool{ ThreadPool::shared() };
+	unsigned workers{ pool.thread_count() + 1 };
+	if (job.max_concurrency > 0) workers = std::min(workers, job.max_concurrency);
+	const std::vector<double> no_hints{};
+	TileScheduler scheduler{ render_camera.hsize, render_camera.vsize, tile_size, scanline ? Tile_Order::scanline : tile_order, workers, scanline ? no_hints : cost_hints, selection };
+
+	// one pool task per tile, so a task never holds a worker for longer than a tile and
+	// higher priority jobs, or another group's wait() that picks one up, are not stuck
+	// behind the whole render. Splitting a tile leaves more tiles than queued tasks, the
+	// task that split it queues the missing ones (an extra task finds no tile and returns).
+	TaskGroup group{ pool, job };
+	std::atomic_bool stopped{ false };
+	std::atomic<std::size_t> queued{ 0 };
+	std::function<void()> render_next;
+	const auto queue_tasks = [&group, &scheduler, &queued, &render_next]() {
+		while (scheduler.remaining() > queued)
+		{
+			++queued;
+			group.run(render_next);
+		}
+	};
+	render_next = [this, &render_tile, &stop, &scheduler, &stopped, &queued, &queue_tasks]() {
+		render_tile_t tile{};
+		const bool taken{ !stopped && scheduler.next(tile) };
+		--queued;
+		if (!taken) return;
+		if (stop())
+		{
+			stopped = true;
+			return;
+		}
+		queue_tasks();
+		const auto tile_start = std::chrono::steady_clock::now();
+		// record which objects the tile's rays touch, for render_incremental
+		object_mask_t touched;
+		{
+			const touch_recording_t recording{ &touched };
+			render_tile(tile);
+		}
+		const std::chrono::duration<double> tile_time = std::chrono::steady_clock::now() - tile_start;
+		scheduler.complete(tile, tile_time.count());
+		std::lock_guard<std::mutex> lk{ touch_mutex };
+		tile_touches[tile.source].merge(touched);
+	};
+	queue_tasks();
+	group.wait();
+	costs = scheduler.costs();
+	return !stopped;
+}
+
+void RenderManager::render_antialiased(const World& world, canvas_t& image, const std::vector<bool>& selection, CheckpointWriter* writer)
+{
+	const int width{ render_camera.hsize };
+	const int height{ render_camera.vsize };
+	const int batch{ antialiasing.min_samples };
+	const int max_samples{ antialiasing.max_samples };
+	const double threshold{ antialiasing.threshold };
+	std::vector<pixel_samples_t> pixels(static_cast<std::size_t>(width) * height);
+	const auto never = []() { return false; };
+	const camera_basis_t view{ render_camera.basis() };
+	const auto sample = [&world, &view](pixel_samples_t& pixel, const int x, const int y, const int count) {
+		for (int i{ 0 }; i < count; i++)
+		{
+			const auto [px, py] = sample_position(pixel.count);
+			pixel.add(world.colour_at(view.ray_for_pixel(x, y, px, py), MAX_REFLECTION_DEPTH));
+		}
+	};
+
+	// first pass: the base samples of every pixel
+	std::vector<double> base_costs;
+	render_tiles([&](const render_tile_t& tile) {
+		for (int y{ tile.y_start }; y < tile.y_end; y++)
+		{
+			for (int x{ tile.x_start }; x < tile.x_end; x++)
+			{
+				sample(pixels[static_cast<std::size_t>(y) * width + x], x, y, batch);
+			}
+		}
+	}, never, base_costs, selection);
+
+	// the colours of the first pass stay fixed for the neighbour test while the second pass
+	// refines, pixels of tiles that are not re-rendered use their colour in the previous frame
+	std::vector<colour_t> base(pixels.size(), colour_t{ 0, 0, 0 });
+	for (std::size_t i{ 0 }; i < pixels.size(); i++)
+	{
+		base[i] = pixels[i].count > 0 ? average(pixels[i].sum, pixels[i].count) : image.pixel_at(static_cast<int>(i % width), static_cast<int>(i / width));
+	}
+
+	// second pass: refine pixels on edges and pixels whose samples disagree
+	std::vector<double> refine_costs;
+	render_tiles([&](const render_tile_t& tile) {
+		for (int y{ tile.y_start }; y < tile.y_end; y++)
+		{
+			for (int x{ tile.x_start }; x < tile.x_end; x++)
+			{
+				const std::size_t index{ static_cast<std::size_t>(y) * width + x };
+				pixel_samples_t& pixel{ pixels[index] };
+				bool refine{ pixel.standard_error() > threshold ||
+					(x > 0 && differs(base[index], base[index - 1], threshold)) ||
+					(x + 1 < width && differs(base[index], base[index + 1], threshold)) ||
+					(y > 0 && differs(base[index], base[index - width], threshold)) ||
+					(y + 1 < height && differs(base[index], base[index + width], threshold)) };
+				while (refine && pixel.count < max_samples)
+				{
+					sample(pixel, x, y, std::min(batch, max_samples - pixel.count));
+					refine = pixel.standard_error() > threshold;
+				}
+				image.write_pixel(x, y, average(pixel.sum, pixel.count));
+			}
+		}
+		if (writer) writer->tile_finished(tile);
+	}, never, refine_costs, selection);
+
+	std::size_t total{ 0 };
+	std::size_t rendered{ 0 };
+	for (const auto& pixel : pixels)
+	{
+		total += pixel.count;
+		if (pixel.count > 0) rendered++;
+	}
+	average_samples = rendered == 0 ? 0 : static_cast<double>(total) / rendered;
+	cost_hints = base_costs;
+	for (std::size_t i{ 0 }; i < cost_hints.size() && i < refine_costs.size(); i++)
+	{
+		cost_hints[i] += refine_costs[i];
+	}
+}
+
+void RenderManager::publish(const canvas_t& image)
+{
+	const canvas_t copy{ image.copy() };
+	std::lock_guard<std::mutex> lk{ snapshot_mutex };
+	snapshot_image = copy;
+}
+
+void RenderManager::set_camera(const Camera& camera)
+{
+	if (camera.hsize != render_camera.hsize || camera.vsize != render_camera.vsize)
+	{
+		cost_hints.clear();
+	}
+	render_camera = camera;
+	frame_reusable = false;
+}
+
+void RenderManager::set_canvas_format(const Canvas_Format format)
+{
+	canvas_format = format;
+	frame_reusable = false;
+}
+
+void RenderManager::set_tile_order(const Tile_Order order)
+{
+	tile_order = order;
+}
+
+void RenderManager::set_cost_hints(const std::vector<double>& costs)
+{
+	cost_hints = costs;
+}
+
+const std::vector<double>& RenderManager::tile_costs() const
+{
+	return cost_hints;
+}
+
+void RenderManager::set_antialiasing(const antialiasing_options_t& options)
+{
+	if (options.min_samples < 1 || options.min_samples > options.max_samples)
+	{
+		throw std::invalid_argument("Anti-aliasing needs 1 <= min_samples <= max_samples");
+	}
+	antialiasing = options;
+	frame_reusable = false;
+}
+
+std::size_t RenderManager::tiles_rendered() const
+{
+	return rendered_tiles;
+}
+
+std::size_t RenderManager::grid_tile_count() const
+{
+	return TileScheduler::grid_size(render_camera.hsize, render_camera.vsize, tile_size);
+}
+
+double RenderManager::samples_per_pixel() const
+{
+	return average_samples;
+}
+
+void RenderManager::set_checkpoint(const checkpoint_options_t& options)
+{
+	checkpoint = options;
+}
+
+void RenderManager::set_report_stats(bool report)
+{
+	report_stats = report;
+}
+
+std::uint64_t RenderManager::scene_hash(const World& world) const
+{
+	std::uint64_t hash{ 0xcbf29ce484222325ull };
+	hash_value(hash, render_camera.hsize);
+	hash_value(hash, render_camera.vsize);
+	hash_value(hash, render_camera.field_of_view);
+	hash_matrix(hash, render_camera.transform);
+	hash_value(hash, render_camera.ray_differentials);
+	hash_value(hash, tile_size);
+	hash_value(hash, antialiasing.min_samples);
+	hash_value(hash, antialiasing.max_samples);
+	hash_value(hash, antialiasing.threshold);
+	hash_value(hash, MAX_REFLECTION_DEPTH);
+	for (const auto& object : world.scene_objects)
+	{
+		const std::string type{ typeid(*object).name() };
+		hash_bytes(hash, type.data(), type.size());
+		hash_matrix(hash, object->transform);
+	}
+
+	// materials and lights are not hashed directly, a sparse grid of rays samples their effect
+	constexpr int PROBES{ 32 };
+	const camera_basis_t view{ render_camera.basis() };
+	const int columns{ std::min(PROBES, render_camera.hsize) };
+	const int rows{ std::min(PROBES, render_camera.vsize) };
+	for (int i{ 0 }; i < rows; i++)
+	{
+		for (int j{ 0 }; j < columns; j++)
+		{
+			const int x{ static_cast<int>((j + 0.5) * render_camera.hsize / columns) };
+			const int y{ static_cast<int>((i + 0.5) * render_camera.vsize / rows) };
+			const colour_t colour{ world.colour_at(view.ray_for_pixel(x, y), MAX_REFLECTION_DEPTH) };
+			hash_value(hash, static_cast<float>(colour.red));
+			hash_value(hash, static_cast<float>(colour.green));
+			hash_value(hash, static_cast<float>(colour.blue));
+		}
+	}
+	return hash;
+}
@@ -1,32 +1,119 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
 #include <vector>
 #include "canvas.h"
 #include "camera.h"
 #include "world.h"
 #include "thread_pool.h"
+#include "tile_scheduler.h"
+#include "cancellation_token.h"
+#include "tile_sink.h"
 
 /**
- * @struct render_tile_t
- * @brief Represents a rectangular tile region for rendering.
+ * @struct render_progress_t
+ * @brief State of a progressive render after one of its passes.
+ */
+struct render_progress_t
+{
+    int pass;           ///< Index of the pass (0 is the coarsest)
+    int block_size;     ///< Width and height of the pixel blocks sharing one sample (1 once every pixel is traced)
+    int samples;        ///< Samples per pixel of every pixel so far (0 during the coarse passes)
+    double elapsed;     ///< Seconds since the render started
+    bool complete;      ///< Whether the pass finished, false if it was cancelled or ran out of time
+};
+
+/**
+ * @struct progressive_options_t
+ * @brief Controls how far a progressive render refines the image.
+ */
+struct progressive_options_t
+{
+    /** @brief Block size of the first pass, rounded down to a power of two (1 skips the coarse passes). */
+    int coarse_block_size{ 8 };
+
+    /** @brief Samples per pixel after which the render stops. */
+    int target_samples{ 1 };
+
+    /** @brief Wall-clock seconds after which the render stops (0 for no limit). The first pass always finishes. */
+    double time_budget{ 0 };
+
+    /** @brief Token that stops the render when cancelled (optional). */
+    const CancellationToken* cancel{ nullptr };
+
+    /** @brief Called on the rendering thread with the current image after every pass (optional). */
+    std::function<void(const canvas_t&, const render_progress_t&)> on_pass;
+};
+
+/**
+ * @struct antialiasing_options_t
+ * @brief Controls adaptive supersampling in `RenderManager::render`.
  *
- * Each tile defines a subregion of the full image with start and end bounds
- * in both the x (horizontal) and y (vertical) directions. These tiles are used
- * to divide the rendering task into smaller parallel units.
+ * Every pixel gets `min_samples` samples. A pixel whose samples disagree (their
+ * standard error exceeds `threshold` in any channel), or whose colour differs from
+ * a neighbour by more than `threshold`, gets more samples in batches of
+ * `min_samples` until its samples agree or it has `max_samples`.
+ */
+struct antialiasing_options_t
+{
+    /** @brief Samples taken for every pixel (1 takes the pixel centre only). */
+    int min_samples{ 1 };
+
+    /** @brief Most samples a pixel can get (1 disables anti-aliasing). */
+    int max_samples{ 1 };
+
+    /** @brief Largest per channel standard error or neighbour difference a pixel is left alone at. */
+    double threshold{ 0.05 };
+};
+
+/**
+ * @struct checkpoint_options_t
+ * @brief Controls how `RenderManager::render` saves its progress.
  */
-struct render_tile_t
+struct checkpoint_options_t
 {
-    int x_start; ///< Starting x-coordinate (inclusive)
-    int x_end;   ///< Ending x-coordinate (exclusive)
-    int y_start; ///< Starting y-coordinate (inclusive)
-    int y_end;   ///< Ending y-coordinate (exclusive)
+    /** @brief Checkpoint file, empty disables checkpointing. */
+    std::string path;
+
+    /** @brief Seconds between checkpoints. */
+    double interval{ 60 };
 };
 
+class CheckpointWriter;
+
 /**
  * @class RenderManager
- * @brief Manages tile-based rendering of a scene using a thread pool.
+ * @brief Manages tile-based rendering of a scene using the shared thread pool.
+ *
+ * The RenderManager splits the camera's output image into rectangular tiles and
+ * renders them in parallel as one job on `ThreadPool::shared()`, so any number of
+ * managers share the same worker threads. It handles task distribution and timing.
  *
- * The RenderManager splits the camera's output image into rectangular tiles and uses
- * a thread pool to render each tile in parallel. It handles task distribution and timing.
+ * Tiles are handed out by a `TileScheduler` in the configured `Tile_Order`. The time
+ * spent on each tile is kept as the cost hint for the next render, so when the same
+ * view is rendered again (e.g. the next frame of an animation) the expensive tiles
+ * start first.
+ *
+ * `render_progressive` produces a usable image within a fraction of the full render
+ * time: it first traces one pixel per block of pixels, halves the block size pass by
+ * pass until every pixel is traced, then adds jittered samples per pixel. It can be
+ * stopped between tiles by a cancellation token or a time budget, and the image of
+ * the last pass is available through a callback or `snapshot`.
+ *
+ * With anti-aliasing enabled `render` supersamples adaptively: every pixel gets a few
+ * samples and only the pixels on edges or with noisy samples get more, so the image
+ * approaches uniform supersampling at a fraction of its cost.
+ *
+ * While rendering, the manager records which of the world's objects the rays of each
+ * tile touched. After edits reported through `World::mark_changed`, `render_incremental`
+ * re-renders only the tiles that touched a changed object and reuses the rest of the
+ * previous frame.
+ *
+ * With checkpointing enabled, a background thread periodically saves the finished
+ * tiles of `render` to a file. After a crash or an interruption `resume` reloads them
+ * and renders only the tiles that were missing.
  */
 class RenderManager
 {
@@ -35,25 +122,228 @@ public:
      * @brief Constructs the RenderManager with a given camera and tile size.
      *
      * @param camera The camera defining the view and resolution.
-     * @param tile_size The width and height of each tile (in pixels).
+     * @param tile_size The width and height of each tile (in pixels), a multiple of 16 keeps
+     *                  threads off each other's canvas cache lines (see canvas_t).
+     * @param max_threads Maximum number of tiles rendered at once, 0 uses the whole pool.
+     * @param priority Priority of the render relative to other jobs on the pool.
      */
-    RenderManager(const Camera& camera, const int tile_size);
+    RenderManager(const Camera& camera, const int tile_size, const unsigned max_threads = 0, const Task_Priority priority = Task_Priority::normal);
 
     /**
      * @brief Renders the entire scene described by the world.
      *
-     * This method divides the image into tiles and dispatches each tile
-     * as a task to the internal thread pool. Returns the completed image.
+     * This method divides the image into tiles and renders them on the shared
+     * thread pool. Returns the completed image.
      *
      * @param world The world (scene) to be rendered.
      * @return canvas_t The rendered image.
      */
     canvas_t render(const World& world);
 
+    /**
+     * @brief Re-renders the tiles affected by the edits reported to the world since the last render.
+     *
+     * Only material edits can be patched in: after a geometry edit, a light edit, a new
+     * object, a progressive render or a settings change the whole image is rendered.
+     * The world's changes are cleared afterwards.
+     *
+     * @param world The world (scene) to be rendered.
+     * @return canvas_t The rendered image.
+     */
+    canvas_t render_incremental(World& world);
+
+    /**
+     * @brief Renders the scene straight into a tile sink, without holding the image.
+     *
+     * Each tile is rendered into a buffer of its own and handed to the sink as soon as
+     * it is finished, so the image never exists in memory as a whole, e.g. to stream a
+     * render larger than memory to a file with a `StreamingImageWriter`. With
+     * anti-aliasing enabled pixels are refined by the spread of their own samples only,
+     * since the neighbour test would need the neighbouring tiles. The result is neither
+     * kept for `snapshot` nor for `render_incremental`. Tiles are rendered in scanline
+     * order whatever the tile order and cost hints, so a sink writing bands of rows only
+     * holds the few bands being rendered.
+     *
+     * @param world The world (scene) to be rendered.
+     * @param sink Receives the finished tiles.
+     */
+    void render_to(const World& world, TileSink& sink);
+
+    /**
+     * @brief Renders the scene progressively, coarse to fine.
+     *
+     * Stops once `options.target_samples` samples per pixel are traced, the time budget
+     * runs out or the token is cancelled, and returns the image of the last pass. The
+     * pixels of an unfinished pass keep their value from the previous pass.
+     *
+     * @param world The world (scene) to be rendered.
+     * @param options How far to refine and how to report progress.
+     * @return canvas_t The rendered image.
+     */
+    canvas_t render_progressive(const World& world, const progressive_options_t& options);
+
+    /**
+     * @brief Returns a copy of the image of the last finished pass of `render_progressive`.
+     *
+     * Can be called from any thread while the render is running; before the first pass
+     * completes the image is black.
+     */
+    canvas_t snapshot() const;
+
+    /**
+     * @brief Replaces the camera, e.g. for the next frame of an animation.
+     *
+     * Tile costs are kept as hints for the next render if the image size is unchanged.
+     *
+     * @param camera The camera defining the view and resolution.
+     */
+    void set_camera(const Camera& camera);
+
+    /**
+     * @brief Sets how the rendered images store their pixels (`rgba_double` by default).
+     *
+     * The compact formats cut the memory of an image, and of the copy kept for
+     * `snapshot` and `render_incremental`, by a factor of 2.7 to 8.
+     *
+     * @param format The storage format.
+     */
+    void set_canvas_format(const Canvas_Format format);
+
+    /**
+     * @brief Sets the order tiles are rendered in (scanline by default).
+     *
+     * @param order The tile order.
+     */
+    void set_tile_order(const Tile_Order order);
+
+    /**
+     * @brief Sets the cost of each tile used to order the next render.
+     *
+     * @param costs One cost per tile in scanline order, hints of any other size are ignored.
+     */
+    void set_cost_hints(const std::vector<double>& costs);
+
+    /**
+     * @brief Returns the time spent on each tile by the last render, in scanline order.
+     */
+    const std::vector<double>& tile_costs() const;
+
+    /**
+     * @brief Sets how `render` supersamples (disabled by default).
+     *
+     * @param options The sample counts and threshold.
+     * @throws std::invalid_argument if min_samples is below 1 or above max_samples.
+     */
+    void set_antialiasing(const antialiasing_options_t& options);
+
+    /**
+     * @brief Returns the average number of samples per pixel of the last `render`.
+     */
+    double samples_per_pixel() const;
+
+    /**
+     * @brief Returns the number of grid tiles the last `render` or `render_incremental` traced.
+     */
+    std::size_t tiles_rendered() const;
+
+    /**
+     * @brief Sets where and how often `render` saves its progress (disabled by default).
+     *
+     * The checkpoint is removed once the render completes.
+     *
+     * @param options The checkpoint file and interval.
+     */
+    void set_checkpoint(const checkpoint_options_t& options);
+
+    /**
+     * @brief Sets whether `render` prints the cluster cache and asset registry reports (off by default).
+     *
+     * @param report Whether to print the reports after each render that used them.
+     */
+    void set_report_stats(bool report);
+
+    /**
+     * @brief Finishes a render from a checkpoint, rendering only the tiles it is missing.
+     *
+     * @param world The world (scene) to be rendered, it must be the one the checkpoint was made with.
+     * @param path The checkpoint file.
+     * @return canvas_t The rendered image.
+     * @throws std::runtime_error if the checkpoint cannot be read or was made with another
+     * scene, camera or render settings.
+     */
+    canvas_t resume(const World& world, const std::string& path);
+
+    /**
+     * @brief Returns a hash of the world, camera and render settings that identifies a checkpoint's scene.
+     *
+     * The hash covers the camera, the tile size, the anti-aliasing settings, the type and
+     * transform of every object and the colours seen by a grid of up to 32x32 primary rays,
+     * which catches most material and lighting edits as well.
+     *
+     * @param world The world (scene).
+     */
+    std::uint64_t scene_hash(const World& world) const;
+
 private:
+    /**
+     * @brief Renders every tile of the image on the shared pool, one task per tile.
+     *
+     * @param render_tile Renders the pixels of one tile.
+     * @param stop Polled before every tile, the remaining tiles are skipped once it returns true.
+     * @param costs Receives the seconds spent on each grid tile.
+     * @param selection Grid tiles to render, all if empty.
+     * @param scanline Hand the tiles out in scanline order, ignoring `tile_order` and the cost hints.
+     * @return true if every tile was rendered.
+     */
+    bool render_tiles(const std::function<void(const render_tile_t&)>& render_tile, const std::function<bool()>& stop, std::vector<double>& costs, const std::vector<bool>& selection = {}, const bool scanline = false);
+
+    /**
+     * @brief Renders the image with adaptive supersampling.
+     *
+     * @param world The world (scene) to be rendered.
+     * @param image Receives the rendered pixels.
+     * @param selection Grid tiles to render, all if empty.
+     * @param writer Told about finished tiles, if checkpointing.
+     */
+    void render_antialiased(const World& world, canvas_t& image, const std::vector<bool>& selection, CheckpointWriter* writer);
+
+    /**
+     * @brief Renders the selected tiles on top of the previous frame, timing and publishing the result.
+     *
+     * @param world The world (scene) to be rendered.
+     * @param selection Grid tiles to render, all if empty.
+     * @param checkpoint_path Checkpoint file to save progress to, none if empty.
+     * @return canvas_t The rendered image.
+     */
+    canvas_t render_selected(const World& world, const std::vector<bool>& selection, const std::string& checkpoint_path);
+
+    /**
+     * @brief Returns the number of tiles in the grid.
+     */
+    std::size_t grid_tile_count() const;
+
+    /**
+     * @brief Replaces the image returned by `snapshot`.
+     *
+     * @param image The image to copy.
+     */
+    void publish(const canvas_t& image);
+
     Camera render_camera;                       ///< The camera used for rendering.
     int tile_size;                              ///< The size of each render tile.
-    std::vector<render_tile_t> render_tiles;    ///< The list of all tiles to render.
-    ThreadPool thread_pool{};                   ///< Internal thread pool used for rendering.
+    Tile_Order tile_order{ Tile_Order::scanline }; ///< Order tiles are handed out in.
+    std::vector<double> cost_hints;             ///< Seconds spent on each tile by the last render.
+    job_options_t job;                          ///< Priority and concurrency limit of the render job.
+    antialiasing_options_t antialiasing{};      ///< Supersampling settings.
+    double average_samples{ 0 };                ///< Samples per pixel of the last render.
+    Canvas_Format canvas_format{ Canvas_Format::rgba_double }; ///< Storage of the rendered images.
+    mutable std::mutex snapshot_mutex;          ///< Guards `snapshot_image`.
+    canvas_t snapshot_image{ 0, 0 };            ///< Image of the last render or finished progressive pass.
+    std::size_t rendered_tiles{ 0 };            ///< Grid tiles traced by the last render.
+    bool frame_reusable{ false };               ///< Whether `snapshot_image` is a frame render_incremental can patch.
+    std::mutex touch_mutex;                     ///< Guards `tile_touches` while tiles render.
+    std::vector<object_mask_t> tile_touches;    ///< Objects the rays of each grid tile touched.
+    checkpoint_options_t checkpoint{};          ///< Where `render` saves its progress.
+    bool report_stats{ false };                 ///< Whether `render` prints the cache and asset reports.
 };
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <memory>
 #include "matrix.h"
 #include "ray.h"
@@ -86,6 +87,8 @@ protected:
 
     /**
      * @brief Global counter for assigning unique IDs to each SceneObject.
+     *
+     * Atomic, as scenes and meshes are built on several threads at once.
      */
-    static inline int sceneobj_id_counter{ 1 };
+    static inline std::atomic<int> sceneobj_id_counter{ 1 };
 };
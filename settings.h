@@ -4,4 +4,6 @@
 inline constexpr const double EPSILON{ 0.0001 };
 //inline constexpr double INF{ std::numeric_limits<double>::infinity() };
 inline constexpr const double PI{ 3.14159265358979323846 };
-inline constexpr const double MAX_REFLECTION_DEPTH{ 4 };
\ No newline at end of file
+inline constexpr const double MAX_REFLECTION_DEPTH{ 4 };
+inline constexpr const int RENDER_TILE_SIZE{ 16 };
+static_assert(RENDER_TILE_SIZE % 16 == 0, "tiles must start on multiples of 16 pixels so threads never share a canvas cache line");
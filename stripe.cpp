@@ -7,4 +7,10 @@ Stripe::Stripe(const colour_t& a, const colour_t& b)
 colour_t Stripe::at(const tuple_t& point) const
 {
 	return ((int)floor(point.x) % 2) ? b : a;
+}
+
+colour_t Stripe::at(const tuple_t& point, const double width) const
+{
+	const double fraction{ odd_fraction(point.x, width) };
+	return a * (1 - fraction) + b * fraction;
 }
\ No newline at end of file
@@ -27,5 +27,16 @@ public:
      * @return colour_t The color at the given point.
      */
     colour_t at(const tuple_t& point) const;
+
+    /**
+     * @brief Evaluates the pattern color averaged over a cube around a point.
+     *
+     * Blends `a` and `b` by how much of the cube's x extent each stripe covers.
+     *
+     * @param point A point in pattern space.
+     * @param width Edge length of the cube in pattern units.
+     * @return colour_t The averaged color.
+     */
+    colour_t at(const tuple_t& point, const double width) const override;
 };
 
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include "tcp_socket.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+using native_socket_t = SOCKET;
+using socket_length_t = int;
+static constexpr int SEND_FLAGS{ 0 };
+
+static void close_native(native_socket_t s)
+{
+	closesocket(s);
+}
+
+/**
+ * @brief Starts Winsock once for the whole process.
+ */
+static void ensure_started()
+{
+	static const bool started{ []() {
+		WSADATA data{};
+		if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+		{
+			throw std::runtime_error("Could not start Winsock");
+		}
+		return true;
+	}() };
+	(void)started;
+}
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using native_socket_t = int;
+using socket_length_t = socklen_t;
+#ifdef MSG_NOSIGNAL
+// a worker dying must not kill the coordinator with SIGPIPE
+static constexpr int SEND_FLAGS{ MSG_NOSIGNAL };
+#else
+static constexpr int SEND_FLAGS{ 0 };
+#endif
+
+static void close_native(native_socket_t s)
+{
+	::close(s);
+}
+
+static void ensure_started()
+{
+}
+#endif
+
+static native_socket_t native(std::intptr_t handle)
+{
+	return static_cast<native_socket_t>(handle);
+}
+
+/**
+ * @brief Turns off Nagle's algorithm, tiles are sent as soon as they are done.
+ */
+static void set_no_delay(native_socket_t s)
+{
+	int on{ 1 };
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+}
+
+TcpSocket::TcpSocket(std::intptr_t handle)
+	: handle{ handle }
+{
+}
+
+TcpSocket::~TcpSocket()
+{
+	close();
+}
+
+TcpSocket::TcpSocket(TcpSocket&& other) noexcept
+	: handle{ std::exchange(other.handle, -1) }
+{
+}
+
+TcpSocket& TcpSocket::operator=(TcpSocket&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		handle = std::exchange(other.handle, -1);
+	}
+	return *this;
+}
+
+TcpSocket TcpSocket::listen(std::uint16_t port)
+{
+	ensure_started();
+	const native_socket_t s{ ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP) };
+	TcpSocket result{ static_cast<std::intptr_t>(s) };
+	if (!result.is_open())
+	{
+		throw std::runtime_error("Could not create a socket");
+	}
+	int on{ 1 };
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	if (::bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(s, SOMAXCONN) != 0)
+	{
+		throw std::runtime_error("Could not listen on port " + std::to_string(port));
+	}
+	return result;
+}
+
+TcpSocket TcpSocket::connect(const std::string& host, std::uint16_t port)
+{
+	ensure_started();
+	addrinfo hints{};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses{ nullptr };
+	if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0 || !addresses)
+	{
+		throw std::runtime_error("Could not resolve " + host);
+	}
+	TcpSocket result{};
+	for (const addrinfo* a{ addresses }; a && !result.is_open(); a = a->ai_next)
+	{
+		const native_socket_t s{ ::socket(a->ai_family, a->ai_socktype, a->ai_protocol) };
+		TcpSocket candidate{ static_cast<std::intptr_t>(s) };
+		if (candidate.is_open() && ::connect(s, a->ai_addr, static_cast<socket_length_t>(a->ai_addrlen)) == 0)
+		{
+			result = std::move(candidate);
+		}
+	}
+	freeaddrinfo(addresses);
+	if (!result.is_open())
+	{
+		throw std::runtime_error("Could not connect to " + host + ":" + std::to_string(port));
+	}
+	set_no_delay(native(result.handle));
+	return result;
+}
+
+TcpSocket TcpSocket::accept() const
+{
+	const native_socket_t s{ ::accept(native(handle), nullptr, nullptr) };
+	TcpSocket result{ static_cast<std::intptr_t>(s) };
+	if (!result.is_open())
+	{
+		throw std::runtime_error("Could not accept a connection");
+	}
+	set_no_delay(s);
+	return result;
+}
+
+std::uint16_t TcpSocket::local_port() const
+{
+	sockaddr_in address{};
+	socket_length_t length{ sizeof(address) };
+	if (getsockname(native(handle), reinterpret_cast<sockaddr*>(&address), &length) != 0)
+	{
+		throw std::runtime_error("Could not read the socket's port");
+	}
+	return ntohs(address.sin_port);
+}
+
+void TcpSocket::send_all(const void* data, std::size_t size) const
+{
+	const char* bytes{ static_cast<const char*>(data) };
+	while (size > 0)
+	{
+		const int chunk{ static_cast<int>(std::min<std::size_t>(size, 1 << 30)) };
+		const auto sent{ ::send(native(handle), bytes, chunk, SEND_FLAGS) };
+		if (sent <= 0)
+		{
+			throw std::runtime_error("Connection lost while sending");
+		}
+		bytes += sent;
+		size -= static_cast<std::size_t>(sent);
+	}
+}
+
+bool TcpSocket::receive_all(void* data, std::size_t size) const
+{
+	char* bytes{ static_cast<char*>(data) };
+	while (size > 0)
+	{
+		const int chunk{ static_cast<int>(std::min<std::size_t>(size, 1 << 30)) };
+		const auto received{ ::recv(native(handle), bytes, chunk, 0) };
+		if (received <= 0)
+		{
+			return false;
+		}
+		bytes += received;
+		size -= static_cast<std::size_t>(received);
+	}
+	return true;
+}
+
+void TcpSocket::set_receive_timeout(double timeout) const
+{
+#ifdef _WIN32
+	const DWORD wait{ static_cast<DWORD>(std::max(std::ceil(timeout * 1000), 1.0)) };
+#else
+	timeval wait{};
+	wait.tv_sec = static_cast<long>(timeout);
+	wait.tv_usec = std::max(static_cast<long>((timeout - std::floor(timeout)) * 1e6), wait.tv_sec > 0 ? 0l : 1l);
+#endif
+	setsockopt(native(handle), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&wait), sizeof(wait));
+}
+
+bool TcpSocket::is_open() const
+{
+	return handle != -1;
+}
+
+void TcpSocket::close()
+{
+	if (is_open())
+	{
+		close_native(native(handle));
+		handle = -1;
+	}
+}
+
+std::vector<std::size_t> TcpSocket::wait_readable(const std::vector<const TcpSocket*>& sockets, double timeout)
+{
+	fd_set readable;
+	FD_ZERO(&readable);
+	native_socket_t highest{ 0 };
+	for (const TcpSocket* s : sockets)
+	{
+		if (!s->is_open()) continue;
+		FD_SET(native(s->handle), &readable);
+		highest = std::max(highest, native(s->handle));
+	}
+	timeval wait{};
+	wait.tv_sec = static_cast<long>(timeout);
+	wait.tv_usec = static_cast<long>((timeout - std::floor(timeout)) * 1e6);
+	std::vector<std::size_t> ready;
+	if (::select(static_cast<int>(highest) + 1, &readable, nullptr, nullptr, &wait) <= 0)
+	{
+		return ready;
+	}
+	for (std::size_t i{ 0 }; i < sockets.size(); i++)
+	{
+		if (sockets[i]->is_open() && FD_ISSET(native(sockets[i]->handle), &readable))
+		{
+			ready.push_back(i);
+		}
+	}
+	return ready;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class TcpSocket
+ * @brief A blocking TCP socket (Winsock on Windows, BSD sockets elsewhere).
+ *
+ * Only what the distributed renderer needs: listening, accepting, connecting, sending
+ * and receiving whole buffers and waiting for any of several sockets to become
+ * readable. The socket is closed on destruction and can be moved but not copied.
+ */
+class TcpSocket
+{
+public:
+    /**
+     * @brief Constructs a closed socket.
+     */
+    TcpSocket() = default;
+
+    /**
+     * @brief Closes the socket.
+     */
+    ~TcpSocket();
+
+    TcpSocket(const TcpSocket&) = delete;
+    TcpSocket& operator=(const TcpSocket&) = delete;
+    TcpSocket(TcpSocket&& other) noexcept;
+    TcpSocket& operator=(TcpSocket&& other) noexcept;
+
+    /**
+     * @brief Opens a socket listening on the loopback interface.
+     *
+     * @param port Port to listen on, 0 lets the system pick a free one (see `local_port`).
+     * @throws std::runtime_error if the socket cannot be bound.
+     */
+    static TcpSocket listen(std::uint16_t port);
+
+    /**
+     * @brief Connects to a listening socket.
+     *
+     * @param host Host name or address, e.g. "127.0.0.1".
+     * @param port Port to connect to.
+     * @throws std::runtime_error if the connection fails.
+     */
+    static TcpSocket connect(const std::string& host, std::uint16_t port);
+
+    /**
+     * @brief Waits for a connection on a listening socket.
+     *
+     * @throws std::runtime_error if accepting fails.
+     */
+    TcpSocket accept() const;
+
+    /**
+     * @brief Returns the port the socket is bound to.
+     */
+    std::uint16_t local_port() const;
+
+    /**
+     * @brief Sends a whole buffer.
+     *
+     * @param data The bytes to send.
+     * @param size Number of bytes.
+     * @throws std::runtime_error if the connection fails.
+     */
+    void send_all(const void* data, std::size_t size) const;
+
+    /**
+     * @brief Receives exactly `size` bytes.
+     *
+     * @param data Buffer for the bytes.
+     * @param size Number of bytes.
+     * @return false if the peer closed the connection, it failed or the receive timeout
+     * expired before all bytes arrived.
+     */
+    bool receive_all(void* data, std::size_t size) const;
+
+    /**
+     * @brief Limits how long a receive waits for data, so a stalled peer cannot block the caller.
+     *
+     * @param timeout Seconds each read of `receive_all` waits at most, after which it fails.
+     */
+    void set_receive_timeout(double timeout) const;
+
+    /**
+     * @brief Returns whether the socket is open.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Closes the socket.
+     */
+    void close();
+
+    /**
+     * @brief Waits until at least one of the sockets can be read from (or accepted on).
+     *
+     * @param sockets The sockets to watch.
+     * @param timeout Seconds to wait at most.
+     * @return The indices of the readable sockets, empty on timeout.
+     */
+    static std::vector<std::size_t> wait_readable(const std::vector<const TcpSocket*>& sockets, double timeout);
+
+private:
+    /**
+     * @brief Wraps an open native socket.
+     */
+    explicit TcpSocket(std::intptr_t handle);
+
+    std::intptr_t handle{ -1 }; ///< Native socket (SOCKET on Windows, a descriptor elsewhere), -1 when closed.
+};
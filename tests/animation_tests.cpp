@@ -0,0 +1,79 @@
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../animation.h"
+#include "../settings.h"
+
+static Camera orbit_camera(int frame)
+{
+	Camera c{ 11, 11, PI / 2 };
+	const double angle{ frame * PI / 8 };
+	c.transform = matrix_t::view_transform(tuple_t::point(5 * std::sin(angle), 0, -5 * std::cos(angle)), tuple_t::point(0, 0, 0), tuple_t::vector(0, 1, 0));
+	return c;
+}
+
+/*
+Scenario: A sequence hands every frame to the sink in order
+  Given a sequence renderer of default_world() orbiting the origin with 2 frames in flight
+  When frames 3 to 8 are rendered
+  Then the sink receives frames 3, 4, 5, 6, 7 and 8 in that order
+	And each frame = render_manager(orbit camera of the frame, 4).render(default_world())
+	And the world was built twice and updated once per frame
+*/
+TEST(animation, should_render_a_sequence_in_frame_order)
+{
+	std::atomic<int> built{ 0 };
+	std::atomic<int> updated{ 0 };
+	sequence_options_t options{};
+	options.tile_size = 4;
+	options.frames_in_flight = 2;
+	SequenceRenderer sequence{
+		[&built]() { built++; return World::default_world(); },
+		orbit_camera,
+		[&updated](World&, int) { updated++; },
+		options
+	};
+
+	std::vector<int> frames;
+	std::vector<colour_t> centres;
+	const sequence_stats_t stats{ sequence.render(3, 6, [&](int frame, const canvas_t& image) {
+		frames.push_back(frame);
+		centres.push_back(image.pixel_at(5, 5));
+	}) };
+	EXPECT_EQ(frames, (std::vector<int>{ 3, 4, 5, 6, 7, 8 }));
+	EXPECT_EQ(stats.frames, 6);
+	EXPECT_EQ(stats.in_flight, 2u);
+	EXPECT_GT(stats.frames_per_hour(), 0);
+	EXPECT_EQ(built, 2);
+	EXPECT_EQ(updated, 6);
+
+	const World w{ World::default_world() };
+	for (std::size_t i{ 0 }; i < frames.size(); i++)
+	{
+		RenderManager rm{ orbit_camera(frames[i]), 4 };
+		EXPECT_EQ(centres[i], rm.render(w).pixel_at(5, 5));
+	}
+
+	// the copies of the world are kept for the next sequence
+	sequence.render(0, 2, [](int, const canvas_t&) {});
+	EXPECT_EQ(built, 2);
+}
+
+/*
+Scenario: An exception thrown by the sink stops the sequence
+  Given a sequence renderer of default_world() orbiting the origin
+  When the sink throws on the second frame
+  Then render throws
+*/
+TEST(animation, should_stop_a_sequence_when_the_sink_throws)
+{
+	sequence_options_t options{};
+	options.tile_size = 4;
+	SequenceRenderer sequence{ []() { return World::default_world(); }, orbit_camera, {}, options };
+	EXPECT_THROW(sequence.render(0, 8, [](int frame, const canvas_t&) {
+		if (frame == 1) throw std::runtime_error("disk full");
+	}), std::runtime_error);
+}
@@ -0,0 +1,116 @@
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "gtest/gtest.h"
+#include "../asset_registry.h"
+#include "../mesh.h"
+#include "../pattern_file.h"
+#include "../ppm.h"
+
+static std::string write_texture(const std::string& name)
+{
+	canvas_t c{ 4, 2 };
+	c.fill(colour_t{ 1, 0.5, 0 });
+	const std::string path{ (std::filesystem::temp_directory_path() / name).string() };
+	write_image(c, path, Image_Format::ppm);
+	return path;
+}
+
+/*
+Scenario: Requests for the same texture share one load
+  Given registry ← asset_registry()
+	And file ← a 4 × 2 PPM file
+  When registry.prefetch_texture(file, rgba8)
+	And a ← registry.texture(file, rgba8)
+	And b ← registry.texture(file written as a path with "." in it, rgba8)
+	And c ← registry.texture(file, bc1)
+  Then a and b are the same asset with 3 mip levels
+	And c is another asset
+	And the registry counts 4 requests, 2 loads and 2 shared
+*/
+TEST(asset_registry, should_load_each_texture_once)
+{
+	AssetRegistry registry{};
+	const std::string path{ write_texture("asset_registry.ppm") };
+	registry.prefetch_texture(path, Texture_Format::rgba8);
+	const auto a{ registry.texture(path, Texture_Format::rgba8) };
+	const std::filesystem::path file{ path };
+	const auto b{ registry.texture((file.parent_path() / "." / file.filename()).string(), Texture_Format::rgba8) };
+	const auto c{ registry.texture(path, Texture_Format::bc1) };
+	EXPECT_EQ(a.get(), b.get());
+	EXPECT_NE(a.get(), c.get());
+	ASSERT_EQ(a->size(), 3);
+	EXPECT_EQ((*a)[0].pixel_at(3, 1), colour_t(1, 128 / 255.0, 0));
+
+	const asset_stats_t stats{ registry.stats() };
+	EXPECT_EQ(stats.requests, 4);
+	EXPECT_EQ(stats.loads, 2);
+	EXPECT_EQ(stats.hits, 2);
+	EXPECT_EQ(stats.failures, 0);
+	EXPECT_EQ(stats.bytes, (*a)[0].memory_size() * 3 + (*c)[0].memory_size() * 3);
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: A failed load is retried by the next request
+  Given registry ← asset_registry()
+  Then registry.texture("missing.ppm", rgb_float) throws twice
+	And the registry counts 2 loads and 2 failures
+  When "missing.ppm" is written as a 4 × 2 PPM file
+  Then registry.texture("missing.ppm", rgb_float) returns 3 mip levels
+	And the registry counts 3 loads and 2 failures
+*/
+TEST(asset_registry, should_retry_failed_loads)
+{
+	AssetRegistry registry{};
+	const std::string path{ (std::filesystem::temp_directory_path() / "asset_registry_missing.ppm").string() };
+	std::filesystem::remove(path);
+	EXPECT_THROW(registry.texture(path, Texture_Format::rgb_float), std::runtime_error);
+	EXPECT_THROW(registry.texture(path, Texture_Format::rgb_float), std::runtime_error);
+	EXPECT_EQ(registry.stats().loads, 2);
+	EXPECT_EQ(registry.stats().failures, 2);
+
+	write_texture("asset_registry_missing.ppm");
+	const auto levels{ registry.texture(path, Texture_Format::rgb_float) };
+	EXPECT_EQ(levels->size(), 3);
+	EXPECT_EQ(registry.stats().loads, 3);
+	EXPECT_EQ(registry.stats().failures, 2);
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: Meshes and patterns of the same file share their data
+  Given file ← an OBJ file with one triangle
+	And texture ← a 4 × 2 PPM file
+  When m1 ← mesh(file) and m2 ← mesh(file)
+	And p1 ← pattern_file(texture) and p2 ← pattern_file(texture)
+  Then m1 and m2 are separate meshes sharing one vertex buffer
+	And p1 and p2 share their texels
+*/
+TEST(asset_registry, should_share_data_between_meshes_and_patterns)
+{
+	const std::string obj_path{ (std::filesystem::temp_directory_path() / "asset_registry.obj").string() };
+	{
+		std::ofstream out{ obj_path };
+		out << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+	}
+	const auto m1{ Mesh::create(obj_path.c_str(), false) };
+	const auto m2{ Mesh::create(obj_path.c_str(), false) };
+	EXPECT_NE(m1.get(), m2.get());
+	EXPECT_NE(m1->triangles[0].get(), m2->triangles[0].get());
+	EXPECT_EQ(m1->vertex_buffer.get(), m2->vertex_buffer.get());
+	EXPECT_EQ(m1->triangles.size(), 1);
+
+	const std::string texture_path{ write_texture("asset_registry_shared.ppm") };
+	const asset_stats_t before{ AssetRegistry::global().stats() };
+	const PatternFile p1{ texture_path.c_str() };
+	const PatternFile p2{ texture_path.c_str(), Texture_Filter::bilinear };
+	const asset_stats_t after{ AssetRegistry::global().stats() };
+	EXPECT_EQ(after.loads - before.loads, 1);
+	EXPECT_EQ(after.hits - before.hits, 1);
+	EXPECT_EQ(p1.levels.size(), p2.levels.size());
+	EXPECT_EQ(p1.at(0, 0), p2.at(0, 0));
+	std::filesystem::remove(obj_path);
+	std::filesystem::remove(texture_path);
+}
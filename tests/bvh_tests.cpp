@@ -1,5 +1,6 @@
 ﻿#include <string>
 #include <vector>
+#include <thread>
 #include "gtest/gtest.h"
 #include "../bvh.h"
 #include "../triangle.h"
@@ -268,3 +269,78 @@ TEST(bvh, should_intersect_triangle_if_ray_hits_bbox_and_triangle)
 
     EXPECT_EQ(intersections.entries.size(), 1);
 }
+
+/*
+Scenario: A lazy BVH is only split once a ray enters it
+  Given a BVH with 10 well-separated triangles
+  And build_lazy is called with threshold 2
+  Then no child BVH nodes should exist
+  When a ray that misses the bounding box is intersected
+  Then no child BVH nodes should exist
+  When a ray that hits the first triangle is intersected
+  Then the BVH should have child nodes
+  And there should be one intersection
+*/
+TEST(bvh, should_split_lazily_on_first_hit)
+{
+    bvh_t bvh;
+    for (int i = 0; i < 10; ++i) {
+        bvh.add(Triangle::create(tuple_t::point(double(i * 2), 0, 0), tuple_t::point(double(i * 2 + 1), 0, 0), tuple_t::point(double(i * 2), 1, 0)));
+    }
+
+    bvh.build_lazy(2);
+    EXPECT_EQ(bvh.bvhs.size(), 0);
+
+    intersections_t misses;
+    bvh.local_intersect({ tuple_t::point(100, 100, -5), tuple_t::vector(0, 0, 1) }, misses);
+    EXPECT_EQ(bvh.bvhs.size(), 0);
+
+    intersections_t hits;
+    bvh.local_intersect({ tuple_t::point(0.25, 0.25, -5), tuple_t::vector(0, 0, 1) }, hits);
+    EXPECT_GT(bvh.bvhs.size(), 0);
+    EXPECT_EQ(hits.entries.size(), 1);
+}
+
+/*
+Scenario: Concurrent rays split a lazy BVH once and find the same hits
+  Given a BVH with 100 well-separated triangles built lazily with threshold 2
+  When 8 threads each intersect a ray with every triangle
+  Then every thread should find 100 intersections
+  And the BVH should hold the same number of nodes as an eagerly built one
+*/
+TEST(bvh, should_split_lazily_from_several_threads)
+{
+    bvh_t lazy;
+    bvh_t eager;
+    for (int i = 0; i < 100; ++i) {
+        const auto tri{ Triangle::create(tuple_t::point(double(i * 2), 0, double(i)), tuple_t::point(double(i * 2 + 1), 0, double(i)), tuple_t::point(double(i * 2), 1, double(i))) };
+        lazy.add(tri);
+        eager.add(tri);
+    }
+    lazy.build_lazy(2);
+    eager.build(2);
+
+    std::vector<std::size_t> counts(8);
+    {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < counts.size(); ++t) {
+            threads.emplace_back([&lazy, &counts, t]() {
+                for (int i = 0; i < 100; ++i) {
+                    intersections_t xs;
+                    lazy.local_intersect({ tuple_t::point(i * 2 + 0.25, 0.25, -5), tuple_t::vector(0, 0, 1) }, xs);
+                    counts[t] += xs.entries.size();
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
+    for (const std::size_t count : counts) {
+        EXPECT_EQ(count, 100);
+    }
+    int lazy_nodes = 0;
+    int eager_nodes = 0;
+    count_groups_recursive(lazy, lazy_nodes);
+    count_groups_recursive(eager, eager_nodes);
+    EXPECT_EQ(lazy_nodes, eager_nodes);
+}
@@ -137,4 +137,79 @@ TEST(camera, should_render_a_world_through_a_camera)
 	c.transform = matrix_t::view_transform(from, to, up);
 	const canvas_t canvas{ c.render(w) };
 	EXPECT_EQ(canvas.pixel_at(5, 5), colour_t(0.38066, 0.47583, 0.2855));
-}
\ No newline at end of file
+}
+/*
+Scenario: A batch of rays matches ray_for_pixel
+  Given c ← camera(201, 101, π/2)
+	And c.transform ← rotation_y(π/4) * translation(0, -2, 5)
+  When c.basis() generates the rays of pixels (10..14, 20..23) into a batch
+  Then the batch holds 12 rays in row order
+	And each ray = c.ray_for_pixel(x, y)
+*/
+TEST(camera, should_generate_a_batch_of_rays_matching_ray_for_pixel)
+{
+	Camera c{ 201, 101, PI / 2 };
+	c.transform = matrix_t::rotation_y(PI / 4) * matrix_t::translation(0, -2, 5);
+	ray_batch_t rays;
+	c.basis().generate(10, 14, 20, 23, rays);
+	ASSERT_EQ(rays.size(), 12);
+	std::size_t i{ 0 };
+	for (int y{ 20 }; y < 23; y++)
+	{
+		for (int x{ 10 }; x < 14; x++, i++)
+		{
+			const ray_t expected{ c.ray_for_pixel(x, y) };
+			EXPECT_EQ(rays.ray(i).origin, expected.origin);
+			EXPECT_EQ(rays.ray(i).direction, expected.direction);
+		}
+	}
+}
+
+/*
+Scenario: Rendering with a camera covers the last row and column
+  Given w ← default_world()
+	And c ← camera(11, 11, π/2) looking at the origin from point(0, 0, -1.2)
+  When image ← c.render(w)
+  Then pixel_at(image, 10, 10) is not black
+	And pixel_at(image, 10, 10) = color_at(w, c.ray_for_pixel(10, 10))
+*/
+TEST(camera, should_render_the_last_row_and_column)
+{
+	const World w{ World::default_world() };
+	Camera c{ 11, 11, PI / 2 };
+	c.transform = matrix_t::view_transform(tuple_t::point(0, 0, -1.2), tuple_t::point(0, 0, 0), tuple_t::vector(0, 1, 0));
+	const canvas_t canvas{ c.render(w) };
+	EXPECT_FALSE(canvas.pixel_at(10, 10) == colour_t(0, 0, 0));
+	EXPECT_EQ(canvas.pixel_at(10, 10), w.colour_at(c.ray_for_pixel(10, 10), MAX_REFLECTION_DEPTH));
+}
+
+/*
+Scenario: A camera with ray differentials adds the rays through the neighbouring pixels
+  Given c ← camera(201, 101, π/2)
+    And c.transform ← rotation_y(π/4) * translation(0, -2, 5)
+    And c.ray_differentials ← true
+  When r ← ray_for_pixel(c, 100, 50)
+  Then r.differentials are valid
+    And r.differentials.dx_direction = ray_for_pixel(c, 101, 50).direction
+    And r.differentials.dy_direction = ray_for_pixel(c, 100, 51).direction
+    And a ray from a batch gets the same differentials
+*/
+TEST(camera, should_add_ray_differentials_to_primary_rays)
+{
+    Camera c{ 201, 101, PI / 2 };
+    c.transform = matrix_t::rotation_y(PI / 4) * matrix_t::translation(0, -2, 5);
+    c.ray_differentials = true;
+    const ray_t r{ c.ray_for_pixel(100, 50) };
+    ASSERT_TRUE(r.differentials.valid);
+    EXPECT_EQ(r.differentials.dx_origin, r.origin);
+    EXPECT_EQ(r.differentials.dx_direction, c.ray_for_pixel(101, 50).direction);
+    EXPECT_EQ(r.differentials.dy_direction, c.ray_for_pixel(100, 51).direction);
+
+    const camera_basis_t view{ c.basis() };
+    ray_batch_t rays{};
+    view.generate(100, 101, 50, 51, rays);
+    const ray_t batched{ view.with_differentials(rays.ray(0)) };
+    EXPECT_EQ(batched.differentials.dx_direction, r.differentials.dx_direction);
+    EXPECT_EQ(batched.differentials.dy_direction, r.differentials.dy_direction);
+    EXPECT_FALSE(Camera(201, 101, PI / 2).ray_for_pixel(100, 50).differentials.valid);
+}
@@ -199,4 +199,63 @@ TEST(canvas, should_respect_scale_setting)
 	const ppm_t ppm{ "..\\..\\tests\\in5.ppm" };
 	canvas_t c{ ppm };
 	EXPECT_EQ(c.pixel_at(0, 1), colour_t(0.75, 0.5, 0.25));
-}
\ No newline at end of file
+}
+/*
+Scenario: Compact canvas formats store fewer bytes per pixel
+  Given c ← canvas(16, 2) in each format
+  Then memory_size(rgba_double) = 1024
+	And memory_size(rgb_float) = 384
+	And memory_size(rgba_half) = 256
+	And memory_size(srgb8) = 128
+*/
+TEST(canvas, should_store_compact_formats_in_fewer_bytes)
+{
+	EXPECT_EQ(canvas_t(16, 2).memory_size(), 1024);
+	EXPECT_EQ(canvas_t(16, 2, Canvas_Format::rgb_float).memory_size(), 384);
+	EXPECT_EQ(canvas_t(16, 2, Canvas_Format::rgba_half).memory_size(), 256);
+	EXPECT_EQ(canvas_t(16, 2, Canvas_Format::srgb8).memory_size(), 128);
+	// rows of the compact formats are padded to whole cache lines
+	EXPECT_EQ(canvas_t(5, 3, Canvas_Format::rgb_float).memory_size(), 3 * 64);
+}
+
+/*
+Scenario: Compact canvas formats round trip colours
+  Given c ← canvas(3, 2) in each compact format
+  When write_pixel(c, 2, 1, color(0.25, 0.5, 0.75))
+  Then pixel_at(c, 2, 1) = color(0.25, 0.5, 0.75)
+	And pixel_at(c, 0, 0) = color(0, 0, 0)
+*/
+TEST(canvas, should_round_trip_colours_in_compact_formats)
+{
+	for (const Canvas_Format format : { Canvas_Format::rgb_float, Canvas_Format::rgba_half, Canvas_Format::srgb8 })
+	{
+		canvas_t c{ 3, 2, format };
+		c.write_pixel(2, 1, colour_t{ 0.25, 0.5, 0.75 });
+		const colour_t colour{ c.pixel_at(2, 1) };
+		// 8-bit sRGB steps are at most 0.009 apart in linear terms around these values
+		EXPECT_NEAR(colour.red, 0.25, 0.005);
+		EXPECT_NEAR(colour.green, 0.5, 0.005);
+		EXPECT_NEAR(colour.blue, 0.75, 0.005);
+		EXPECT_EQ(c.pixel_at(0, 0), colour_t(0, 0, 0));
+	}
+}
+
+/*
+Scenario: Copies share pixels and copy() does not
+  Given c ← canvas(2, 2) in rgb_float
+	And shared ← c
+	And independent ← c.copy()
+  When write_pixel(c, 1, 1, red)
+  Then pixel_at(shared, 1, 1) = red
+	And pixel_at(independent, 1, 1) = color(0, 0, 0)
+*/
+TEST(canvas, should_share_pixels_between_copies_unless_copied)
+{
+	canvas_t c{ 2, 2, Canvas_Format::rgb_float };
+	const canvas_t shared{ c };
+	const canvas_t independent{ c.copy() };
+	const colour_t red{ 1, 0, 0 };
+	c.write_pixel(1, 1, red);
+	EXPECT_EQ(shared.pixel_at(1, 1), red);
+	EXPECT_EQ(independent.pixel_at(1, 1), colour_t(0, 0, 0));
+}
@@ -82,4 +82,25 @@ TEST(checker, should_get_colour_at_uv_pattern)
 	EXPECT_EQ(checker.at(0.0, 0.5), white);
 	EXPECT_EQ(checker.at(0.5, 0.5), black);
 	EXPECT_EQ(checker.at(1.0, 1.0), black);
-}
\ No newline at end of file
+}
+
+/*
+Scenario: Checkers averaged over a footprint
+  Given pattern ← checkers_pattern(white, black)
+  Then checkers_at(pattern, point(0.5, 0.5, 0.5), 0.5) = white
+    And checkers_at(pattern, point(1, 0.5, 0.5), 1) is about color(0.5, 0.5, 0.5)
+    And checkers_at(pattern, point(0.5, 0.5, 0.5), 10) is about color(0.5, 0.5, 0.5)
+    And uv_checkers_at(uv_checkers(2, 2, white, black), 0.5, 0.25, 0.5) = color(0.5, 0.5, 0.5)
+*/
+TEST(checker, should_average_over_a_footprint)
+{
+	const colour_t black{ 0, 0, 0 };
+	const colour_t white{ 1, 1, 1 };
+	const Checker checker{ white, black };
+	EXPECT_EQ(checker.at(tuple_t::point(0.5, 0.5, 0.5), 0.5), white);
+	EXPECT_NEAR(checker.at(tuple_t::point(1, 0.5, 0.5), 1).red, 0.5, 0.01);
+	const colour_t wide{ checker.at(tuple_t::point(0.5, 0.5, 0.5), 10) };
+	EXPECT_NEAR(wide.red, 0.5, 0.01);
+	const Checker uv_checker{ 2, 2, white, black };
+	EXPECT_EQ(uv_checker.at(0.5, 0.25, 0.5), colour_t(0.5, 0.5, 0.5));
+}
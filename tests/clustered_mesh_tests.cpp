@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "gtest/gtest.h"
+#include "../clustered_mesh.h"
+#include "../cluster_cache.h"
+#include "../mesh.h"
+#include "../wavefront_obj.h"
+#include "../intersection.h"
+
+/*
+Scenario: Writing a mesh cache splits the triangles into clusters
+  Given w ← wavefront("..\\..\\tests\\assets\\cube.obj")
+	And cache ← cluster_cache(1 GB)
+  When write_cache(w, "cube_clusters.rtmc", true, 2)
+	And m ← clustered_mesh("cube_clusters.rtmc", 128, cache)
+  Then m.cluster_count() = 8
+	And m.bounds().min = point(-1, -1, -1)
+	And m.bounds().max = point(1, 1, 1)
+	And cache.stats().misses = 0
+*/
+TEST(clustered_mesh, should_write_and_open_a_clustered_cache)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\cube.obj" };
+	ClusterCache cache{ std::size_t{ 1 } << 30 };
+	ClusteredMesh::write_cache(w, "cube_clusters.rtmc", true, 2);
+	const auto m{ ClusteredMesh::create("cube_clusters.rtmc", 128, cache) };
+	EXPECT_EQ(m->cluster_count(), 8);
+	EXPECT_EQ(m->bounds().min, tuple_t::point(-1, -1, -1));
+	EXPECT_EQ(m->bounds().max, tuple_t::point(1, 1, 1));
+	EXPECT_EQ(cache.stats().misses, 0);
+}
+
+/*
+Scenario: Clusters are paged in on demand and intersect like a mesh
+  Given w ← wavefront("..\\..\\tests\\assets\\cube.obj")
+	And cache ← cluster_cache(1 GB)
+	And write_cache(w, "cube_clusters.rtmc", true, 2)
+	And m ← clustered_mesh("cube_clusters.rtmc", 128, cache)
+	And r ← ray(point(0.1, 0.2, -5), vector(0, 0, 1))
+  When xs ← intersect(m, r)
+	And xs2 ← intersect(m, r)
+  Then xs.count = 2
+	And xs[0].t = 4
+	And xs[1].t = 6
+	And cache.stats().misses > 0
+	And cache.stats().hits = cache.stats().misses
+	And cache.stats().evictions = 0
+*/
+TEST(clustered_mesh, should_page_in_clusters_on_first_hit)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\cube.obj" };
+	ClusterCache cache{ std::size_t{ 1 } << 30 };
+	ClusteredMesh::write_cache(w, "cube_clusters.rtmc", true, 2);
+	const auto m{ ClusteredMesh::create("cube_clusters.rtmc", 128, cache) };
+	const ray_t r{ tuple_t::point(0.1, 0.2, -5), tuple_t::vector(0, 0, 1) };
+	intersections_t xs{};
+	m->intersect(r, xs);
+	intersections_t xs2{};
+	m->intersect(r, xs2);
+	ASSERT_EQ(xs.entries.size(), 2);
+	EXPECT_DOUBLE_EQ(xs[0].time, 4);
+	EXPECT_DOUBLE_EQ(xs[1].time, 6);
+	EXPECT_GT(cache.stats().misses, 0);
+	EXPECT_EQ(cache.stats().hits, cache.stats().misses);
+	EXPECT_EQ(cache.stats().evictions, 0);
+}
+
+/*
+Scenario: Exceeding the memory budget evicts the least recently used clusters
+  Given w ← wavefront("..\\..\\tests\\assets\\cube.obj")
+	And cache ← cluster_cache(1 byte)
+	And write_cache(w, "cube_clusters.rtmc", false, 2)
+	And m ← clustered_mesh("cube_clusters.rtmc", 128, cache)
+	And r ← ray(point(0.1, 0.2, -5), vector(0, 0, 1))
+  When xs ← intersect(m, r)
+	And xs2 ← intersect(m, r)
+  Then xs2.count = 2
+	And cache.stats().hits = 0
+	And cache.stats().evictions > 0
+	And xs2[0].object.normal_at(point(0.1, 0.2, -1)) = the normal of the same hit on mesh(w, false)
+*/
+TEST(clustered_mesh, should_evict_clusters_over_budget)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\cube.obj" };
+	ClusterCache cache{ 1 };
+	ClusteredMesh::write_cache(w, "cube_clusters.rtmc", false, 2);
+	const auto m{ ClusteredMesh::create("cube_clusters.rtmc", 128, cache) };
+	const ray_t r{ tuple_t::point(0.1, 0.2, -5), tuple_t::vector(0, 0, 1) };
+	intersections_t xs{};
+	m->intersect(r, xs);
+	intersections_t xs2{};
+	m->intersect(r, xs2);
+	ASSERT_EQ(xs2.entries.size(), 2);
+	EXPECT_EQ(cache.stats().hits, 0);
+	EXPECT_GT(cache.stats().evictions, 0);
+	const auto mesh{ Mesh::create(w, false) };
+	intersections_t expected{};
+	mesh->intersect(r, expected);
+	EXPECT_EQ(xs2[0].object->normal_at(tuple_t::point(0.1, 0.2, -1)), expected[0].object->normal_at(tuple_t::point(0.1, 0.2, -1)));
+}
+
+/*
+Scenario: Opening a file that is not a mesh cache fails
+  Then clustered_mesh("..\\..\\tests\\assets\\cube.obj") throws std::runtime_error
+*/
+TEST(clustered_mesh, should_reject_invalid_cache_files)
+{
+	EXPECT_THROW(ClusteredMesh::create("..\\..\\tests\\assets\\cube.obj"), std::runtime_error);
+}
+
+/*
+Scenario: Paging in a cluster whose triangles reference vertices outside it fails
+  Given w ← wavefront("..\\..\\tests\\assets\\cube.obj")
+	And write_cache(w, "corrupt_clusters.rtmc", true, 2)
+	And the first vertex index of every cluster's first triangle is overwritten with 0xffffffff
+	And m ← clustered_mesh("corrupt_clusters.rtmc", 128, cache)
+  Then intersect(m, ray(point(0.1, 0.2, -5), vector(0, 0, 1))) throws std::runtime_error
+*/
+TEST(clustered_mesh, should_reject_clusters_with_out_of_range_indices)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\cube.obj" };
+	ClusteredMesh::write_cache(w, "corrupt_clusters.rtmc", true, 2);
+	std::string bytes;
+	{
+		std::ifstream in{ "corrupt_clusters.rtmc", std::ios::binary };
+		bytes.assign(std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{});
+	}
+	// 16 byte header, 64 byte cluster records (bounds, offset, vertex and triangle counts), 64 byte vertices
+	std::uint32_t cluster_count{};
+	std::memcpy(&cluster_count, bytes.data() + 8, sizeof(cluster_count));
+	for (std::uint32_t i{ 0 }; i < cluster_count; i++)
+	{
+		std::uint64_t offset{};
+		std::uint32_t vertex_count{};
+		std::memcpy(&offset, bytes.data() + 16 + i * 64 + 48, sizeof(offset));
+		std::memcpy(&vertex_count, bytes.data() + 16 + i * 64 + 56, sizeof(vertex_count));
+		const std::uint32_t bad_index{ 0xffffffff };
+		std::memcpy(bytes.data() + offset + std::size_t{ vertex_count } * 64, &bad_index, sizeof(bad_index));
+	}
+	{
+		std::ofstream out{ "corrupt_clusters.rtmc", std::ios::binary };
+		out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	ClusterCache cache{ std::size_t{ 1 } << 30 };
+	const auto m{ ClusteredMesh::create("corrupt_clusters.rtmc", 128, cache) };
+	intersections_t xs{};
+	EXPECT_THROW(m->intersect({ tuple_t::point(0.1, 0.2, -5), tuple_t::vector(0, 0, 1) }, xs), std::runtime_error);
+}
+
+/*
+Scenario: A cluster loaded by the loser of a race is reported as a wasted load
+  Given cache ← cluster_cache(1 GB)
+	And load_inner ← a loader building an empty cluster
+	And load_outer ← a loader that acquires the same cluster with load_inner before building its own
+  When c ← cache.acquire(owner, 0, load_outer)
+  Then c is the cluster built by load_inner
+	And cache.stats().misses = 2
+	And cache.stats().wasted_loads = 1
+	And cache.stats().bytes_paged_in = the size of one cluster
+*/
+TEST(clustered_mesh, should_count_wasted_cluster_loads_separately)
+{
+	ClusterCache cache{ std::size_t{ 1 } << 30 };
+	const int owner{ 0 };
+	const auto build = []() {
+		auto cluster{ std::make_shared<mesh_cluster_t>() };
+		cluster->vertex_buffer = std::make_shared<vertex_buffer_t>(std::vector<mesh_vertex_t>{}, std::vector<std::uint32_t>{});
+		return std::shared_ptr<const mesh_cluster_t>{ cluster };
+	};
+	std::shared_ptr<const mesh_cluster_t> inner;
+	const auto c{ cache.acquire(&owner, 0, [&]() {
+		inner = cache.acquire(&owner, 0, build);
+		return build();
+	}) };
+	EXPECT_EQ(c, inner);
+	const cluster_cache_stats_t stats{ cache.stats() };
+	EXPECT_EQ(stats.misses, 2);
+	EXPECT_EQ(stats.wasted_loads, 1);
+	EXPECT_EQ(stats.bytes_paged_in, inner->memory_usage());
+}
@@ -0,0 +1,205 @@
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../distributed_render.h"
+#include "../render_manager.h"
+#include "../settings.h"
+#ifdef __linux__
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+static scene_t test_scene(const std::string& name)
+{
+	if (name != "default")
+	{
+		throw std::invalid_argument("Unknown scene " + name);
+	}
+	Camera c{ 11, 11, PI / 2 };
+	c.transform = matrix_t::view_transform(tuple_t::point(0, 0, -5), tuple_t::point(0, 0, 0), tuple_t::vector(0, 1, 0));
+	return { World::default_world(), c };
+}
+
+static void expect_matches_local_render(const canvas_t& image)
+{
+	const scene_t scene{ test_scene("default") };
+	RenderManager rm{ scene.camera, 4 };
+	const canvas_t expected{ rm.render(scene.world) };
+	for (int y{ 0 }; y < 11; y++)
+	{
+		for (int x{ 0 }; x < 11; x++)
+		{
+			EXPECT_EQ(image.pixel_at(x, y), expected.pixel_at(x, y));
+		}
+	}
+}
+
+/*
+Scenario: Tiles rendered by several workers are assembled into the image
+  Given c ← render_coordinator("default", 11, 11, 4)
+	And two workers connected to c
+  When image ← c.render()
+  Then image = render_manager(...).render(default scene)
+*/
+TEST(distributed_render, should_assemble_tiles_from_several_workers)
+{
+	std::vector<std::thread> workers;
+	{
+		RenderCoordinator c{ "default", 11, 11, 4 };
+		for (int i{ 0 }; i < 2; i++)
+		{
+			workers.emplace_back([port = c.port()]() { run_render_worker("127.0.0.1", port, test_scene); });
+		}
+		const canvas_t image{ c.render() };
+		EXPECT_GE(c.workers_seen(), 1);
+		EXPECT_EQ(c.tiles_reassigned(), 0);
+		expect_matches_local_render(image);
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+/*
+Scenario: The tiles of a worker that disconnects are handed to another worker
+  Given c ← render_coordinator("default", 11, 11, 4)
+	And a worker that disconnects after sending 1 tile
+  When that worker has left
+	And a second worker connects
+	And image ← c.render()
+  Then c.tiles_reassigned() > 0
+	And image = render_manager(...).render(default scene)
+*/
+TEST(distributed_render, should_reassign_tiles_of_a_lost_worker)
+{
+	RenderCoordinator c{ "default", 11, 11, 4 };
+	std::thread worker{ [port = c.port()]() {
+		run_render_worker("127.0.0.1", port, test_scene, { 1 });
+		run_render_worker("127.0.0.1", port, test_scene);
+	} };
+	const canvas_t image{ c.render() };
+	worker.join();
+	EXPECT_EQ(c.workers_seen(), 2);
+	EXPECT_GT(c.tiles_reassigned(), 0);
+	expect_matches_local_render(image);
+}
+
+/*
+Scenario: A worker that stalls halfway through a message is dropped
+  Given c ← render_coordinator("default", 11, 11, 4, worker timeout 0.2 seconds)
+	And a worker that is assigned a tile and sends only the header of its tile message
+	And a second worker
+  When image ← c.render()
+  Then c.tiles_reassigned() > 0
+	And image = render_manager(...).render(default scene)
+*/
+TEST(distributed_render, should_drop_a_worker_stalled_within_a_message)
+{
+	coordinator_options_t options{};
+	options.worker_timeout = 0.2;
+	RenderCoordinator c{ "default", 11, 11, 4, options };
+	std::thread worker{ [port = c.port()]() {
+		const TcpSocket stalled{ TcpSocket::connect("127.0.0.1", port) };
+		const std::uint32_t hello[3]{ 1, 4, 1 };
+		stalled.send_all(hello, sizeof(hello));
+		std::uint32_t header[2]{};
+		std::vector<char> payload;
+		for (int i{ 0 }; i < 2; i++)
+		{
+			// the job, then the assignment
+			stalled.receive_all(header, sizeof(header));
+			payload.resize(header[1]);
+			stalled.receive_all(payload.data(), payload.size());
+		}
+		const std::uint32_t tile_header[2]{ 4, 1024 };
+		stalled.send_all(tile_header, sizeof(tile_header));
+
+		run_render_worker("127.0.0.1", port, test_scene);
+	} };
+	const canvas_t image{ c.render() };
+	worker.join();
+	EXPECT_GT(c.tiles_reassigned(), 0);
+	expect_matches_local_render(image);
+}
+
+/*
+Scenario: Render fails when no worker connects
+  Given c ← render_coordinator("default", 11, 11, 4, idle timeout 0.2 seconds)
+  Then c.render() throws runtime_error
+*/
+TEST(distributed_render, should_fail_without_workers)
+{
+	coordinator_options_t options{};
+	options.idle_timeout = 0.2;
+	RenderCoordinator c{ "default", 11, 11, 4, options };
+	EXPECT_THROW(c.render(), std::runtime_error);
+}
+
+/*
+Worker process started by should_render_with_worker_processes, skipped when run directly.
+*/
+TEST(distributed_render, DISABLED_worker_process)
+{
+	const char* port{ std::getenv("RAYTRACER_COORDINATOR_PORT") };
+	if (!port)
+	{
+		GTEST_SKIP();
+	}
+	const char* max_tiles{ std::getenv("RAYTRACER_WORKER_MAX_TILES") };
+	worker_options_t options{};
+	options.max_tiles = max_tiles ? std::strtoul(max_tiles, nullptr, 10) : 0;
+	run_render_worker("127.0.0.1", static_cast<std::uint16_t>(std::atoi(port)), test_scene, options);
+}
+
+#ifdef __linux__
+/*
+Scenario: Worker processes on the same host render the image
+  Given c ← render_coordinator("default", 11, 11, 4)
+	And three worker processes, one of which leaves after 1 tile
+  When image ← c.render()
+  Then image = render_manager(...).render(default scene)
+	And every worker process exits successfully
+*/
+TEST(distributed_render, should_render_with_worker_processes)
+{
+	std::vector<pid_t> children;
+	{
+		RenderCoordinator c{ "default", 11, 11, 4 };
+		const std::string port{ "RAYTRACER_COORDINATOR_PORT=" + std::to_string(c.port()) };
+		for (int i{ 0 }; i < 3; i++)
+		{
+			std::vector<std::string> args{ "/proc/self/exe", "--gtest_filter=distributed_render.DISABLED_worker_process", "--gtest_also_run_disabled_tests", "--gtest_brief=1" };
+			std::vector<std::string> env{ port };
+			if (i == 0) env.push_back("RAYTRACER_WORKER_MAX_TILES=1");
+			for (char** e{ environ }; *e; e++)
+			{
+				env.push_back(*e);
+			}
+			std::vector<char*> argv;
+			for (auto& a : args) argv.push_back(a.data());
+			argv.push_back(nullptr);
+			std::vector<char*> envp;
+			for (auto& e : env) envp.push_back(e.data());
+			envp.push_back(nullptr);
+			pid_t pid{};
+			ASSERT_EQ(posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, argv.data(), envp.data()), 0);
+			children.push_back(pid);
+		}
+		const canvas_t image{ c.render() };
+		expect_matches_local_render(image);
+	}
+	for (const pid_t pid : children)
+	{
+		int status{ 0 };
+		ASSERT_EQ(waitpid(pid, &status, 0), pid);
+		EXPECT_TRUE(WIFEXITED(status));
+		EXPECT_EQ(WEXITSTATUS(status), 0);
+	}
+}
+#endif
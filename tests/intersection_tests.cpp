@@ -464,4 +464,46 @@ TEST(intersect, should_have_u_v_w)
     EXPECT_EQ(i.alpha, 0.2);
     EXPECT_EQ(i.beta, 0.4);
     EXPECT_EQ(i.gamma, 0.4);
-}
\ No newline at end of file
+}
+
+/*
+Scenario: Precomputing the footprint of a pixel on a plane
+  Given shape ← plane()
+    And r ← ray(point(0.25, 1, 0.25), vector(0, -1, 0)) with differentials
+      dx: ray(point(0.35, 1, 0.25), vector(0, -1, 0))
+      dy: ray(point(0.25, 1, 0.25), normalize(vector(0, -1, 0.2)))
+    And i ← intersection(1, shape)
+  When state ← i.prepare(r)
+  Then state.differentials.dpdx = vector(0.1, 0, 0)
+    And state.differentials.dpdy = vector(0, 0, 0.2)
+    And du/dx = 0.1, dv/dx = 0, du/dy = 0, dv/dy = 0.2
+    And the reflected differentials start at the offset points
+*/
+TEST(intersect, should_precompute_the_surface_differentials)
+{
+    const auto shape{ Plane::create() };
+    ray_t r{ tuple_t::point(0.25, 1, 0.25), tuple_t::vector(0, -1, 0) };
+    r.differentials = {
+        true,
+        tuple_t::point(0.35, 1, 0.25),
+        tuple_t::vector(0, -1, 0),
+        tuple_t::point(0.25, 1, 0.25),
+        tuple_t::normalize(tuple_t::vector(0, -1, 0.2))
+    };
+    const intersections_t intersections{};
+    const intersection_t i{ 1, shape };
+    const intersection_state state{ i.prepare(r, intersections) };
+    ASSERT_TRUE(state.differentials.valid);
+    EXPECT_EQ(state.differentials.dpdx, tuple_t::vector(0.1, 0, 0));
+    EXPECT_EQ(state.differentials.dpdy, tuple_t::vector(0, 0, 0.2));
+    EXPECT_NEAR(state.differentials.du_dx, 0.1, EPSILON);
+    EXPECT_NEAR(state.differentials.dv_dx, 0, EPSILON);
+    EXPECT_NEAR(state.differentials.du_dy, 0, EPSILON);
+    EXPECT_NEAR(state.differentials.dv_dy, 0.2, EPSILON);
+    EXPECT_NEAR(state.differentials.uv_footprint(), 0.2, EPSILON);
+
+    const ray_differentials_t reflected{ state.reflected_differentials() };
+    ASSERT_TRUE(reflected.valid);
+    EXPECT_EQ(reflected.dx_origin, state.over_point + tuple_t::vector(0.1, 0, 0));
+    EXPECT_EQ(reflected.dx_direction, tuple_t::vector(0, 1, 0));
+}
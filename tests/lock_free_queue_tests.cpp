@@ -0,0 +1,79 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../lock_free_queue.h"
+
+/*
+Scenario: The capacity is rounded up to a power of two
+  Given q ← lock_free_queue(5)
+  Then q.capacity() = 8
+	And q.empty() = true
+*/
+TEST(lock_free_queue, should_round_capacity_up_to_power_of_two)
+{
+	const LockFreeQueue<int> q{ 5 };
+	EXPECT_EQ(q.capacity(), 8);
+	EXPECT_TRUE(q.empty());
+}
+
+/*
+Scenario: Values are popped in the order they were pushed until the queue is empty
+  Given q ← lock_free_queue(4)
+  When 1, 2, 3 and 4 are pushed
+  Then try_push(5) = false
+	And popping gives 1, 2, 3 and 4
+	And try_pop = false
+*/
+TEST(lock_free_queue, should_pop_in_fifo_order_and_reject_when_full)
+{
+	LockFreeQueue<int> q{ 4 };
+	for (int i{ 1 }; i <= 4; i++)
+	{
+		q.push(i);
+	}
+	int extra{ 5 };
+	EXPECT_FALSE(q.try_push(extra));
+	for (int i{ 1 }; i <= 4; i++)
+	{
+		int value{};
+		ASSERT_TRUE(q.try_pop(value));
+		EXPECT_EQ(value, i);
+	}
+	int value{};
+	EXPECT_FALSE(q.try_pop(value));
+	EXPECT_TRUE(q.empty());
+}
+
+/*
+Scenario: Many producers and consumers move every value exactly once
+  Given q ← lock_free_queue(16)
+  When 4 producers each push the values 1 to 10000
+	And 4 consumers each wait_and_pop 10000 values
+  Then the sum of the popped values = 4 * (10000 * 10001 / 2)
+*/
+TEST(lock_free_queue, should_move_every_value_between_many_threads)
+{
+	LockFreeQueue<long long> q{ 16 };
+	std::atomic<long long> sum{ 0 };
+	std::vector<std::thread> threads;
+	for (int t{ 0 }; t < 4; t++)
+	{
+		threads.emplace_back([&q]() {
+			for (long long i{ 1 }; i <= 10000; i++) q.push(i);
+		});
+		threads.emplace_back([&q, &sum]() {
+			long long local{ 0 };
+			for (int i{ 0 }; i < 10000; i++)
+			{
+				long long value{};
+				q.wait_and_pop(value);
+				local += value;
+			}
+			sum += local;
+		});
+	}
+	for (auto& thread : threads) thread.join();
+	EXPECT_EQ(sum, 4LL * (10000LL * 10001LL / 2));
+	EXPECT_TRUE(q.empty());
+}
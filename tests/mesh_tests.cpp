@@ -50,25 +50,50 @@ TEST(mesh, should_load_mesh_from_wavefront_obj)
 Scenario: Create mesh with smooth triangles
   Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
   When m ← mesh(w, true)
-  Then m.triangles[0].n1 = vector(0.0 0.0 1.0)
-	And m.triangles[0].n2 = vector(0.0 0.0 1.0)
-	And m.triangles[0].n3 = vector(0.0 0.0 1.0)
-	And m.triangles[1].n1 = vector(0.0 0.0 1.0)
-	And m.triangles[1].n2 = vector(0.0 0.0 1.0)
-	And m.triangles[1].n3 = vector(0.0 0.0 1.0)
+  Then m.triangles[0].vertex_normal(0) = vector(0.0 0.0 1.0)
+	And m.triangles[0].vertex_normal(1) = vector(0.0 0.0 1.0)
+	And m.triangles[0].vertex_normal(2) = vector(0.0 0.0 1.0)
+	And m.triangles[1].vertex_normal(0) = vector(0.0 0.0 1.0)
+	And m.triangles[1].vertex_normal(1) = vector(0.0 0.0 1.0)
+	And m.triangles[1].vertex_normal(2) = vector(0.0 0.0 1.0)
 */
 TEST(mesh, should_create_mesh_consisting_of_smooth_triangles)
 {
 	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
 	const auto m{ Mesh::create(w, true) };
-	auto t1{ std::dynamic_pointer_cast<Triangle>(m->triangles[0]) };
-	auto t2{ std::dynamic_pointer_cast<Triangle>(m->triangles[1]) };
-	EXPECT_EQ(t1->n1, tuple_t::vector(0.0, 0.0, 1.0));
-	EXPECT_EQ(t1->n2, tuple_t::vector(0.0, 0.0, 1.0));
-	EXPECT_EQ(t1->n3, tuple_t::vector(0.0, 0.0, 1.0));
-	EXPECT_EQ(t2->n1, tuple_t::vector(0.0, 0.0, 1.0));
-	EXPECT_EQ(t2->n2, tuple_t::vector(0.0, 0.0, 1.0));
-	EXPECT_EQ(t2->n3, tuple_t::vector(0.0, 0.0, 1.0));
+	auto t1{ std::dynamic_pointer_cast<MeshTriangle>(m->triangles[0]) };
+	auto t2{ std::dynamic_pointer_cast<MeshTriangle>(m->triangles[1]) };
+	EXPECT_EQ(t1->vertex_normal(0), tuple_t::vector(0.0, 0.0, 1.0));
+	EXPECT_EQ(t1->vertex_normal(1), tuple_t::vector(0.0, 0.0, 1.0));
+	EXPECT_EQ(t1->vertex_normal(2), tuple_t::vector(0.0, 0.0, 1.0));
+	EXPECT_EQ(t2->vertex_normal(0), tuple_t::vector(0.0, 0.0, 1.0));
+	EXPECT_EQ(t2->vertex_normal(1), tuple_t::vector(0.0, 0.0, 1.0));
+	EXPECT_EQ(t2->vertex_normal(2), tuple_t::vector(0.0, 0.0, 1.0));
+}
+
+/*
+Scenario: Mesh triangles only reference their face in the vertex buffer
+  Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
+  When m ← mesh(w, true)
+	And t ← m.triangles[1]
+  Then t.vertex_buffer = m.vertex_buffer
+	And t.face = 1
+	And t.vertex_position(i) = m.vertex_buffer.position(m.vertex_buffer.indices[3 + i])
+	And a mesh triangle is smaller than a standalone triangle
+*/
+TEST(mesh, should_reference_faces_of_the_vertex_buffer)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
+	const auto m{ Mesh::create(w, true) };
+	const auto t{ std::dynamic_pointer_cast<MeshTriangle>(m->triangles[1]) };
+	ASSERT_NE(t, nullptr);
+	EXPECT_EQ(t->vertex_buffer, m->vertex_buffer);
+	EXPECT_EQ(t->face, 1);
+	for (int i{ 0 }; i < 3; i++)
+	{
+		EXPECT_EQ(t->vertex_position(i), m->vertex_buffer->position(m->vertex_buffer->indices[3 + i]));
+	}
+	EXPECT_LT(sizeof(MeshTriangle), sizeof(Triangle) / 2);
 }
 
 /*
@@ -504,4 +529,27 @@ TEST(mesh, should_hit_mesh_if_ray_intersects_bbox_of_bvh_and_intersects_triangle
 	intersections_t i{};
 	m.local_intersect(r, i);
 	EXPECT_EQ(i.entries.size(), 1);
-}
\ No newline at end of file
+}
+
+/*
+Scenario: A compressed mesh reports its size
+  Given w ← wavefront("..\\..\\tests\\assets\\cube.obj")
+	And m ← mesh(w, smooth: true, bvh_threshold: 4, weld_epsilon: 0, compress: true)
+  When s ← stats(m)
+  Then s.triangles = 12
+	And s.vertices = vertex_count(m.vertex_buffer)
+	And s.compressed is true
+	And s.bytes = memory_usage(m)
+	And s.vertex_buffer_bytes = memory_usage(m.vertex_buffer)
+*/
+TEST(mesh, should_report_its_stats)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\cube.obj" };
+	const auto m{ Mesh::create(w, true, 4, 0, true) };
+	const mesh_stats_t s{ m->stats() };
+	EXPECT_EQ(s.triangles, 12);
+	EXPECT_EQ(s.vertices, m->vertex_buffer->vertex_count());
+	EXPECT_TRUE(s.compressed);
+	EXPECT_EQ(s.bytes, m->memory_usage());
+	EXPECT_EQ(s.vertex_buffer_bytes, m->vertex_buffer->memory_usage());
+}
@@ -1,7 +1,27 @@
-﻿#include <string>
+﻿#include <filesystem>
+#include <string>
 #include <vector>
 #include "gtest/gtest.h"
 #include "../pattern_file.h"
+#include "../ppm.h"
+
+/**
+ * @brief Writes a 4x4 black and white checker with 1 texel cells, white top left.
+ */
+static std::string write_checker()
+{
+    canvas_t c{ 4, 4 };
+    for (int y{ 0 }; y < 4; y++)
+    {
+        for (int x{ 0 }; x < 4; x++)
+        {
+            c.write_pixel(x, y, (x + y) % 2 == 0 ? colour_t{ 1, 1, 1 } : colour_t{ 0, 0, 0 });
+        }
+    }
+    const std::string path{ (std::filesystem::temp_directory_path() / "pattern_file_checker.ppm").string() };
+    write_image(c, path, Image_Format::ppm);
+    return path;
+}
 
 /*
 Scenario: Checker pattern in 2D
@@ -40,4 +60,46 @@ TEST(pattern_file, should_read_colour_values_from_file)
     EXPECT_EQ(pt.at(0.3, 0), colour_t(0.2, 0.2, 0.2));
     EXPECT_EQ(pt.at(0.6, 0.3), colour_t(0.1, 0.1, 0.1));
     EXPECT_EQ(pt.at(1, 1), colour_t(0.9, 0.9, 0.9));
-}
\ No newline at end of file
+}
+
+/*
+Scenario: Building the mip pyramid of an image texture
+  Given pt ← pattern_file(4 × 4 checker, trilinear)
+  Then pt has 3 levels of 4 × 4, 2 × 2 and 1 × 1 texels
+    And every texel of levels 1 and 2 = color(0.5, 0.5, 0.5)
+    And uv_pattern_at(pt, 0.5, 0.5, 1) = color(0.5, 0.5, 0.5)
+    And uv_pattern_at(pt, 0, 1, 0) = color(1, 1, 1)
+*/
+TEST(pattern_file, should_build_a_mip_pyramid)
+{
+    const std::string path{ write_checker() };
+    const PatternFile pt{ path.c_str(), Texture_Filter::trilinear };
+    ASSERT_EQ(pt.levels.size(), 3);
+    EXPECT_EQ(pt.levels[1].width, 2);
+    EXPECT_EQ(pt.levels[1].height, 2);
+    EXPECT_EQ(pt.levels[2].width, 1);
+    EXPECT_EQ(pt.levels[1].pixel_at(1, 0), colour_t(0.5, 0.5, 0.5));
+    EXPECT_EQ(pt.levels[2].pixel_at(0, 0), colour_t(0.5, 0.5, 0.5));
+    EXPECT_EQ(pt.at(0.5, 0.5, 1), colour_t(0.5, 0.5, 0.5));
+    EXPECT_EQ(pt.at(0, 1, 0), colour_t(1, 1, 1));
+    std::filesystem::remove(path);
+}
+
+/*
+Scenario: Bilinear filtering blends the texels around the UV coordinates
+  Given pt ← pattern_file(4 × 4 checker, bilinear)
+    And nearest ← pattern_file(4 × 4 checker)
+  Then uv_pattern_at(pt, 1/6, 1) = color(0.5, 0.5, 0.5)
+    And uv_pattern_at(pt, 1/3, 1) = color(0, 0, 0)
+    And uv_pattern_at(nearest, 1/6 + ε, 1, 1) = color(0, 0, 0)
+*/
+TEST(pattern_file, should_filter_texels_bilinearly)
+{
+    const std::string path{ write_checker() };
+    const PatternFile pt{ path.c_str(), Texture_Filter::bilinear };
+    const PatternFile nearest{ path.c_str() };
+    EXPECT_EQ(pt.at(1.0 / 6, 1), colour_t(0.5, 0.5, 0.5));
+    EXPECT_EQ(pt.at(1.0 / 3, 1), colour_t(0, 0, 0));
+    EXPECT_EQ(nearest.at(1.0 / 6 + 0.01, 1, 1), colour_t(0, 0, 0));
+    std::filesystem::remove(path);
+}
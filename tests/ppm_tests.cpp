@@ -1,4 +1,8 @@
-﻿#include <sstream>
+﻿#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include "gtest/gtest.h"
 #include "../canvas.h"
@@ -221,4 +225,126 @@ TEST(ppm, should_throw_if_ppm_magic_number_is_not_3)
     c.fill(red);
     const ppm_t ppm{ c };
     EXPECT_THROW(ppm_t out_ppm{ "..\\..\\tests\\bad.ppm" }, std::invalid_argument);
-}
\ No newline at end of file
+}
+
+/*
+Scenario: Encoding a canvas as a binary 8-bit PPM
+  Given c ← canvas(2, 2)
+	And write_pixel(c, 1, 0, color(1.5, 0.5, -0.5))
+  When data ← encode_image(c, ppm)
+  Then data starts with "P6\n2 2\n255\n"
+	And the second pixel is bytes 255 128 0
+*/
+TEST(ppm, should_encode_a_binary_8_bit_ppm)
+{
+	canvas_t c{ 2, 2 };
+	c.write_pixel(1, 0, colour_t{ 1.5, 0.5, -0.5 });
+	const std::string data{ encode_image(c, Image_Format::ppm) };
+	const std::string header{ "P6\n2 2\n255\n" };
+	ASSERT_EQ(data.size(), header.size() + 2 * 2 * 3);
+	EXPECT_EQ(data.substr(0, header.size()), header);
+	EXPECT_EQ(data.substr(header.size() + 3, 3), std::string("\xff\x80\x00", 3));
+}
+
+/*
+Scenario: Encoding a canvas as a binary 16-bit PPM
+  Given c ← canvas(2, 1)
+	And write_pixel(c, 0, 0, color(1, 0.5, 0))
+  When data ← encode_image(c, ppm16)
+  Then data starts with "P6\n2 1\n65535\n"
+	And the first pixel is big endian 65535 32768 0
+*/
+TEST(ppm, should_encode_a_binary_16_bit_ppm)
+{
+	canvas_t c{ 2, 1 };
+	c.write_pixel(0, 0, colour_t{ 1, 0.5, 0 });
+	const std::string data{ encode_image(c, Image_Format::ppm16) };
+	const std::string header{ "P6\n2 1\n65535\n" };
+	ASSERT_EQ(data.size(), header.size() + 2 * 6);
+	EXPECT_EQ(data.substr(0, header.size()), header);
+	EXPECT_EQ(data.substr(header.size(), 6), std::string("\xff\xff\x80\x00\x00\x00", 6));
+}
+
+/*
+Scenario: Writing a canvas as a PFM file
+  Given c ← canvas(3, 2)
+	And write_pixel(c, 2, 0, color(2.5, 0.25, 0))
+  When write_image(c, file, pfm)
+  Then the file holds the float pixels bottom row first
+	And pixel (2, 0) is unclamped
+*/
+TEST(ppm, should_write_a_pfm_file)
+{
+	canvas_t c{ 3, 2 };
+	c.write_pixel(2, 0, colour_t{ 2.5, 0.25, 0 });
+	const std::string path{ (std::filesystem::temp_directory_path() / "ppm_tests.pfm").string() };
+	write_image(c, path, Image_Format::pfm);
+	std::ifstream in{ path, std::ios::binary };
+	const std::string data{ std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{} };
+	in.close();
+	const std::string header{ encoded_header(Image_Format::pfm, 3, 2) };
+	ASSERT_EQ(data.size(), header.size() + 3 * 2 * 12);
+	float rgb[3]{};
+	// the top row is the second row in the file
+	std::memcpy(rgb, data.data() + header.size() + (3 + 2) * sizeof(rgb), sizeof(rgb));
+	EXPECT_FLOAT_EQ(rgb[0], 2.5f);
+	EXPECT_FLOAT_EQ(rgb[1], 0.25f);
+	EXPECT_FLOAT_EQ(rgb[2], 0.0f);
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: Reading an ASCII PPM file with comments into a canvas
+  Given a file containing:
+    """
+    P3 # comment
+    2 1
+    # another comment
+    100
+    100 50 0  0 0 25
+    """
+  When c ← read_image(file)
+  Then pixel_at(c, 0, 0) = color(1, 0.5, 0)
+	And pixel_at(c, 1, 0) = color(0, 0, 0.25)
+*/
+TEST(ppm, should_read_an_ascii_ppm_into_a_canvas)
+{
+	const std::string path{ (std::filesystem::temp_directory_path() / "ppm_tests_p3.ppm").string() };
+	{
+		std::ofstream out{ path, std::ios::binary };
+		out << "P3 # comment\n2 1\n# another comment\n100\n100 50 0  0 0 25\n";
+	}
+	const canvas_t c{ read_image(path.c_str()) };
+	ASSERT_EQ(c.width, 2);
+	ASSERT_EQ(c.height, 1);
+	EXPECT_EQ(c.pixel_at(0, 0), colour_t(1, 0.5, 0));
+	EXPECT_EQ(c.pixel_at(1, 0), colour_t(0, 0, 0.25));
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: Reading back binary 8 and 16-bit PPM files
+  Given c ← canvas(3, 2)
+	And write_pixel(c, 2, 1, color(1, 0.2, 0.6))
+  When write_image(c, file, ppm) and write_image(c, file16, ppm16)
+  Then read_image(file) and read_image(file16) have the pixels of c
+	And a truncated file fails to read
+*/
+TEST(ppm, should_read_back_binary_ppm_files)
+{
+	canvas_t c{ 3, 2 };
+	c.write_pixel(2, 1, colour_t{ 1, 0.2, 0.6 });
+	const std::string path{ (std::filesystem::temp_directory_path() / "ppm_tests_p6.ppm").string() };
+	for (const Image_Format format : { Image_Format::ppm, Image_Format::ppm16 })
+	{
+		write_image(c, path, format);
+		const canvas_t read{ read_image(path.c_str()) };
+		ASSERT_EQ(read.width, 3);
+		ASSERT_EQ(read.height, 2);
+		EXPECT_EQ(read.pixel_at(0, 0), colour_t(0, 0, 0));
+		EXPECT_EQ(read.pixel_at(2, 1), colour_t(1, 0.2, 0.6));
+	}
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+	EXPECT_THROW(read_image(path.c_str()), std::runtime_error);
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,313 @@
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../render_manager.h"
+#include "../asset_registry.h"
+#include "../checkpoint.h"
+#include "../settings.h"
+#include "../phong.h"
+
+static Camera test_camera()
+{
+	Camera c{ 11, 11, PI / 2 };
+	c.transform = matrix_t::view_transform(tuple_t::point(0, 0, -5), tuple_t::point(0, 0, 0), tuple_t::vector(0, 1, 0));
+	return c;
+}
+
+/*
+Scenario: Rendering a world with a render manager
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+  When image ← rm.render(w)
+  Then pixel_at(image, 5, 5) = color(0.38066, 0.47583, 0.2855)
+	And rm.tile_costs() has one entry per tile
+*/
+TEST(render_manager, should_render_a_world)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	const canvas_t image{ rm.render(w) };
+	EXPECT_EQ(image.pixel_at(5, 5), colour_t(0.38066, 0.47583, 0.2855));
+	EXPECT_EQ(rm.tile_costs().size(), 9);
+}
+
+/*
+Scenario: A progressive render refines from coarse blocks to the full image
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+  When image ← rm.render_progressive(w, coarse block 4, 1 sample)
+  Then the passes had block sizes 4, 2 and 1
+	And image = rm.render(w)
+	And rm.snapshot() = image
+*/
+TEST(render_manager, should_refine_progressively_to_the_full_image)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	std::vector<int> blocks;
+	progressive_options_t options{};
+	options.coarse_block_size = 4;
+	options.on_pass = [&blocks](const canvas_t&, const render_progress_t& progress) {
+		EXPECT_TRUE(progress.complete);
+		blocks.push_back(progress.block_size);
+	};
+	const canvas_t image{ rm.render_progressive(w, options) };
+	EXPECT_EQ(blocks, (std::vector<int>{ 4, 2, 1 }));
+	const canvas_t expected{ rm.render(w) };
+	const canvas_t snapshot{ rm.snapshot() };
+	for (int y{ 0 }; y < 11; y++)
+	{
+		for (int x{ 0 }; x < 11; x++)
+		{
+			EXPECT_EQ(image.pixel_at(x, y), expected.pixel_at(x, y));
+			EXPECT_EQ(snapshot.pixel_at(x, y), image.pixel_at(x, y));
+		}
+	}
+}
+
+/*
+Scenario: A progressive render stops at the target sample count
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+  When rm.render_progressive(w, coarse block 1, 3 samples)
+  Then the last pass reports 3 samples per pixel
+*/
+TEST(render_manager, should_stop_progressive_render_at_target_samples)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	progressive_options_t options{};
+	options.coarse_block_size = 1;
+	options.target_samples = 3;
+	render_progress_t last{};
+	int passes{ 0 };
+	options.on_pass = [&](const canvas_t&, const render_progress_t& progress) {
+		passes++;
+		last = progress;
+	};
+	rm.render_progressive(w, options);
+	EXPECT_EQ(passes, 3);
+	EXPECT_EQ(last.samples, 3);
+	EXPECT_TRUE(last.complete);
+}
+
+/*
+Scenario: A cancelled progressive render stops after an incomplete pass
+  Given w ← default_world()
+	And token is cancelled
+  When rm.render_progressive(w, cancel = token)
+  Then a single incomplete pass is reported
+*/
+TEST(render_manager, should_stop_progressive_render_when_cancelled)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	CancellationToken token;
+	token.cancel();
+	progressive_options_t options{};
+	options.cancel = &token;
+	std::vector<bool> complete;
+	options.on_pass = [&complete](const canvas_t&, const render_progress_t& progress) {
+		complete.push_back(progress.complete);
+	};
+	rm.render_progressive(w, options);
+	EXPECT_EQ(complete, (std::vector<bool>{ false }));
+}
+
+/*
+Scenario: Adaptive anti-aliasing only adds samples where pixels disagree
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And rm.set_antialiasing(1 to 8 samples, threshold 0.05)
+  When image ← rm.render(w)
+  Then 1 < rm.samples_per_pixel() < 8
+	And pixel_at(image, 0, 0) = color(0, 0, 0)
+*/
+TEST(render_manager, should_supersample_adaptively)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	rm.set_antialiasing({ 1, 8, 0.05 });
+	const canvas_t image{ rm.render(w) };
+	EXPECT_GT(rm.samples_per_pixel(), 1.0);
+	EXPECT_LT(rm.samples_per_pixel(), 8.0);
+	EXPECT_EQ(image.pixel_at(0, 0), colour_t(0, 0, 0));
+}
+
+/*
+Scenario: Anti-aliasing rejects a minimum sample count above the maximum
+  Given rm ← render_manager(camera(11, 11, π/2), 4)
+  Then rm.set_antialiasing(4 to 2 samples) throws invalid_argument
+*/
+TEST(render_manager, should_reject_invalid_antialiasing_sample_counts)
+{
+	RenderManager rm{ test_camera(), 4 };
+	EXPECT_THROW(rm.set_antialiasing({ 4, 2, 0.05 }), std::invalid_argument);
+}
+
+/*
+Scenario: An incremental render only re-renders the tiles touched by an edited object
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And rm.render_incremental(w)
+  When the colour of the outer sphere's material changes
+	And w.mark_changed(outer sphere)
+	And image ← rm.render_incremental(w)
+  Then fewer than all 9 tiles were rendered
+	And image = render_manager(...).render(w)
+*/
+TEST(render_manager, should_rerender_only_tiles_touched_by_an_edit)
+{
+	World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	rm.render_incremental(w);
+	EXPECT_EQ(rm.tiles_rendered(), 9);
+
+	auto phong = std::dynamic_pointer_cast<Phong>(std::dynamic_pointer_cast<Geometry>(w.scene_objects[0])->material);
+	ASSERT_TRUE(phong);
+	phong->colour = { 1.0, 0.2, 0.2 };
+	w.mark_changed(w.scene_objects[0]);
+	const canvas_t image{ rm.render_incremental(w) };
+	EXPECT_GT(rm.tiles_rendered(), 0);
+	EXPECT_LT(rm.tiles_rendered(), 9);
+	EXPECT_FALSE(w.needs_full_render());
+
+	RenderManager fresh{ test_camera(), 4 };
+	const canvas_t expected{ fresh.render(w) };
+	for (int y{ 0 }; y < 11; y++)
+	{
+		for (int x{ 0 }; x < 11; x++)
+		{
+			EXPECT_EQ(image.pixel_at(x, y), expected.pixel_at(x, y));
+		}
+	}
+}
+
+/*
+Scenario: Resuming a render from a checkpoint renders only the missing tiles
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And full ← rm.render(w)
+	And a checkpoint of full in which only the first 4 of 9 tiles are finished
+  When image ← rm.resume(w, checkpoint)
+  Then 5 tiles were rendered
+	And image = full
+*/
+TEST(render_manager, should_resume_a_render_from_a_checkpoint)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	const canvas_t full{ rm.render(w) };
+	const std::string path{ (std::filesystem::temp_directory_path() / "render_manager_resume.rtck").string() };
+	{
+		const std::vector<bool> done{ true, true, true, true, false, false, false, false, false };
+		CheckpointWriter writer{ path, 60, rm.scene_hash(w), full, 4, done };
+	}
+	const checkpoint_t saved{ checkpoint_t::load(path) };
+	EXPECT_EQ(saved.done, (std::vector<bool>{ true, true, true, true, false, false, false, false, false }));
+
+	const canvas_t image{ rm.resume(w, path) };
+	EXPECT_EQ(rm.tiles_rendered(), 5);
+	for (int y{ 0 }; y < 11; y++)
+	{
+		for (int x{ 0 }; x < 11; x++)
+		{
+			EXPECT_EQ(image.pixel_at(x, y), full.pixel_at(x, y));
+		}
+	}
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: A checkpoint of another scene is rejected
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And a checkpoint of w
+  When the colour of the outer sphere's material changes
+  Then rm.resume(w, checkpoint) throws
+*/
+TEST(render_manager, should_reject_a_checkpoint_of_another_scene)
+{
+	World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	const canvas_t image{ 11, 11 };
+	const std::string path{ (std::filesystem::temp_directory_path() / "render_manager_mismatch.rtck").string() };
+	{
+		CheckpointWriter writer{ path, 60, rm.scene_hash(w), image, 4 };
+	}
+	auto phong = std::dynamic_pointer_cast<Phong>(std::dynamic_pointer_cast<Geometry>(w.scene_objects[0])->material);
+	ASSERT_TRUE(phong);
+	phong->colour = { 1.0, 0.2, 0.2 };
+	EXPECT_THROW(rm.resume(w, path), std::runtime_error);
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: A completed render removes its checkpoint
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4) checkpointing to a file
+  When rm.render(w)
+  Then the checkpoint file does not exist
+*/
+TEST(render_manager, should_remove_the_checkpoint_of_a_completed_render)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	const std::string path{ (std::filesystem::temp_directory_path() / "render_manager_complete.rtck").string() };
+	rm.set_checkpoint({ path, 0.001 });
+	rm.render(w);
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+/*
+Scenario: Rendering into a compact canvas
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And rm.set_canvas_format(rgba_half)
+  When image ← rm.render(w)
+  Then image.format = rgba_half
+	And pixel_at(image, 5, 5) ≈ color(0.38066, 0.47583, 0.2855)
+	And pixel_at(rm.snapshot(), 5, 5) = pixel_at(image, 5, 5)
+*/
+TEST(render_manager, should_render_into_a_compact_canvas)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	rm.set_canvas_format(Canvas_Format::rgba_half);
+	const canvas_t image{ rm.render(w) };
+	EXPECT_EQ(image.format, Canvas_Format::rgba_half);
+	EXPECT_NEAR(image.pixel_at(5, 5).red, 0.38066, 0.001);
+	EXPECT_NEAR(image.pixel_at(5, 5).green, 0.47583, 0.001);
+	EXPECT_NEAR(image.pixel_at(5, 5).blue, 0.2855, 0.001);
+	EXPECT_EQ(rm.snapshot().pixel_at(5, 5), image.pixel_at(5, 5));
+}
+
+/*
+Scenario: The asset report is only printed when asked for
+  Given w ← default_world()
+	And the global asset registry has served a request
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+  When rm.render(w)
+  Then nothing starting "Assets:" is printed
+  When rm.set_report_stats(true)
+	And rm.render(w)
+  Then a line starting "Assets:" is printed
+*/
+TEST(render_manager, should_print_reports_only_when_asked)
+{
+	const World w{ World::default_world() };
+	AssetRegistry::global().mesh("..\\..\\tests\\assets\\cube.obj");
+	RenderManager rm{ test_camera(), 4 };
+	testing::internal::CaptureStdout();
+	rm.render(w);
+	const std::string quiet{ testing::internal::GetCapturedStdout() };
+	EXPECT_EQ(quiet.find("Assets:"), std::string::npos);
+	rm.set_report_stats(true);
+	testing::internal::CaptureStdout();
+	rm.render(w);
+	const std::string reported{ testing::internal::GetCapturedStdout() };
+	EXPECT_NE(reported.find("Assets:"), std::string::npos);
+}
@@ -134,4 +134,23 @@ TEST(stripe, should_work_with_pattern_and_object_transforms)
 	auto s{ Sphere::create() };
 	s->transform = matrix_t::scaling(2, 2, 2);
 	EXPECT_EQ(stripe.at_object(dynamic_cast<Geometry*>(s.get()), tuple_t::point(2.5, 0, 0)), white);
-}
\ No newline at end of file
+}
+
+/*
+Scenario: A stripe pattern averaged over a footprint blends across an edge
+  Given pattern ← stripe_pattern(white, black)
+  Then stripe_at(pattern, point(1, 0, 0), 1) = color(0.5, 0.5, 0.5)
+    And stripe_at(pattern, point(0.5, 0, 0), 4) = color(0.5, 0.5, 0.5)
+    And stripe_at(pattern, point(0.25, 0, 0), 0.5) = white
+    And stripe_at(pattern, point(-0.5, 0, 0), 0) = black
+*/
+TEST(stripe, should_average_over_a_footprint)
+{
+	const colour_t black{ 0, 0, 0 };
+	const colour_t white{ 1, 1, 1 };
+	const Stripe stripe{ white, black };
+	EXPECT_EQ(stripe.at(tuple_t::point(1, 0, 0), 1), colour_t(0.5, 0.5, 0.5));
+	EXPECT_EQ(stripe.at(tuple_t::point(0.5, 0, 0), 4), colour_t(0.5, 0.5, 0.5));
+	EXPECT_EQ(stripe.at(tuple_t::point(0.25, 0, 0), 0.5), white);
+	EXPECT_EQ(stripe.at(tuple_t::point(-0.5, 0, 0), 0), black);
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../texture.h"
+
+/**
+ * @brief Returns a 5 × 3 canvas with a different colour in every pixel.
+ */
+static canvas_t test_image()
+{
+	canvas_t c{ 5, 3 };
+	for (int y{ 0 }; y < 3; y++)
+	{
+		for (int x{ 0 }; x < 5; x++)
+		{
+			c.write_pixel(x, y, colour_t{ x * 51 / 255.0, y * 102 / 255.0, (x + y) * 17 / 255.0 });
+		}
+	}
+	return c;
+}
+
+/*
+Scenario: Tiled textures keep the texels of an image
+  Given c ← a 5 × 3 canvas of 8-bit colours
+  When t ← texture(c, rgb_float) and t8 ← texture(c, rgba8)
+  Then every pixel_at(t, x, y) = pixel_at(c, x, y)
+	And every pixel_at(t8, x, y) = pixel_at(c, x, y)
+	And pixel_at(t, 5, 0) = color(0, 0, 0)
+	And t8 holds 2 × 1 blocks of 4 × 4 texels of 4 bytes
+*/
+TEST(texture, should_store_texels_in_blocks)
+{
+	const canvas_t c{ test_image() };
+	const Texture t{ c, Texture_Format::rgb_float };
+	const Texture t8{ c, Texture_Format::rgba8 };
+	for (int y{ 0 }; y < 3; y++)
+	{
+		for (int x{ 0 }; x < 5; x++)
+		{
+			EXPECT_EQ(t.pixel_at(x, y), c.pixel_at(x, y));
+			EXPECT_EQ(t8.pixel_at(x, y), c.pixel_at(x, y));
+		}
+	}
+	EXPECT_EQ(t.pixel_at(5, 0), colour_t(0, 0, 0));
+	EXPECT_EQ(t8.memory_size(), 2 * 16 * 4);
+}
+
+/*
+Scenario: BC1 textures compress blocks to 8 bytes with a bounded error
+  Given c ← a 64 × 64 canvas with a smooth gradient
+  When t ← texture(c, bc1)
+  Then t takes 64 times less memory than c
+	And every pixel_at(t, x, y) is within 0.05 of pixel_at(c, x, y)
+	And a block of a single colour decodes to that colour rounded to RGB565
+*/
+TEST(texture, should_compress_blocks_to_bc1)
+{
+	canvas_t c{ 64, 64 };
+	for (int y{ 0 }; y < 64; y++)
+	{
+		for (int x{ 0 }; x < 64; x++)
+		{
+			c.write_pixel(x, y, colour_t{ x / 63.0, y / 63.0, 1 - x / 63.0 });
+		}
+	}
+	const Texture t{ c, Texture_Format::bc1 };
+	EXPECT_EQ(t.memory_size() * 64, c.memory_size());
+	double worst{ 0 };
+	for (int y{ 0 }; y < 64; y++)
+	{
+		for (int x{ 0 }; x < 64; x++)
+		{
+			const colour_t expected{ c.pixel_at(x, y) };
+			const colour_t decoded{ t.pixel_at(x, y) };
+			worst = std::max({ worst, std::fabs(expected.red - decoded.red), std::fabs(expected.green - decoded.green), std::fabs(expected.blue - decoded.blue) });
+		}
+	}
+	EXPECT_LT(worst, 0.05);
+
+	canvas_t flat{ 4, 4 };
+	flat.fill(colour_t{ 1, 0, 0 });
+	EXPECT_EQ(Texture(flat, Texture_Format::bc1).pixel_at(2, 3), colour_t(1, 0, 0));
+}
@@ -0,0 +1,252 @@
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../thread_pool.h"
+
+/*
+Scenario: A thread pool can be created with a given number of threads
+  Given pool ← thread_pool(3)
+  Then pool.thread_count() = 3
+*/
+TEST(thread_pool, should_use_configured_thread_count)
+{
+	ThreadPool pool{ 3 };
+	EXPECT_EQ(pool.thread_count(), 3);
+}
+
+/*
+Scenario: The shared pool is sized before its first use
+  Given a new process
+  When thread_pool::configure_shared(3)
+  Then thread_pool::shared().thread_count() = 3
+	And thread_pool::configure_shared(2) throws logic_error
+*/
+TEST(thread_pool, should_size_the_shared_pool_before_first_use)
+{
+	// the shared pool of this process already exists, the child process starts afresh
+	GTEST_FLAG_SET(death_test_style, "threadsafe");
+	EXPECT_EXIT({
+		ThreadPool::configure_shared(3);
+		const bool sized{ ThreadPool::shared().thread_count() == 3 };
+		try
+		{
+			ThreadPool::configure_shared(2);
+		}
+		catch (const std::logic_error&)
+		{
+			std::exit(sized ? 0 : 1);
+		}
+		std::exit(2);
+	}, ::testing::ExitedWithCode(0), "");
+}
+
+/*
+Scenario: Every submitted task is run
+  Given pool ← thread_pool(4)
+  When 1000 tasks each incrementing a counter are submitted
+	And all their futures are waited on
+  Then the counter = 1000
+*/
+TEST(thread_pool, should_run_all_submitted_tasks)
+{
+	ThreadPool pool{ 4 };
+	std::atomic<int> counter{ 0 };
+	std::vector<std::future<void>> futures;
+	for (int i{ 0 }; i < 1000; i++)
+	{
+		std::packaged_task<void()> task{ [&counter]() { ++counter; } };
+		futures.push_back(task.get_future());
+		pool.submit(std::move(task));
+	}
+	for (auto& future : futures)
+	{
+		future.get();
+	}
+	EXPECT_EQ(counter, 1000);
+}
+
+/*
+Scenario: Tasks can submit and wait for further tasks
+  Given pool ← thread_pool(2)
+  When 4 tasks each submit 50 child tasks and help run them while waiting
+  Then all 200 child tasks are run without deadlocking
+*/
+TEST(thread_pool, should_run_nested_tasks_submitted_by_workers)
+{
+	ThreadPool pool{ 2 };
+	std::atomic<int> counter{ 0 };
+	std::vector<std::future<void>> futures;
+	for (int i{ 0 }; i < 4; i++)
+	{
+		std::packaged_task<void()> task{ [&pool, &counter]() {
+			std::vector<std::future<void>> children;
+			for (int j{ 0 }; j < 50; j++)
+			{
+				std::packaged_task<void()> child{ [&counter]() { ++counter; } };
+				children.push_back(child.get_future());
+				pool.submit(std::move(child));
+			}
+			for (auto& child : children)
+			{
+				while (child.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					if (!pool.run_pending_task()) std::this_thread::yield();
+				}
+			}
+		} };
+		futures.push_back(task.get_future());
+		pool.submit(std::move(task));
+	}
+	for (auto& future : futures)
+	{
+		future.get();
+	}
+	EXPECT_EQ(counter, 200);
+}
+
+/*
+Scenario: parallel_for visits every index exactly once
+  Given pool ← thread_pool(4)
+	And hits ← 10000 zeroed counters
+  When pool.parallel_for(0, 10000, 64, increment hits[i] for each i in the chunk)
+  Then every counter in hits = 1
+*/
+TEST(thread_pool, should_visit_every_index_once_in_parallel_for)
+{
+	ThreadPool pool{ 4 };
+	std::vector<std::atomic<int>> hits(10000);
+	pool.parallel_for(0, hits.size(), 64, [&hits](std::size_t begin, std::size_t end) {
+		for (std::size_t i{ begin }; i < end; i++) ++hits[i];
+	});
+	for (const auto& hit : hits)
+	{
+		EXPECT_EQ(hit, 1);
+	}
+}
+
+/*
+Scenario: parallel_for can be nested inside its own tasks
+  Given pool ← thread_pool(2)
+  When pool.parallel_for(0, 8, 1, each chunk runs pool.parallel_for(0, 100, 10, add 1 per index))
+  Then the counter = 800
+*/
+TEST(thread_pool, should_run_nested_parallel_for)
+{
+	ThreadPool pool{ 2 };
+	std::atomic<int> counter{ 0 };
+	pool.parallel_for(0, 8, 1, [&pool, &counter](std::size_t, std::size_t) {
+		pool.parallel_for(0, 100, 10, [&counter](std::size_t begin, std::size_t end) {
+			counter += static_cast<int>(end - begin);
+		});
+	});
+	EXPECT_EQ(counter, 800);
+}
+
+/*
+Scenario: A task group rethrows the first exception of its tasks
+  Given pool ← thread_pool(2)
+	And group ← task_group(pool)
+  When a task throwing std::runtime_error and a task incrementing a counter are run
+  Then group.wait() throws std::runtime_error
+	And the counter = 1
+*/
+TEST(thread_pool, should_rethrow_task_group_exceptions_on_wait)
+{
+	ThreadPool pool{ 2 };
+	std::atomic<int> counter{ 0 };
+	const auto fail = []() { throw std::runtime_error("task failed"); };
+	const auto count = [&counter]() { ++counter; };
+	TaskGroup group{ pool };
+	group.run(fail);
+	group.run(count);
+	EXPECT_THROW(group.wait(), std::runtime_error);
+	EXPECT_EQ(counter, 1);
+}
+
+/*
+Scenario: A job's concurrency limit bounds how many of its tasks run at once
+  Given pool ← thread_pool(4)
+  When pool.parallel_for(0, 64, 1, track the number of chunks running at once, max_concurrency = 2)
+  Then at most 2 chunks ran at once
+	And all 64 chunks ran
+*/
+TEST(thread_pool, should_limit_concurrency_of_a_job)
+{
+	ThreadPool pool{ 4 };
+	std::atomic<int> running{ 0 };
+	std::atomic<int> peak{ 0 };
+	std::atomic<int> count{ 0 };
+	pool.parallel_for(0, 64, 1, [&](std::size_t, std::size_t) {
+		const int now{ ++running };
+		int seen{ peak.load() };
+		while (now > seen && !peak.compare_exchange_weak(seen, now))
+		{
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		--running;
+		++count;
+	}, { Task_Priority::normal, 2 });
+	EXPECT_LE(peak, 2);
+	EXPECT_EQ(count, 64);
+}
+
+/*
+Scenario: Higher priority tasks are taken before lower priority ones
+  Given pool ← thread_pool(1)
+	And the only worker is blocked by a task
+  When a low priority task and then a high priority task are submitted
+	And the worker is released
+  Then the high priority task runs first
+*/
+TEST(thread_pool, should_run_higher_priority_tasks_first)
+{
+	ThreadPool pool{ 1 };
+	std::promise<void> release;
+	std::shared_future<void> released{ release.get_future().share() };
+	std::packaged_task<void()> blocker{ [released]() { released.wait(); } };
+	std::future<void> blocked{ blocker.get_future() };
+	pool.submit(std::move(blocker));
+
+	std::mutex order_mutex;
+	std::vector<int> order;
+	std::packaged_task<void()> low{ [&]() { std::lock_guard<std::mutex> lk{ order_mutex }; order.push_back(0); } };
+	std::packaged_task<void()> high{ [&]() { std::lock_guard<std::mutex> lk{ order_mutex }; order.push_back(1); } };
+	std::future<void> low_done{ low.get_future() };
+	std::future<void> high_done{ high.get_future() };
+	pool.submit(std::move(low), Task_Priority::low);
+	pool.submit(std::move(high), Task_Priority::high);
+	release.set_value();
+	blocked.get();
+	low_done.get();
+	high_done.get();
+	EXPECT_EQ(order, (std::vector<int>{ 1, 0 }));
+}
+
+/*
+Scenario: Tasks without a range run the caller's callable after run returns
+  Given pool ← thread_pool(2)
+	And group ← task_group(pool)
+  When 64 tasks incrementing a counter are run, more than there are workers
+  Then group.wait() returns with the counter = 64
+*/
+TEST(thread_pool, should_run_queued_tasks_without_a_range)
+{
+	ThreadPool pool{ 2 };
+	std::atomic<int> counter{ 0 };
+	const auto count = [&counter]() {
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+		++counter;
+	};
+	TaskGroup group{ pool };
+	for (int i{ 0 }; i < 64; i++)
+	{
+		group.run(count);
+	}
+	group.wait();
+	EXPECT_EQ(counter, 64);
+}
@@ -0,0 +1,177 @@
+#include <cstdlib>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../tile_scheduler.h"
+
+/*
+Scenario: Scanline order cuts the image into clipped tiles row by row
+  Given s ← tile_scheduler(10, 7, 4, scanline, 1 worker)
+  Then s.tile_count() = 6
+	And the tiles are handed out row by row
+	And the last tile is (8, 10, 4, 7)
+*/
+TEST(tile_scheduler, should_hand_out_clipped_tiles_in_scanline_order)
+{
+	TileScheduler s{ 10, 7, 4, Tile_Order::scanline, 1 };
+	EXPECT_EQ(s.tile_count(), 6);
+	render_tile_t tile{};
+	std::size_t expected{ 0 };
+	while (s.next(tile))
+	{
+		EXPECT_EQ(tile.source, expected++);
+	}
+	EXPECT_EQ(expected, 6);
+	EXPECT_EQ(tile.x_start, 8);
+	EXPECT_EQ(tile.x_end, 10);
+	EXPECT_EQ(tile.y_start, 4);
+	EXPECT_EQ(tile.y_end, 7);
+}
+
+/*
+Scenario: Tiles are split when the queue drains but still cover every pixel once
+  Given s ← tile_scheduler(64, 64, 32, scanline, 4 workers)
+  When every tile is taken
+  Then more than 4 tiles were handed out
+	And every pixel is covered by exactly one tile
+*/
+TEST(tile_scheduler, should_split_tiles_at_the_tail_and_cover_every_pixel_once)
+{
+	TileScheduler s{ 64, 64, 32, Tile_Order::scanline, 4 };
+	std::vector<int> covered(64 * 64, 0);
+	render_tile_t tile{};
+	int handed_out{ 0 };
+	while (s.next(tile))
+	{
+		handed_out++;
+		for (int y{ tile.y_start }; y < tile.y_end; y++)
+		{
+			for (int x{ tile.x_start }; x < tile.x_end; x++)
+			{
+				covered[y * 64 + x]++;
+			}
+		}
+	}
+	EXPECT_GT(handed_out, 4);
+	for (const int count : covered)
+	{
+		EXPECT_EQ(count, 1);
+	}
+}
+
+/*
+Scenario: Spiral order starts in the centre of the image
+  Given s ← tile_scheduler(5, 5, 1, spiral, 1 worker)
+  Then the first tile is (2, 3, 2, 3)
+	And the next 8 tiles are neighbours of the centre
+*/
+TEST(tile_scheduler, should_start_spiral_order_in_the_centre)
+{
+	TileScheduler s{ 5, 5, 1, Tile_Order::spiral, 1 };
+	render_tile_t tile{};
+	ASSERT_TRUE(s.next(tile));
+	EXPECT_EQ(tile.x_start, 2);
+	EXPECT_EQ(tile.y_start, 2);
+	for (int i{ 0 }; i < 8; i++)
+	{
+		ASSERT_TRUE(s.next(tile));
+		EXPECT_LE(std::abs(tile.x_start - 2), 1);
+		EXPECT_LE(std::abs(tile.y_start - 2), 1);
+	}
+}
+
+/*
+Scenario: Consecutive tiles in Hilbert order are neighbours
+  Given s ← tile_scheduler(8, 8, 1, hilbert, 1 worker)
+  Then every tile shares an edge with the one before it
+*/
+TEST(tile_scheduler, should_hand_out_neighbouring_tiles_in_hilbert_order)
+{
+	TileScheduler s{ 8, 8, 1, Tile_Order::hilbert, 1 };
+	render_tile_t previous{};
+	ASSERT_TRUE(s.next(previous));
+	render_tile_t tile{};
+	int count{ 1 };
+	while (s.next(tile))
+	{
+		count++;
+		EXPECT_EQ(std::abs(tile.x_start - previous.x_start) + std::abs(tile.y_start - previous.y_start), 1);
+		previous = tile;
+	}
+	EXPECT_EQ(count, 64);
+}
+
+/*
+Scenario: Cost hints put the most expensive tiles first
+  Given s ← tile_scheduler(3, 1, 1, scanline, 1 worker, hints [1, 5, 3])
+  Then the tiles are handed out in the order 1, 2, 0
+*/
+TEST(tile_scheduler, should_hand_out_expensive_tiles_first)
+{
+	TileScheduler s{ 3, 1, 1, Tile_Order::scanline, 1, { 1.0, 5.0, 3.0 } };
+	render_tile_t tile{};
+	std::vector<std::size_t> order;
+	while (s.next(tile))
+	{
+		order.push_back(tile.source);
+	}
+	EXPECT_EQ(order, (std::vector<std::size_t>{ 1, 2, 0 }));
+}
+
+/*
+Scenario: The time of split tiles is added to their grid tile
+  Given s ← tile_scheduler(32, 32, 32, scanline, 2 workers)
+  When every tile is taken and completed in 0.5 seconds
+  Then s.costs() = [0.5 × number of tiles handed out]
+*/
+TEST(tile_scheduler, should_accumulate_costs_per_grid_tile)
+{
+	TileScheduler s{ 32, 32, 32, Tile_Order::scanline, 2 };
+	render_tile_t tile{};
+	int handed_out{ 0 };
+	while (s.next(tile))
+	{
+		handed_out++;
+		s.complete(tile, 0.5);
+	}
+	EXPECT_GT(handed_out, 1);
+	ASSERT_EQ(s.costs().size(), 1);
+	EXPECT_DOUBLE_EQ(s.costs()[0], 0.5 * handed_out);
+}
+
+/*
+Scenario: The remaining tiles include the quadrants of a split tile
+  Given s ← tile_scheduler(32, 32, 32, scanline, 2 workers)
+  Then s.remaining() = 1
+  When t ← s.next()
+  Then t is a quadrant of the grid tile
+	And s.remaining() = 3
+*/
+TEST(tile_scheduler, should_count_remaining_tiles_after_a_split)
+{
+	TileScheduler s{ 32, 32, 32, Tile_Order::scanline, 2 };
+	EXPECT_EQ(s.remaining(), 1);
+	render_tile_t tile{};
+	ASSERT_TRUE(s.next(tile));
+	EXPECT_EQ(tile.area(), 16 * 16);
+	EXPECT_EQ(s.remaining(), 3);
+}
+
+/*
+Scenario: Split tiles only cut columns on multiples of the split size
+  Given s ← tile_scheduler(48, 48, 48, scanline, 8 workers)
+  When every tile is taken
+  Then more than 1 tile was handed out
+	And every tile's x_start is a multiple of MIN_SPLIT_TILE_SIZE
+*/
+TEST(tile_scheduler, should_cut_split_tile_columns_on_cache_line_multiples)
+{
+	TileScheduler s{ 48, 48, 48, Tile_Order::scanline, 8 };
+	render_tile_t tile{};
+	int handed_out{ 0 };
+	while (s.next(tile))
+	{
+		handed_out++;
+		EXPECT_EQ(tile.x_start % MIN_SPLIT_TILE_SIZE, 0);
+	}
+	EXPECT_GT(handed_out, 1);
+}
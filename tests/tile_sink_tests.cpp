@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../tile_sink.h"
+#include "../render_manager.h"
+#include "../settings.h"
+
+static Camera test_camera()
+{
+	Camera c{ 11, 11, PI / 2 };
+	c.transform = matrix_t::view_transform(tuple_t::point(0, 0, -5), tuple_t::point(0, 0, 0), tuple_t::vector(0, 1, 0));
+	return c;
+}
+
+static std::string read_file(const std::string& path)
+{
+	std::ifstream in{ path, std::ios::binary };
+	return { std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{} };
+}
+
+/*
+Scenario: Rendering into a binary PPM file
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And writer ← streaming_image_writer(file, ppm, 4)
+  When rm.render_to(w, writer)
+  Then the file holds a P6 header and 11 × 11 pixels
+	And each pixel = rm.render(w) scaled to [0, 255]
+*/
+TEST(tile_sink, should_stream_a_render_to_a_binary_ppm)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	const std::string path{ (std::filesystem::temp_directory_path() / "tile_sink.ppm").string() };
+	StreamingImageWriter writer{ path, Image_Format::ppm, 4 };
+	rm.render_to(w, writer);
+
+	const std::string header{ "P6\n11 11\n255\n" };
+	const std::string data{ read_file(path) };
+	ASSERT_EQ(data.size(), header.size() + 11 * 11 * 3);
+	EXPECT_EQ(data.substr(0, header.size()), header);
+	const canvas_t expected{ rm.render(w) };
+	for (int y{ 0 }; y < 11; y++)
+	{
+		for (int x{ 0 }; x < 11; x++)
+		{
+			const std::size_t offset{ header.size() + (static_cast<std::size_t>(y) * 11 + x) * 3 };
+			const colour_t colour{ expected.pixel_at(x, y) };
+			EXPECT_EQ(static_cast<unsigned char>(data[offset]), std::clamp(static_cast<int>(std::round(colour.red * 255)), 0, 255));
+			EXPECT_EQ(static_cast<unsigned char>(data[offset + 1]), std::clamp(static_cast<int>(std::round(colour.green * 255)), 0, 255));
+			EXPECT_EQ(static_cast<unsigned char>(data[offset + 2]), std::clamp(static_cast<int>(std::round(colour.blue * 255)), 0, 255));
+		}
+	}
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: Rendering into a PFM file stores float rows bottom to top
+  Given w ← default_world()
+	And rm ← render_manager(camera(11, 11, π/2) looking at the origin, 4)
+	And writer ← streaming_image_writer(file, pfm, 4)
+  When rm.render_to(w, writer)
+  Then the file holds a PF header and 11 × 11 float pixels
+	And its first row is the bottom row of rm.render(w)
+*/
+TEST(tile_sink, should_stream_a_render_to_a_pfm)
+{
+	const World w{ World::default_world() };
+	RenderManager rm{ test_camera(), 4 };
+	const std::string path{ (std::filesystem::temp_directory_path() / "tile_sink.pfm").string() };
+	StreamingImageWriter writer{ path, Image_Format::pfm, 4 };
+	rm.render_to(w, writer);
+
+	const std::string header{ "PF\n11 11\n-1.0\n" };
+	const std::string data{ read_file(path) };
+	ASSERT_EQ(data.size(), header.size() + 11 * 11 * 3 * sizeof(float));
+	EXPECT_EQ(data.substr(0, header.size()), header);
+	const canvas_t expected{ rm.render(w) };
+	for (int y{ 0 }; y < 11; y++)
+	{
+		for (int x{ 0 }; x < 11; x++)
+		{
+			float rgb[3]{};
+			std::memcpy(rgb, data.data() + header.size() + ((10 - static_cast<std::size_t>(y)) * 11 + x) * sizeof(rgb), sizeof(rgb));
+			EXPECT_EQ(colour_t(rgb[0], rgb[1], rgb[2]), expected.pixel_at(x, y));
+		}
+	}
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: Rendering into a sink again keeps to scanline order whatever the cost hints
+  Given w ← default_world()
+	And rm ← render_manager(camera(16, 256, π/2) looking at the origin, 4)
+	And writer ← streaming_image_writer(file, ppm, 4)
+  When rm.render_to(w, writer)
+	And rm.render_to(w, writer) again with cost hints ordering the tiles column by column
+  Then both times the writer held less than a quarter of the image at once
+*/
+TEST(tile_sink, should_stream_in_scanline_order_on_later_renders)
+{
+	const World w{ World::default_world() };
+	Camera c{ 16, 256, PI / 2 };
+	c.transform = matrix_t::view_transform(tuple_t::point(0, 0, -5), tuple_t::point(0, 0, 0), tuple_t::vector(0, 1, 0));
+	RenderManager rm{ c, 4 };
+	const std::string path{ (std::filesystem::temp_directory_path() / "tile_sink_twice.ppm").string() };
+	StreamingImageWriter writer{ path, Image_Format::ppm, 4 };
+	const std::size_t image_bytes{ 16 * 256 * 3 };
+
+	rm.render_to(w, writer);
+	EXPECT_LT(writer.peak_buffered_bytes(), image_bytes / 4);
+
+	std::vector<double> costs(4 * 64);
+	// column by column, which would open every band before closing any
+	for (std::size_t i{ 0 }; i < costs.size(); i++) costs[i] = static_cast<double>((3 - i % 4) * costs.size() + costs.size() - i);
+	rm.set_cost_hints(costs);
+	rm.render_to(w, writer);
+	EXPECT_LT(writer.peak_buffered_bytes(), image_bytes / 4);
+	std::filesystem::remove(path);
+}
+
+/*
+Scenario: The writer only holds the bands tiles are arriving in
+  Given writer ← streaming_image_writer(file, ppm, 2)
+	And writer.begin(4, 8)
+  When the 2 × 2 tiles arrive band by band, right tile first
+  Then at most one band of 4 × 2 pixels was held at once
+	And finishing with a tile missing throws
+*/
+TEST(tile_sink, should_hold_only_incomplete_bands)
+{
+	const std::string path{ (std::filesystem::temp_directory_path() / "tile_sink_bands.ppm").string() };
+	const std::vector<colour_t> pixels(4, colour_t{ 1, 0.5, 0 });
+	StreamingImageWriter writer{ path, Image_Format::ppm, 2 };
+	writer.begin(4, 8);
+	for (int y{ 0 }; y < 8; y += 2)
+	{
+		writer.write_tile({ 2, 4, y, y + 2 }, pixels.data());
+		writer.write_tile({ 0, 2, y, y + 2 }, pixels.data());
+	}
+	writer.finish();
+	EXPECT_EQ(writer.peak_buffered_bytes(), 4 * 2 * 3);
+	EXPECT_EQ(read_file(path).size(), std::string{ "P6\n4 8\n255\n" }.size() + 4 * 8 * 3);
+
+	writer.begin(4, 8);
+	writer.write_tile({ 0, 2, 0, 2 }, pixels.data());
+	EXPECT_THROW(writer.finish(), std::runtime_error);
+	std::filesystem::remove(path);
+}
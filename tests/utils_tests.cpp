@@ -1,5 +1,6 @@
 ﻿#include <string>
 #include <vector>
+#include <cmath>
 #include "gtest/gtest.h"
 #include "../utils.h"
 
@@ -67,4 +68,21 @@ TEST(utils, should_parse_tokens_from_a_simulated_PPM_like_input)
     };
 
     EXPECT_EQ(tokens, expected);
-}
\ No newline at end of file
+}
+
+/*
+Scenario: Converting values to half floats and back
+  Given values ← [0, 1, -2, 0.5, 65504, 0.000061035156]
+  Then from_half(to_half(v)) = v for every v in values
+  And from_half(to_half(0.1)) ≈ 0.1 within 0.0001
+  And from_half(to_half(100000)) = infinity
+*/
+TEST(utils, should_round_trip_half_floats)
+{
+    for (const double v : { 0.0, 1.0, -2.0, 0.5, 65504.0, 0.000061035156250 })
+    {
+        EXPECT_EQ(from_half(to_half(v)), v);
+    }
+    EXPECT_NEAR(from_half(to_half(0.1)), 0.1, 0.0001);
+    EXPECT_TRUE(std::isinf(from_half(to_half(100000.0))));
+}
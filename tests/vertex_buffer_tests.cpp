@@ -0,0 +1,158 @@
+#include "gtest/gtest.h"
+#include "../vertex_buffer.h"
+#include "../wavefront_obj.h"
+#include "../mesh.h"
+#include "../intersection.h"
+
+/*
+Scenario: Welding identical face corners into a single vertex
+  Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
+  When vb ← vertex_buffer(w, true)
+  Then vb.vertices.size = 4
+	And vb.indices.size = 6
+	And vb.triangle_count() = 2
+	And vb.indices[0] = vb.indices[3]
+	And vb.indices[1] = vb.indices[5]
+*/
+TEST(vertex_buffer, should_weld_identical_vertices)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
+	const vertex_buffer_t vb{ w, true };
+	EXPECT_EQ(vb.vertices.size(), 4);
+	EXPECT_EQ(vb.indices.size(), 6);
+	EXPECT_EQ(vb.triangle_count(), 2);
+	EXPECT_EQ(vb.indices[0], vb.indices[3]);
+	EXPECT_EQ(vb.indices[1], vb.indices[5]);
+}
+
+/*
+Scenario: Near duplicate vertices are only welded with an epsilon
+  Given w ← wavefront("..\\..\\tests\\assets\\near.obj")
+  When exact ← vertex_buffer(w, false)
+	And welded ← vertex_buffer(w, false, 0.00001)
+  Then exact.vertices.size = 6
+	And welded.vertices.size = 4
+	And welded.indices[1] = welded.indices[3]
+	And welded.indices[2] = welded.indices[5]
+*/
+TEST(vertex_buffer, should_weld_near_vertices_within_epsilon)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\near.obj" };
+	const vertex_buffer_t exact{ w, false };
+	const vertex_buffer_t welded{ w, false, 0.00001 };
+	EXPECT_EQ(exact.vertices.size(), 6);
+	EXPECT_EQ(welded.vertices.size(), 4);
+	EXPECT_EQ(welded.indices[1], welded.indices[3]);
+	EXPECT_EQ(welded.indices[2], welded.indices[5]);
+}
+
+/*
+Scenario: Mesh triangles read uvs from the shared vertex buffer
+  Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
+  When m ← mesh(w, true)
+	And t ← m.triangles[0]
+  Then t.vertex_buffer = m.vertex_buffer
+	And t.vertex_uv(0) = (0.625, 0.75)
+	And t.vertex_uv(1) = (0.375, 1.0)
+	And t.vertex_uv(2) = (0.375, 0.75)
+*/
+TEST(vertex_buffer, should_be_shared_by_mesh_triangles)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
+	const auto m{ Mesh::create(w, true) };
+	const auto t{ std::dynamic_pointer_cast<MeshTriangle>(m->triangles[0]) };
+	EXPECT_EQ(t->vertex_buffer, m->vertex_buffer);
+	EXPECT_EQ(t->vertex_uv(0), std::make_pair(0.625, 0.75));
+	EXPECT_EQ(t->vertex_uv(1), std::make_pair(0.375, 1.0));
+	EXPECT_EQ(t->vertex_uv(2), std::make_pair(0.375, 0.75));
+}
+
+/*
+Scenario: Compressing a vertex buffer keeps attributes within tolerance
+  Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
+	And vb ← vertex_buffer(w, true)
+	And original ← copy of vb.vertices
+  When vb.compress()
+  Then vb.compressed = true
+	And vb.vertices is empty
+	And vb.vertex_count() = 4
+	And every vb.position(i), vb.normal(i), vb.uv(i) is within tolerance of original[i]
+	And vb.memory_usage() < original memory usage
+*/
+TEST(vertex_buffer, should_compress_vertices_within_tolerance)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
+	vertex_buffer_t vb{ w, true };
+	const std::vector<mesh_vertex_t> original{ vb.vertices };
+	const std::size_t full_size{ vb.memory_usage() };
+	vb.compress();
+	EXPECT_TRUE(vb.compressed);
+	EXPECT_TRUE(vb.vertices.empty());
+	ASSERT_EQ(vb.vertex_count(), 4);
+	for (std::uint32_t i{ 0 }; i < 4; i++)
+	{
+		const tuple_t p{ vb.position(i) };
+		EXPECT_NEAR(p.x, original[i].position.x, 0.0001);
+		EXPECT_NEAR(p.y, original[i].position.y, 0.0001);
+		EXPECT_NEAR(p.z, original[i].position.z, 0.0001);
+		const tuple_t n{ vb.normal(i) };
+		EXPECT_NEAR(n.x, original[i].normal.x, 0.0001);
+		EXPECT_NEAR(n.y, original[i].normal.y, 0.0001);
+		EXPECT_NEAR(n.z, original[i].normal.z, 0.0001);
+		EXPECT_NEAR(vb.uv(i).first, original[i].uv.first, 0.001);
+		EXPECT_NEAR(vb.uv(i).second, original[i].uv.second, 0.001);
+	}
+	EXPECT_LT(vb.memory_usage(), full_size);
+}
+
+/*
+Scenario: A mesh can be created with a compressed vertex buffer
+  Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
+  When m ← mesh(w, true, 128, 0, true)
+	And t ← m.triangles[0]
+  Then m.vertex_buffer.compressed = true
+	And t.vertex_normal(0) ≈ vector(0, 0, 1)
+	And t.vertex_position(0) ≈ point(1, 1, 1)
+*/
+TEST(vertex_buffer, should_be_compressed_by_mesh_create)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
+	const auto m{ Mesh::create(w, true, 128, 0, true) };
+	EXPECT_TRUE(m->vertex_buffer->compressed);
+	const auto t{ std::dynamic_pointer_cast<MeshTriangle>(m->triangles[0]) };
+	const tuple_t n{ t->vertex_normal(0).value() };
+	EXPECT_NEAR(n.x, 0, 0.0001);
+	EXPECT_NEAR(n.y, 0, 0.0001);
+	EXPECT_NEAR(n.z, 1, 0.0001);
+	const tuple_t p{ t->vertex_position(0) };
+	EXPECT_NEAR(p.x, 1, 0.0001);
+	EXPECT_NEAR(p.y, 1, 0.0001);
+	EXPECT_NEAR(p.z, 1, 0.0001);
+}
+
+/*
+Scenario: A compressed mesh is intersected from its quantised vertices
+  Given w ← wavefront("..\\..\\tests\\assets\\face.obj")
+	And full ← mesh(w, true, 128, 0, false)
+	And packed ← mesh(w, true, 128, 0, true)
+	And r ← ray(point(0.5, 0.25, -5), vector(0, 0, 1))
+  When xs ← intersect(packed, r)
+  Then xs.count = intersect(full, r).count
+	And xs[0].t ≈ intersect(full, r)[0].t
+	And packed.memory_usage() < full.memory_usage()
+*/
+TEST(vertex_buffer, should_intersect_compressed_meshes_from_quantised_vertices)
+{
+	const wavefront_t w{ "..\\..\\tests\\assets\\face.obj" };
+	const auto full{ Mesh::create(w, true, 128, 0, false) };
+	const auto packed{ Mesh::create(w, true, 128, 0, true) };
+	const ray_t r{ tuple_t::point(0.5, 0.25, -5), tuple_t::vector(0, 0, 1) };
+	intersections_t full_xs{};
+	intersections_t packed_xs{};
+	full->local_intersect(r, full_xs);
+	packed->local_intersect(r, packed_xs);
+	ASSERT_EQ(packed_xs.entries.size(), full_xs.entries.size());
+	ASSERT_GT(packed_xs.entries.size(), 0);
+	EXPECT_NEAR(packed_xs.entries[0].time, full_xs.entries[0].time, 0.0001);
+	EXPECT_LT(packed->memory_usage(), full->memory_usage());
+}
@@ -1,4 +1,7 @@
-﻿#include "gtest/gtest.h"
+﻿#include <filesystem>
+#include <fstream>
+#include <string>
+#include "gtest/gtest.h"
 #include "../wavefront_obj.h"
 #include "../tuple.h"
 
@@ -134,3 +137,96 @@ TEST(wavefront_obj, should_read_face_values)
 	EXPECT_EQ(w.faces[0].b_normal, 1);
 	EXPECT_EQ(w.faces[0].c_normal, 1);
 }
+
+/*
+Scenario: Reading face values with relative indices from obj file
+  Given filepath ← "./assets/relative.obj"
+  When w ← wavefront_t(filepath)
+  Then w.faces.size() = 2
+	And w.faces[0] = (1/1/1, 3/3/1, 2/2/1)
+	And w.faces[1] = (2/2/1, 4/4/1, 3/3/1)
+*/
+TEST(wavefront_obj, should_resolve_relative_face_indices)
+{
+
+	const wavefront_t w{ "..\\..\\tests\\assets\\relative.obj" };
+	EXPECT_EQ(w.faces.size(), 2);
+	EXPECT_EQ(w.faces[0].a, 1);
+	EXPECT_EQ(w.faces[0].b, 3);
+	EXPECT_EQ(w.faces[0].c, 2);
+	EXPECT_EQ(w.faces[0].b_uv, 3);
+	EXPECT_EQ(w.faces[0].c_normal, 1);
+	EXPECT_EQ(w.faces[1].b, 4);
+	EXPECT_EQ(w.faces[1].b_uv, 4);
+	EXPECT_EQ(w.faces[1].b_normal, 1);
+}
+
+/*
+Scenario: Parsing with multiple threads matches a single threaded parse
+  Given filepath ← "./assets/cube.obj"
+  When w1 ← wavefront_t(filepath, 1)
+	And w4 ← wavefront_t(filepath, 4)
+  Then w1.vertices = w4.vertices
+	And w1.vertex_normals_avg = w4.vertex_normals_avg
+	And w1.faces.size() = w4.faces.size()
+*/
+TEST(wavefront_obj, should_parse_identically_for_any_thread_count)
+{
+
+	const wavefront_t w1{ "..\\..\\tests\\assets\\cube.obj", 1 };
+	const wavefront_t w4{ "..\\..\\tests\\assets\\cube.obj", 4 };
+	EXPECT_EQ(w1.vertices, w4.vertices);
+	EXPECT_EQ(w1.vertex_normals_avg, w4.vertex_normals_avg);
+	EXPECT_EQ(w1.faces.size(), w4.faces.size());
+}
+
+/*
+Scenario: Parsing a file split into several chunks matches a single threaded parse
+  Given file ← an obj over 4 MiB whose faces mix absolute and relative indices,
+	  relative ones reaching back across the chunk boundaries
+  When w1 ← wavefront_t(file, 1)
+	And w4 ← wavefront_t(file, 4)
+  Then w1 and w4 hold the same vertices, uvs, faces and averaged normals
+*/
+TEST(wavefront_obj, should_merge_chunks_identically_for_any_thread_count)
+{
+	const std::string path{ (std::filesystem::temp_directory_path() / "wavefront_chunks.obj").string() };
+	{
+		std::ofstream out{ path, std::ios::binary };
+		for (int block{ 0 }; block < 32000; block++)
+		{
+			// every line of a block may fall either side of a chunk boundary
+			for (int i{ 0 }; i < 3; i++)
+			{
+				out << "v " << block * 0.001 << ' ' << i << ' ' << (block % 7) * 0.5 << '\n';
+				out << "vt " << i * 0.25 << ' ' << (block % 11) * 0.0625 << '\n';
+			}
+			out << "vn " << (block % 3) << ' ' << 1 << ' ' << (block % 5) << '\n';
+			out << "f -3/-3/-1 -2/-2/-1 -1/-1/-1\n";
+			// shares the first vertex of the file, so its normals are averaged over every chunk
+			out << "f 1/1/1 -1/-1/-1 -2/-2/-1\n";
+		}
+	}
+	ASSERT_GT(std::filesystem::file_size(path), 4u << 20);
+
+	const wavefront_t w1{ path.c_str(), 1 };
+	const wavefront_t w4{ path.c_str(), 4 };
+	EXPECT_EQ(w1.vertices, w4.vertices);
+	EXPECT_EQ(w1.uvs, w4.uvs);
+	EXPECT_EQ(w1.vertex_normals_avg, w4.vertex_normals_avg);
+	ASSERT_EQ(w1.faces.size(), w4.faces.size());
+	ASSERT_EQ(w1.faces.size(), 64000u);
+	for (std::size_t i{ 0 }; i < w1.faces.size(); i++)
+	{
+		const std::size_t block{ i / 2 };
+		const int last{ static_cast<int>(block) * 3 + 3 };
+		EXPECT_EQ(w4.faces[i].a, i % 2 == 0 ? last - 2 : 1);
+		EXPECT_EQ(w4.faces[i].b, i % 2 == 0 ? last - 1 : last);
+		EXPECT_EQ(w4.faces[i].c, i % 2 == 0 ? last : last - 1);
+		EXPECT_EQ(w4.faces[i].a_uv, w1.faces[i].a_uv);
+		EXPECT_EQ(w4.faces[i].c_uv, w1.faces[i].c_uv);
+		EXPECT_EQ(w4.faces[i].b_normal, i % 2 == 0 ? static_cast<int>(block) + 1 : w1.faces[i].b_normal);
+		EXPECT_EQ(w4.faces[i].a_normal, w1.faces[i].a_normal);
+	}
+	std::filesystem::remove(path);
+}
@@ -1,4 +1,5 @@
 ﻿#include <memory>
+#include <stdexcept>
 #include "gtest/gtest.h"
 #include "../world.h"
 #include "../matrix.h"
@@ -686,4 +687,81 @@ TEST(world, should_return_false_when_object_has_cast_shadows_off)
     EXPECT_FALSE(w.is_shadowed(p2, w.lights[0].lock()->position()));
     EXPECT_FALSE(w.is_shadowed(p3, w.lights[0].lock()->position()));
     EXPECT_FALSE(w.is_shadowed(p4, w.lights[0].lock()->position()));
-}
\ No newline at end of file
+}
+
+/*
+Scenario: Edits reported to the world are tracked until cleared
+  Given w ← default_world()
+  Then w.needs_full_render() = true
+  When w.clear_changes()
+	And w.mark_changed(first object)
+  Then w.needs_full_render() = false
+	And w.changed_objects() contains 0 but not 1
+  When w.mark_changed(the light)
+  Then w.needs_full_render() = true
+*/
+TEST(world, should_track_changes_to_objects)
+{
+    World w{ World::default_world() };
+    EXPECT_TRUE(w.needs_full_render());
+    w.clear_changes();
+    EXPECT_FALSE(w.needs_full_render());
+    w.mark_changed(w.scene_objects[0]);
+    EXPECT_FALSE(w.needs_full_render());
+    EXPECT_TRUE(w.changed_objects().test(0));
+    EXPECT_FALSE(w.changed_objects().test(1));
+    w.mark_changed(w.scene_objects[2]);
+    EXPECT_TRUE(w.needs_full_render());
+    EXPECT_THROW(w.mark_changed(Sphere::create()), std::invalid_argument);
+}
+
+/*
+Scenario: Objects hit by rays are recorded while a touch mask is set
+  Given w ← default_world()
+	And r ← ray(point(0, 0, -5), vector(0, 0, 1))
+  When w.record_touched(mask)
+	And intersect(w, r)
+  Then mask contains 0 and 1
+*/
+TEST(world, should_record_touched_objects)
+{
+    const World w{ World::default_world() };
+    object_mask_t mask;
+    World::record_touched(&mask);
+    intersections_t xs{};
+    w.intersect({ tuple_t::point(0, 0, -5), tuple_t::vector(0, 0, 1) }, xs);
+    World::record_touched(nullptr);
+    EXPECT_TRUE(mask.test(0));
+    EXPECT_TRUE(mask.test(1));
+    EXPECT_FALSE(mask.test(2));
+}
+
+/*
+Scenario: A nested touch mask hands recording back to the outer one
+  Given w ← default_world()
+	And r ← ray(point(0, 0, -5), vector(0, 0, 1))
+  When w.record_touched(outer)
+	And previous ← w.record_touched(inner)
+	And w.record_touched(previous)
+	And intersect(w, r)
+  Then previous = outer
+	And outer contains 0 and 1
+	And inner is empty
+*/
+TEST(world, should_restore_the_outer_touch_mask)
+{
+    const World w{ World::default_world() };
+    object_mask_t outer;
+    object_mask_t inner;
+    World::record_touched(&outer);
+    object_mask_t* previous{ World::record_touched(&inner) };
+    World::record_touched(previous);
+    intersections_t xs{};
+    w.intersect({ tuple_t::point(0, 0, -5), tuple_t::vector(0, 0, 1) }, xs);
+    EXPECT_EQ(World::record_touched(nullptr), &outer);
+    EXPECT_EQ(previous, &outer);
+    EXPECT_TRUE(outer.test(0));
+    EXPECT_TRUE(outer.test(1));
+    EXPECT_FALSE(inner.test(0));
+    EXPECT_FALSE(inner.test(1));
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include "texture.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Width and height of a block in texels.
+ */
+static constexpr int TEXTURE_BLOCK{ 4 };
+
+/**
+ * @brief Alignment of the block storage.
+ */
+static constexpr std::size_t TEXTURE_ALIGNMENT{ 64 };
+
+static std::size_t format_block_size(const Texture_Format format)
+{
+	switch (format)
+	{
+	case Texture_Format::rgba8: return TEXTURE_BLOCK * TEXTURE_BLOCK * 4;
+	case Texture_Format::bc1: return 8;
+	default: return TEXTURE_BLOCK * TEXTURE_BLOCK * 3 * sizeof(float);
+	}
+}
+
+/**
+ * @brief Quantizes a channel in [0, 1] to an integer in [0, max].
+ */
+static unsigned quantize(const double value, const unsigned max)
+{
+	return static_cast<unsigned>(std::lround(std::clamp(value, 0.0, 1.0) * max));
+}
+
+/**
+ * @brief Packs a colour into RGB565.
+ */
+static std::uint16_t to_565(const colour_t& colour)
+{
+	return static_cast<std::uint16_t>(quantize(colour.red, 31) << 11 | quantize(colour.green, 63) << 5 | quantize(colour.blue, 31));
+}
+
+/**
+ * @brief Expands an RGB565 colour.
+ */
+static colour_t from_565(const std::uint16_t packed)
+{
+	return { (packed >> 11 & 31) / 31.0, (packed >> 5 & 63) / 63.0, (packed & 31) / 31.0 };
+}
+
+/**
+ * @brief Fills the 4 colours of a BC1 block from its endpoints.
+ *
+ * With c0 > c1 the two middle colours lie a third of the way between the endpoints,
+ * otherwise the block has one middle colour and black.
+ */
+static void bc1_palette(const std::uint16_t c0, const std::uint16_t c1, colour_t palette[4])
+{
+	palette[0] = from_565(c0);
+	palette[1] = from_565(c1);
+	const auto mix{ [](const colour_t& a, const colour_t& b, const double t) {
+		return colour_t{ a.red + (b.red - a.red) * t, a.green + (b.green - a.green) * t, a.blue + (b.blue - a.blue) * t };
+	} };
+	if (c0 > c1)
+	{
+		palette[2] = mix(palette[0], palette[1], 1.0 / 3);
+		palette[3] = mix(palette[0], palette[1], 2.0 / 3);
+	}
+	else
+	{
+		palette[2] = mix(palette[0], palette[1], 0.5);
+		palette[3] = colour_t{ 0, 0, 0 };
+	}
+}
+
+/**
+ * @brief Compresses 16 texels into a BC1 block.
+ *
+ * The endpoints are the corners of the texels' bounding box, inset by a sixteenth of
+ * its size so the rounding of the endpoints does not push the palette outwards, and
+ * each texel takes the nearest of the 4 palette colours.
+ */
+static void encode_bc1(const colour_t texels[16], std::uint8_t* block)
+{
+	colour_t low{ 1, 1, 1 };
+	colour_t high{ 0, 0, 0 };
+	for (int i{ 0 }; i < 16; i++)
+	{
+		low = { std::min(low.red, texels[i].red), std::min(low.green, texels[i].green), std::min(low.blue, texels[i].blue) };
+		high = { std::max(high.red, texels[i].red), std::max(high.green, texels[i].green), std::max(high.blue, texels[i].blue) };
+	}
+	const colour_t inset{ (high.red - low.red) / 16, (high.green - low.green) / 16, (high.blue - low.blue) / 16 };
+	std::uint16_t c0{ to_565({ high.red - inset.red, high.green - inset.green, high.blue - inset.blue }) };
+	std::uint16_t c1{ to_565({ low.red + inset.red, low.green + inset.green, low.blue + inset.blue }) };
+	if (c0 < c1)
+	{
+		std::swap(c0, c1);
+	}
+
+	std::uint32_t indices{ 0 };
+	if (c0 != c1)
+	{
+		colour_t palette[4];
+		bc1_palette(c0, c1, palette);
+		for (int i{ 0 }; i < 16; i++)
+		{
+			unsigned best{ 0 };
+			double best_distance{ INFINITY };
+			for (unsigned p{ 0 }; p < 4; p++)
+			{
+				const double r{ texels[i].red - palette[p].red };
+				const double g{ texels[i].green - palette[p].green };
+				const double b{ texels[i].blue - palette[p].blue };
+				const double distance{ r * r + g * g + b * b };
+				if (distance < best_distance)
+				{
+					best = p;
+					best_distance = distance;
+				}
+			}
+			indices |= best << (2 * i);
+		}
+	}
+	// little endian, as in the BC1 format
+	block[0] = static_cast<std::uint8_t>(c0);
+	block[1] = static_cast<std::uint8_t>(c0 >> 8);
+	block[2] = static_cast<std::uint8_t>(c1);
+	block[3] = static_cast<std::uint8_t>(c1 >> 8);
+	for (int i{ 0 }; i < 4; i++)
+	{
+		block[4 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+	}
+}
+
+Texture::Texture(const canvas_t& image, const Texture_Format format)
+	: width{ std::max(image.width, 0) }, height{ std::max(image.height, 0) }, format{ format }
+{
+	blocks_x = static_cast<std::size_t>(width + TEXTURE_BLOCK - 1) / TEXTURE_BLOCK;
+	const std::size_t blocks_y{ static_cast<std::size_t>(height + TEXTURE_BLOCK - 1) / TEXTURE_BLOCK };
+	block_size = format_block_size(format);
+	size = blocks_x * blocks_y * block_size;
+	const std::size_t allocation{ (std::max<std::size_t>(size, 1) + TEXTURE_ALIGNMENT - 1) / TEXTURE_ALIGNMENT * TEXTURE_ALIGNMENT };
+	storage = std::shared_ptr<std::uint8_t[]>{
+		static_cast<std::uint8_t*>(::operator new[](allocation, std::align_val_t{ TEXTURE_ALIGNMENT })),
+		[](std::uint8_t* p) { ::operator delete[](p, std::align_val_t{ TEXTURE_ALIGNMENT }); }
+	};
+	std::memset(storage.get(), 0, allocation);
+
+	ThreadPool::shared().parallel_for(0, blocks_y, 1, [this, &image](std::size_t begin, std::size_t end) {
+		colour_t texels[TEXTURE_BLOCK * TEXTURE_BLOCK];
+		for (std::size_t by{ begin }; by < end; by++)
+		{
+			for (std::size_t bx{ 0 }; bx < blocks_x; bx++)
+			{
+				// blocks past the edge of the image repeat its last row and column
+				for (int i{ 0 }; i < TEXTURE_BLOCK * TEXTURE_BLOCK; i++)
+				{
+					const int x{ std::min(static_cast<int>(bx) * TEXTURE_BLOCK + i % TEXTURE_BLOCK, width - 1) };
+					const int y{ std::min(static_cast<int>(by) * TEXTURE_BLOCK + i / TEXTURE_BLOCK, height - 1) };
+					texels[i] = image.pixel_at(x, y);
+				}
+				std::uint8_t* block{ storage.get() + (by * blocks_x + bx) * block_size };
+				if (this->format == Texture_Format::bc1)
+				{
+					encode_bc1(texels, block);
+					continue;
+				}
+				for (int i{ 0 }; i < TEXTURE_BLOCK * TEXTURE_BLOCK; i++)
+				{
+					if (this->format == Texture_Format::rgba8)
+					{
+						block[i * 4] = static_cast<std::uint8_t>(quantize(texels[i].red, 255));
+						block[i * 4 + 1] = static_cast<std::uint8_t>(quantize(texels[i].green, 255));
+						block[i * 4 + 2] = static_cast<std::uint8_t>(quantize(texels[i].blue, 255));
+						block[i * 4 + 3] = static_cast<std::uint8_t>(quantize(texels[i].alpha, 255));
+					}
+					else
+					{
+						const float rgb[3]{ static_cast<float>(texels[i].red), static_cast<float>(texels[i].green), static_cast<float>(texels[i].blue) };
+						std::memcpy(block + i * sizeof(rgb), rgb, sizeof(rgb));
+					}
+				}
+			}
+		}
+	});
+}
+
+colour_t Texture::pixel_at(const int x, const int y) const
+{
+	if (x < 0 || y < 0 || x >= width || y >= height)
+	{
+		return { 0, 0, 0 };
+	}
+	const std::uint8_t* block{ block_address(x, y) };
+	const int texel{ (y % TEXTURE_BLOCK) * TEXTURE_BLOCK + x % TEXTURE_BLOCK };
+	switch (format)
+	{
+	case Texture_Format::rgba8:
+	{
+		const std::uint8_t* rgba{ block + texel * 4 };
+		return { rgba[0] / 255.0, rgba[1] / 255.0, rgba[2] / 255.0, rgba[3] / 255.0 };
+	}
+	case Texture_Format::bc1:
+	{
+		const std::uint16_t c0{ static_cast<std::uint16_t>(block[0] | block[1] << 8) };
+		const std::uint16_t c1{ static_cast<std::uint16_t>(block[2] | block[3] << 8) };
+		const unsigned index{ static_cast<unsigned>(block[4 + texel / 4] >> (2 * (texel % 4))) & 3u };
+		colour_t palette[4];
+		bc1_palette(c0, c1, palette);
+		return palette[index];
+	}
+	default:
+	{
+		float rgb[3]{};
+		std::memcpy(rgb, block + texel * sizeof(rgb), sizeof(rgb));
+		return { rgb[0], rgb[1], rgb[2] };
+	}
+	}
+}
+
+std::size_t Texture::memory_size() const
+{
+	return size;
+}
+
+const std::uint8_t* Texture::block_address(const int x, const int y) const
+{
+	return storage.get() + (static_cast<std::size_t>(y / TEXTURE_BLOCK) * blocks_x + x / TEXTURE_BLOCK) * block_size;
+}
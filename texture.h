@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "canvas.h"
+#include "colour.h"
+
+/**
+ * @brief How a `Texture` stores its texels.
+ */
+enum class Texture_Format
+{
+    rgb_float,  ///< Three 32-bit floats (12 bytes per texel), alpha is dropped.
+    rgba8,      ///< 8 bits per channel (4 bytes per texel), clamped to [0, 1], lossless for 8-bit PPM files.
+    bc1         ///< BC1 (DXT1) blocks: two RGB565 endpoints and 2-bit indices (half a byte per texel), alpha is dropped.
+};
+
+/**
+ * @class Texture
+ * @brief A read-only image stored in 4x4 texel blocks, for texture lookups.
+ *
+ * Each block is stored contiguously and blocks follow each other row by row, so the
+ * texels around a lookup share one or a few cache lines whichever direction the UV
+ * coordinates move in (an 8-bit block is exactly one cache line). The BC1 format
+ * compresses each block into 8 bytes, 64 times smaller than a `colour_t` canvas;
+ * texels are decoded in `pixel_at`.
+ *
+ * Copies share the texels, which are never modified after construction.
+ */
+class Texture
+{
+public:
+    /** @brief Width of the texture in texels. */
+    int width;
+
+    /** @brief Height of the texture in texels. */
+    int height;
+
+    /** @brief How the texels are stored. */
+    Texture_Format format;
+
+    /**
+     * @brief Encodes an image into a texture, block rows in parallel on the shared pool.
+     *
+     * @param image The texels.
+     * @param format The storage format.
+     */
+    Texture(const canvas_t& image, const Texture_Format format);
+
+    /**
+     * @brief Returns the decoded colour of a texel.
+     *
+     * @param x Column of the texel.
+     * @param y Row of the texel.
+     * @return colour_t The colour, black outside the texture.
+     */
+    colour_t pixel_at(const int x, const int y) const;
+
+    /**
+     * @brief Returns the number of bytes the texels take up.
+     */
+    std::size_t memory_size() const;
+
+private:
+    /**
+     * @brief Returns the address of the block holding a texel.
+     */
+    const std::uint8_t* block_address(const int x, const int y) const;
+
+    std::size_t blocks_x;                       ///< Number of blocks per block row.
+    std::size_t block_size;                     ///< Bytes per block.
+    std::size_t size;                           ///< Bytes of all blocks.
+    std::shared_ptr<std::uint8_t[]> storage;    ///< The blocks, aligned to a cache line.
+};
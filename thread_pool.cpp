@@ -1,45 +1,290 @@
+#include <stdexcept>
 #include "thread_pool.h"
 
-void ThreadPool::worker_thread()
+void pool_task_t::operator()()
 {
+	if (packaged)
+	{
+		// a packaged task reports exceptions through its future
+		(*packaged)();
+		return;
+	}
+	if (!group)
+	{
+		// a runner task reports completion of the tasks it runs itself
+		invoke(context, begin, end);
+		return;
+	}
+	std::exception_ptr error;
+	try
+	{
+		invoke(context, begin, end);
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	group->finish(error);
+}
+
+// Pool and queue index of the current thread, if it is a worker
+static thread_local const ThreadPool* current_pool{ nullptr };
+static thread_local unsigned current_index{ 0 };
+
+void ThreadPool::worker_thread(unsigned index)
+{
+	current_pool = this;
+	current_index = index;
 	while (!done)
 	{
-		std::packaged_task<void()> task;
-		if (work_queue.try_pop(task))
+		task_type task;
+		if (take_task(index, task))
 		{
 			task(); // Execute the task
+			continue;
 		}
-		else
+
+		// Nothing to run or steal, park until a task is submitted
+		std::unique_lock<std::mutex> lk{ park_mutex };
+		park_cond.wait(lk, [this] { return done || pending > 0; });
+	}
+}
+
+bool ThreadPool::take_task(unsigned index, task_type& task)
+{
+	const unsigned count{ worker_count };
+	for (std::size_t priority{ 0 }; priority < TASK_PRIORITY_COUNT; ++priority)
+	{
+		for (unsigned i{ 0 }; i < count; ++i)
 		{
-			std::this_thread::yield();
+			const unsigned worker{ (index + i) % count };
+			auto& queue{ *queues[worker * TASK_PRIORITY_COUNT + priority] };
+			const bool found{ i == 0 ? queue.try_pop(task) : queue.try_steal(task) };
+			if (found)
+			{
+				--pending;
+				return true;
+			}
 		}
 	}
+	return false;
+}
+
+/**
+ * @brief Resolves a requested worker count, 0 meaning one per hardware thread.
+ */
+static unsigned resolve_thread_count(unsigned thread_count)
+{
+	if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+	return thread_count == 0 ? 1 : thread_count;
 }
 
-ThreadPool::ThreadPool()
-	: done{ false }, threads{}, joiner { threads }
+ThreadPool::ThreadPool(unsigned thread_count)
+	: done{ false }, worker_count{ resolve_thread_count(thread_count) }, threads{}, joiner { threads }
 {
-	const unsigned thread_count{ std::thread::hardware_concurrency() };
+	// the queues must all exist before any worker starts stealing, and `threads` must
+	// not reallocate while the workers already started run
+	queues.reserve(worker_count * TASK_PRIORITY_COUNT);
+	for (std::size_t i{ 0 }; i < worker_count * TASK_PRIORITY_COUNT; ++i)
+	{
+		queues.push_back(std::make_unique<WorkStealingQueue<task_type>>());
+	}
+	threads.reserve(worker_count);
 	try
 	{
-		for (unsigned i{ 0 }; i < thread_count; ++i)
+		for (unsigned i{ 0 }; i < worker_count; ++i)
 		{
-			threads.push_back(std::thread(&ThreadPool::worker_thread, this));
+			threads.push_back(std::thread(&ThreadPool::worker_thread, this, i));
 		}
 	}
 	catch (...)
 	{
 		done = true;
+		park_cond.notify_all();
 		throw;
 	}
 }
 
 ThreadPool::~ThreadPool()
 {
-	done = true;
+	{
+		std::lock_guard<std::mutex> lk{ park_mutex };
+		done = true;
+	}
+	park_cond.notify_all();
+}
+
+// Size of the shared pool, and whether it has been created, guarded by shared_config_mutex
+static std::mutex shared_config_mutex;
+static unsigned shared_thread_count{ 0 };
+static bool shared_created{ false };
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool{ []() {
+		std::lock_guard<std::mutex> lk{ shared_config_mutex };
+		shared_created = true;
+		return shared_thread_count;
+	}() };
+	return pool;
+}
+
+void ThreadPool::configure_shared(unsigned thread_count)
+{
+	std::lock_guard<std::mutex> lk{ shared_config_mutex };
+	if (shared_created)
+	{
+		throw std::logic_error("The shared thread pool is already running");
+	}
+	shared_thread_count = thread_count;
+}
+
+void ThreadPool::submit(std::packaged_task<void()> task, Task_Priority priority)
+{
+	task_type wrapped{};
+	wrapped.packaged = std::make_unique<std::packaged_task<void()>>(std::move(task));
+	push_task(std::move(wrapped), priority);
+}
+
+void ThreadPool::push_task(task_type task, Task_Priority priority)
+{
+	const unsigned worker{ current_pool == this ? current_index : next_queue++ % thread_count() };
+	// counted before it is queued so a thief never sees the count go negative
+	++pending;
+	queues[worker * TASK_PRIORITY_COUNT + static_cast<std::size_t>(priority)]->push(std::move(task));
+
+	// taking the lock orders the increment before a parking worker's check of `pending`
+	{
+		std::lock_guard<std::mutex> lk{ park_mutex };
+	}
+	park_cond.notify_one();
+}
+
+bool ThreadPool::run_pending_task()
+{
+	task_type task;
+	if (!take_task(current_pool == this ? current_index : 0, task)) return false;
+	task();
+	return true;
+}
+
+unsigned ThreadPool::thread_count() const
+{
+	return worker_count;
+}
+
+
+TaskGroup::TaskGroup(ThreadPool& pool, const job_options_t& options)
+	: pool{ pool }, options{ options }
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	try
+	{
+		wait();
+	}
+	catch (...)
+	{
+	}
+}
+
+void TaskGroup::enqueue(pool_task_t task)
+{
+	if (options.max_concurrency == 0)
+	{
+		pool.push_task(std::move(task), options.priority);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lk{ backlog_mutex };
+	backlog.push_back(std::move(task));
+	if (runners < options.max_concurrency)
+	{
+		// the runner counts as outstanding until it retires so the group outlives it
+		++runners;
+		++outstanding;
+		pool_task_t runner{};
+		runner.invoke = [](const void* context, std::size_t, std::size_t) {
+			static_cast<TaskGroup*>(const_cast<void*>(context))->drain();
+		};
+		runner.context = this;
+		pool.push_task(std::move(runner), options.priority);
+	}
 }
 
-void ThreadPool::submit(std::packaged_task<void()> task)
+void TaskGroup::drain()
 {
-	work_queue.push(std::move(task));
-}
\ No newline at end of file
+	pool_task_t task{};
+	bool more{ true };
+	{
+		std::lock_guard<std::mutex> lk{ backlog_mutex };
+		if (backlog.empty())
+		{
+			--runners;
+			more = false;
+		}
+		else
+		{
+			task = std::move(backlog.front());
+			backlog.pop_front();
+		}
+	}
+	while (more)
+	{
+		std::exception_ptr error;
+		try
+		{
+			task.invoke(task.context, task.begin, task.end);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		// take the next task (or retire) before reporting this one
+		{
+			std::lock_guard<std::mutex> lk{ backlog_mutex };
+			if (backlog.empty())
+			{
+				--runners;
+				more = false;
+			}
+			else
+			{
+				task = std::move(backlog.front());
+				backlog.pop_front();
+			}
+		}
+		finish(error);
+	}
+	// retiring is the runner's last access to the group
+	finish(nullptr);
+}
+
+void TaskGroup::finish(std::exception_ptr error)
+{
+	// completion is recorded under the lock so that once `wait` sees zero no task
+	// touches the group any more and it can safely be destroyed
+	std::lock_guard<std::mutex> lk{ mut };
+	if (error && !first_error) first_error = error;
+	if (--outstanding == 0) done_cond.notify_all();
+}
+
+void TaskGroup::wait()
+{
+	// help with queued work (ours or anyone's) while our tasks are outstanding
+	while (outstanding > 0 && pool.run_pending_task())
+	{
+	}
+
+	std::unique_lock<std::mutex> lk{ mut };
+	done_cond.wait(lk, [this] { return outstanding == 0; });
+	if (first_error)
+	{
+		std::exception_ptr error{ first_error };
+		first_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
@@ -1,18 +1,101 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <thread>
 #include <functional>
 #include <future>
-#include "threadsafe_queue.h"
+#include "work_stealing_queue.h"
 #include "join_threads.h"
 
+class TaskGroup;
+
+/**
+ * @enum Task_Priority
+ * @brief Order in which workers pick up queued work.
+ *
+ * A worker always takes the highest priority task queued anywhere in the pool
+ * before a lower priority one, e.g. so an interactive preview is not starved by
+ * a final render running at the same time.
+ */
+enum class Task_Priority
+{
+    high,   ///< Interactive work such as previews
+    normal, ///< Default priority
+    low     ///< Background work such as final renders or cache warming
+};
+
+/** @brief Number of Task_Priority levels. */
+inline constexpr std::size_t TASK_PRIORITY_COUNT{ 3 };
+
+/**
+ * @struct job_options_t
+ * @brief Scheduling options of a job (a TaskGroup or parallel_for) on the shared pool.
+ */
+struct job_options_t
+{
+    /** @brief Priority of the job's tasks. */
+    Task_Priority priority{ Task_Priority::normal };
+
+    /** @brief Maximum number of the job's tasks running at once (0 means no limit). */
+    unsigned max_concurrency{ 0 };
+};
+
+/**
+ * @struct pool_task_t
+ * @brief A unit of work queued on a ThreadPool.
+ *
+ * Tasks run on behalf of a TaskGroup are just a function pointer, a pointer to the
+ * caller's callable and an index range, so queuing them never allocates. Tasks
+ * submitted as a std::packaged_task keep it in `packaged` instead.
+ */
+struct pool_task_t
+{
+    /** @brief Calls the callable behind `context` with the range (null for packaged tasks). */
+    void (*invoke)(const void* context, std::size_t begin, std::size_t end) { nullptr };
+
+    /** @brief The callable, owned by the caller of TaskGroup::run. */
+    const void* context{ nullptr };
+
+    /** @brief Start of the index range passed to the callable. */
+    std::size_t begin{ 0 };
+
+    /** @brief End (exclusive) of the index range passed to the callable. */
+    std::size_t end{ 0 };
+
+    /** @brief Group notified when the task completes (null for a group's runner task). */
+    TaskGroup* group{ nullptr };
+
+    /** @brief A task submitted through ThreadPool::submit. */
+    std::unique_ptr<std::packaged_task<void()>> packaged;
+
+    /**
+     * @brief Runs the task and reports its completion (and any exception) to its group.
+     */
+    void operator()();
+};
+
 /**
  * @class ThreadPool
- * @brief A simple thread pool that runs tasks on a fixed set of worker threads.
+ * @brief A work-stealing thread pool that runs tasks on a fixed set of worker threads.
+ *
+ * Work is either submitted as a std::packaged_task<void()>, or run through a
+ * `TaskGroup` / `parallel_for`, which share one completion counter per group rather
+ * than a future per task. Every worker owns a `WorkStealingQueue` per priority:
+ * tasks submitted from a worker go onto its own queue, tasks submitted from outside
+ * the pool are dealt round robin over the worker queues. A worker takes the highest
+ * priority work available, preferring its own queue and stealing from the other
+ * workers otherwise. Workers with nothing to run or steal park on a condition
+ * variable instead of spinning, so an idle pool uses no CPU.
  *
- * Tasks are submitted using std::packaged_task<void()> and processed by a background thread pool.
- * Each worker thread waits for a task to become available and then executes it.
+ * `shared()` is the one pool the renderer, the loaders and the BVH builders all
+ * use, so concurrent jobs share the machine instead of each starting their own
+ * threads; `job_options_t` bounds and orders them.
  */
 class ThreadPool
 {
@@ -20,33 +103,111 @@ public:
     /**
      * @brief Constructs the thread pool and launches the worker threads.
      *
-     * The number of threads is based on the hardware concurrency.
+     * @param thread_count Number of worker threads, 0 uses the hardware concurrency.
      */
-    ThreadPool();
+    explicit ThreadPool(unsigned thread_count = 0);
 
     /**
      * @brief Destructor that stops all threads and joins them.
+     *
+     * Tasks that have not started yet are discarded.
      */
     ~ThreadPool();
 
+    /**
+     * @brief Returns the process-wide pool, created on first use.
+     *
+     * It has the number of threads set with `configure_shared`, by default one per
+     * hardware thread.
+     */
+    static ThreadPool& shared();
+
+    /**
+     * @brief Sets the number of threads of the shared pool, before its first use.
+     *
+     * @param thread_count Number of worker threads, 0 uses the hardware concurrency.
+     * @throws std::logic_error if the shared pool has already been created.
+     */
+    static void configure_shared(unsigned thread_count);
+
     /**
      * @brief Submit a task to be executed by the thread pool.
      *
      * @param task A std::packaged_task representing a void-returning callable.
      * Ownership of the task is transferred to the pool.
+     * @param priority Priority of the task.
+     */
+    void submit(std::packaged_task<void()> task, Task_Priority priority = Task_Priority::normal);
+
+    /**
+     * @brief Calls `fn(chunk_begin, chunk_end)` for consecutive chunks of [begin, end) in parallel.
+     *
+     * The range is cut into chunks of `grain` indices which are run by the pool
+     * while the calling thread helps; returns once every chunk has run. A range
+     * that fits in one chunk runs inline. The first exception thrown by `fn` is
+     * rethrown after all chunks have finished.
+     *
+     * @param begin First index.
+     * @param end One past the last index.
+     * @param grain Number of indices per chunk (0 is treated as 1).
+     * @param fn Callable taking (std::size_t chunk_begin, std::size_t chunk_end).
+     * @param options Priority and concurrency limit of the loop.
+     */
+    template<typename Fn>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const Fn& fn, const job_options_t& options = {});
+
+    /**
+     * @brief Runs one queued task on the calling thread, if there is one.
+     *
+     * Lets a thread that waits for results help with the work instead of blocking,
+     * which also avoids deadlock when a task waits for tasks it submitted itself.
+     *
+     * @return true if a task was run.
+     */
+    bool run_pending_task();
+
+    /**
+     * @brief Returns the number of worker threads.
      */
-    void submit(std::packaged_task<void()> task);
+    unsigned thread_count() const;
 
 private:
+    friend class TaskGroup;
+    using task_type = pool_task_t;
+
     /**
      * @brief Flag to signal the thread pool to stop processing tasks.
      */
     std::atomic_bool done;
 
     /**
-     * @brief Thread-safe queue that holds tasks to be executed.
+     * @brief Number of tasks queued but not yet taken by a thread.
+     */
+    std::atomic<std::size_t> pending{ 0 };
+
+    /**
+     * @brief Counter used to deal external submissions round robin over the workers.
+     */
+    std::atomic<unsigned> next_queue{ 0 };
+
+    /**
+     * @brief Mutex and condition variable idle workers park on.
+     */
+    std::mutex park_mutex;
+    std::condition_variable park_cond;
+
+    /**
+     * @brief Number of worker threads, fixed before the first worker starts.
+     *
+     * Workers read it while later workers are still being launched, so it must not be
+     * derived from `threads`, which grows during construction.
+     */
+    const unsigned worker_count;
+
+    /**
+     * @brief One task queue per worker thread and priority, indexed by worker * TASK_PRIORITY_COUNT + priority.
      */
-    ThreadsafeQueue<std::packaged_task<void()>> work_queue;
+    std::vector<std::unique_ptr<WorkStealingQueue<task_type>>> queues;
 
     /**
      * @brief Container for the worker threads.
@@ -60,7 +221,162 @@ private:
 
     /**
      * @brief Function executed by each worker thread to process tasks.
+     *
+     * @param index Index of the worker's own queue.
+     */
+    void worker_thread(unsigned index);
+
+    /**
+     * @brief Queues a task and wakes a parked worker.
+     *
+     * @param task The task to queue.
+     * @param priority Priority of the task.
+     */
+    void push_task(task_type task, Task_Priority priority);
+
+    /**
+     * @brief Takes the highest priority task available, from the given worker's queues first.
+     *
+     * @param index Queue to try first (any value for threads outside the pool).
+     * @param task Reference to store the task if one was found.
+     * @return true if a task was found.
+     */
+    bool take_task(unsigned index, task_type& task);
+};
+
+/**
+ * @class TaskGroup
+ * @brief A set of tasks run on a ThreadPool that can be waited for together.
+ *
+ * The group counts its outstanding tasks in a single counter instead of handing out
+ * a future per task, and its tasks reference the caller's callables rather than
+ * copying them, so running a task does not allocate. The callables must therefore
+ * stay alive until `wait` returns.
+ *
+ * A group is one job for the purpose of `job_options_t`. With a concurrency limit
+ * the group queues at most that many runner tasks on the pool, each of which keeps
+ * taking the group's tasks from a backlog until it is empty.
+ */
+class TaskGroup
+{
+public:
+    /**
+     * @brief Constructs an empty group.
+     *
+     * @param pool The pool the tasks are run on.
+     * @param options Priority and concurrency limit of the group's tasks.
+     */
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared(), const job_options_t& options = {});
+
+    /**
+     * @brief Waits for any outstanding tasks (exceptions are discarded).
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * @brief Runs `fn()` on the pool.
+     *
+     * @param fn The callable, it must outlive the call to `wait`.
+     */
+    template<typename Fn>
+    void run(const Fn& fn);
+
+    /**
+     * @brief Runs `fn(begin, end)` on the pool.
+     *
+     * @param fn The callable, it must outlive the call to `wait`.
+     * @param begin Start of the range passed to `fn`.
+     * @param end End of the range passed to `fn`.
+     */
+    template<typename Fn>
+    void run(const Fn& fn, std::size_t begin, std::size_t end);
+
+    /**
+     * @brief Waits until every task of the group has finished, helping to run queued tasks meanwhile.
+     *
+     * @throws Rethrows the first exception thrown by one of the tasks.
+     */
+    void wait();
+
+private:
+    friend struct pool_task_t;
+
+    /**
+     * @brief Queues a task on the pool, or in the backlog if the concurrency limit is reached.
+     *
+     * @param task The task to run.
+     */
+    void enqueue(pool_task_t task);
+
+    /**
+     * @brief Body of a runner task: runs backlog tasks until the backlog is empty.
      */
-    void worker_thread();
+    void drain();
+
+    /**
+     * @brief Records the completion of one task.
+     *
+     * @param error The exception the task threw, if any.
+     */
+    void finish(std::exception_ptr error);
+
+    ThreadPool& pool;                       ///< Pool the tasks are run on.
+    job_options_t options;                  ///< Priority and concurrency limit.
+    std::atomic<std::size_t> outstanding{ 0 };  ///< Tasks queued or running.
+    std::exception_ptr first_error;         ///< First exception thrown by a task.
+    std::mutex mut;                         ///< Guards completion and `first_error`.
+    std::condition_variable done_cond;      ///< Signalled when `outstanding` drops to zero.
+    std::mutex backlog_mutex;               ///< Guards `backlog` and `runners`.
+    std::deque<pool_task_t> backlog;        ///< Tasks waiting for a runner (limited groups only).
+    unsigned runners{ 0 };                  ///< Runner tasks queued or running.
 };
 
+template<typename Fn>
+void TaskGroup::run(const Fn& fn)
+{
+    // the thunk calls the caller's callable directly, the task must not point at an adapter on this stack
+    pool_task_t task{};
+    task.invoke = [](const void* context, std::size_t, std::size_t) {
+        (*static_cast<const Fn*>(context))();
+    };
+    task.context = &fn;
+    task.group = this;
+    ++outstanding;
+    enqueue(std::move(task));
+}
+
+template<typename Fn>
+void TaskGroup::run(const Fn& fn, std::size_t begin, std::size_t end)
+{
+    pool_task_t task{};
+    task.invoke = [](const void* context, std::size_t b, std::size_t e) {
+        (*static_cast<const Fn*>(context))(b, e);
+    };
+    task.context = &fn;
+    task.begin = begin;
+    task.end = end;
+    task.group = this;
+    ++outstanding;
+    enqueue(std::move(task));
+}
+
+template<typename Fn>
+void ThreadPool::parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const Fn& fn, const job_options_t& options)
+{
+    if (begin >= end) return;
+    if (grain == 0) grain = 1;
+    if (end - begin <= grain)
+    {
+        fn(begin, end);
+        return;
+    }
+    TaskGroup group{ *this, options };
+    for (std::size_t chunk{ begin }; chunk < end; chunk += std::min(grain, end - chunk))
+    {
+        group.run(fn, chunk, std::min(end, chunk + grain));
+    }
+    group.wait();
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include "tile_scheduler.h"
+
+/**
+ * @brief Returns the distance of cell (x, y) along a Hilbert curve filling an n by n grid (n a power of two).
+ */
+static std::uint64_t hilbert_index(std::uint32_t n, std::uint32_t x, std::uint32_t y)
+{
+	std::uint64_t d{ 0 };
+	for (std::uint32_t s{ n / 2 }; s > 0; s /= 2)
+	{
+		const std::uint32_t rx{ (x & s) > 0 ? 1u : 0u };
+		const std::uint32_t ry{ (y & s) > 0 ? 1u : 0u };
+		d += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+		// rotate the quadrant so the curve stays continuous
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = s - 1 - (x & (s - 1));
+				y = s - 1 - (y & (s - 1));
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+TileScheduler::TileScheduler(int width, int height, int tile_size, Tile_Order order, unsigned workers, const std::vector<double>& cost_hints, const std::vector<bool>& selection)
+	: workers{ std::max(workers, 1u) }
+{
+	if (tile_size <= 0)
+	{
+		throw std::invalid_argument("Tile size must be positive");
+	}
+	const int tiles_x{ (width + tile_size - 1) / tile_size };
+	const int tiles_y{ (height + tile_size - 1) / tile_size };
+	grid_tiles = grid_size(width, height, tile_size);
+	std::vector<render_tile_t> grid;
+	grid.reserve(grid_tiles);
+	for (std::size_t i{ 0 }; i < grid_tiles; i++)
+	{
+		grid.push_back(grid_tile(width, height, tile_size, i));
+	}
+	tile_costs.assign(grid_tiles, 0.0);
+
+	// sort keys are computed once per tile, not per comparison
+	std::vector<double> key(grid_tiles, 0.0);
+	if (order == Tile_Order::spiral)
+	{
+		// ring around the centre first, then angle within the ring
+		const double cx{ (tiles_x - 1) / 2.0 };
+		const double cy{ (tiles_y - 1) / 2.0 };
+		for (const auto& tile : grid)
+		{
+			const double dx{ static_cast<int>(tile.source % tiles_x) - cx };
+			const double dy{ static_cast<int>(tile.source / tiles_x) - cy };
+			const double ring{ std::max(std::fabs(dx), std::fabs(dy)) };
+			key[tile.source] = ring * 8.0 + std::atan2(dy, dx) + 4.0;
+		}
+	}
+	else if (order == Tile_Order::hilbert)
+	{
+		std::uint32_t n{ 1 };
+		while (n < static_cast<std::uint32_t>(std::max(tiles_x, tiles_y))) n *= 2;
+		for (const auto& tile : grid)
+		{
+			key[tile.source] = static_cast<double>(hilbert_index(n,
+				static_cast<std::uint32_t>(tile.source % tiles_x),
+				static_cast<std::uint32_t>(tile.source / tiles_x)));
+		}
+	}
+	std::stable_sort(grid.begin(), grid.end(), [&key](const render_tile_t& a, const render_tile_t& b) {
+		return key[a.source] < key[b.source];
+	});
+
+	// with hints the most expensive tiles go first, the order above breaks ties
+	if (cost_hints.size() == grid_tiles)
+	{
+		std::stable_sort(grid.begin(), grid.end(), [&cost_hints](const render_tile_t& a, const render_tile_t& b) {
+			return cost_hints[a.source] > cost_hints[b.source];
+		});
+	}
+	for (const auto& tile : grid)
+	{
+		if (selection.size() != grid_tiles || selection[tile.source])
+		{
+			queue.push_back(tile);
+		}
+	}
+}
+
+std::size_t TileScheduler::grid_size(int width, int height, int tile_size)
+{
+	if (tile_size <= 0 || width <= 0 || height <= 0) return 0;
+	const std::size_t tiles_x{ static_cast<std::size_t>((width + tile_size - 1) / tile_size) };
+	const std::size_t tiles_y{ static_cast<std::size_t>((height + tile_size - 1) / tile_size) };
+	return tiles_x * tiles_y;
+}
+
+render_tile_t TileScheduler::grid_tile(int width, int height, int tile_size, std::size_t index)
+{
+	if (index >= grid_size(width, height, tile_size))
+	{
+		throw std::out_of_range("Tile index outside the grid");
+	}
+	const int tiles_x{ (width + tile_size - 1) / tile_size };
+	const int x{ static_cast<int>(index % tiles_x) };
+	const int y{ static_cast<int>(index / tiles_x) };
+	return {
+		x * tile_size, std::min(width, (x + 1) * tile_size),
+		y * tile_size, std::min(height, (y + 1) * tile_size),
+		index
+	};
+}
+
+bool TileScheduler::next(render_tile_t& tile)
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	while (!queue.empty())
+	{
+		tile = queue.front();
+		queue.pop_front();
+		const int w{ tile.x_end - tile.x_start };
+		const int h{ tile.y_end - tile.y_start };
+		// columns are only cut on multiples of the split size so the parts do not share
+		// cache lines of the canvas rows, rows can be cut anywhere
+		const int mx{ (tile.x_start + w / 2) / MIN_SPLIT_TILE_SIZE * MIN_SPLIT_TILE_SIZE };
+		const bool split_x{ w >= 2 * MIN_SPLIT_TILE_SIZE && mx > tile.x_start && mx < tile.x_end };
+		const bool split_y{ h >= 2 * MIN_SPLIT_TILE_SIZE };
+		if (queue.size() >= workers || (!split_x && !split_y))
+		{
+			return true;
+		}
+		// the queue is draining: split the tile into quadrants (or halves) the idle workers can share
+		const int my{ tile.y_start + h / 2 };
+		const int xs[3]{ tile.x_start, split_x ? mx : tile.x_end, tile.x_end };
+		const int ys[3]{ tile.y_start, split_y ? my : tile.y_end, tile.y_end };
+		for (int row{ split_y ? 1 : 0 }; row >= 0; row--)
+		{
+			for (int column{ split_x ? 1 : 0 }; column >= 0; column--)
+			{
+				queue.push_front({ xs[column], xs[column + 1], ys[row], ys[row + 1], tile.source });
+			}
+		}
+	}
+	return false;
+}
+
+void TileScheduler::complete(const render_tile_t& tile, double seconds)
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	tile_costs.at(tile.source) += seconds;
+}
+
+std::size_t TileScheduler::tile_count() const
+{
+	return grid_tiles;
+}
+
+std::size_t TileScheduler::remaining() const
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	return queue.size();
+}
+
+std::vector<double> TileScheduler::costs() const
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	return tile_costs;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * @struct render_tile_t
+ * @brief Represents a rectangular tile region for rendering.
+ *
+ * Each tile defines a subregion of the full image with start and end bounds
+ * in both the x (horizontal) and y (vertical) directions. These tiles are used
+ * to divide the rendering task into smaller parallel units.
+ */
+struct render_tile_t
+{
+    int x_start; ///< Starting x-coordinate (inclusive)
+    int x_end;   ///< Ending x-coordinate (exclusive)
+    int y_start; ///< Starting y-coordinate (inclusive)
+    int y_end;   ///< Ending y-coordinate (exclusive)
+    std::size_t source{ 0 }; ///< Index of the grid tile this tile is (part of)
+
+    /**
+     * @brief Returns the number of pixels in the tile.
+     */
+    int area() const
+    {
+        return (x_end - x_start) * (y_end - y_start);
+    }
+};
+
+/**
+ * @enum Tile_Order
+ * @brief Order in which the tiles of the grid are handed out.
+ */
+enum class Tile_Order
+{
+    scanline, ///< Row by row, left to right
+    spiral,   ///< Outwards from the centre of the image, where the subject usually is
+    hilbert   ///< Along a Hilbert curve, so consecutive tiles are neighbours
+};
+
+/**
+ * @brief Tiles are not split below this width or height (in pixels), and columns are only cut on multiples of it.
+ *
+ * 16 pixels are a whole number of cache lines in every canvas format, so the parts of
+ * a split tile never write to the same cache line of a row.
+ */
+inline constexpr int MIN_SPLIT_TILE_SIZE{ 16 };
+
+/**
+ * @class TileScheduler
+ * @brief Hands out the tiles of one render to the worker threads.
+ *
+ * The image is cut into a grid of `tile_size` squares which are queued in the
+ * requested `Tile_Order`. When the cost of each grid tile in a previous frame is
+ * known, the tiles are queued most expensive first instead, so the slow tiles do
+ * not end up at the tail of the render.
+ *
+ * Once fewer tiles are queued than there are workers, the next tile taken is split
+ * into quadrants (or halves, see `MIN_SPLIT_TILE_SIZE`) rather than handed out whole,
+ * so the last large tiles are shared between the workers that would otherwise sit idle.
+ *
+ * The time spent on every tile is added to its grid tile, giving the cost hints
+ * for the next frame. A selection restricts the render to some of the grid tiles,
+ * e.g. those affected by a scene edit.
+ */
+class TileScheduler
+{
+public:
+    /**
+     * @brief Queues the tiles of an image.
+     *
+     * @param width Image width in pixels.
+     * @param height Image height in pixels.
+     * @param tile_size Width and height of the grid tiles in pixels.
+     * @param order Order the grid tiles are queued in.
+     * @param workers Number of threads taking tiles, used to decide when to split.
+     * @param cost_hints Cost of each grid tile (in any unit), ignored unless it has one entry per grid tile.
+     * @param selection Grid tiles to queue, ignored unless it has one entry per grid tile (then all are queued).
+     */
+    TileScheduler(int width, int height, int tile_size, Tile_Order order, unsigned workers, const std::vector<double>& cost_hints = {}, const std::vector<bool>& selection = {});
+
+    /**
+     * @brief Returns the number of tiles in the grid of an image.
+     *
+     * @param width Image width in pixels.
+     * @param height Image height in pixels.
+     * @param tile_size Width and height of the grid tiles in pixels.
+     */
+    static std::size_t grid_size(int width, int height, int tile_size);
+
+    /**
+     * @brief Returns a tile of the grid of an image, clipped to the image.
+     *
+     * @param width Image width in pixels.
+     * @param height Image height in pixels.
+     * @param tile_size Width and height of the grid tiles in pixels.
+     * @param index Index of the tile in scanline order.
+     * @throws std::out_of_range if the index is outside the grid.
+     */
+    static render_tile_t grid_tile(int width, int height, int tile_size, std::size_t index);
+
+    /**
+     * @brief Takes the next tile to render.
+     *
+     * @param tile Reference to store the tile if there is one.
+     * @return false once every tile has been handed out.
+     */
+    bool next(render_tile_t& tile);
+
+    /**
+     * @brief Records the time spent rendering a tile taken from `next`.
+     *
+     * @param tile The tile.
+     * @param seconds Time spent rendering it.
+     */
+    void complete(const render_tile_t& tile, double seconds);
+
+    /**
+     * @brief Returns the number of tiles in the grid.
+     */
+    std::size_t tile_count() const;
+
+    /**
+     * @brief Returns the number of tiles not handed out yet, including the quadrants of split tiles.
+     */
+    std::size_t remaining() const;
+
+    /**
+     * @brief Returns the time recorded for each grid tile, in grid order.
+     */
+    std::vector<double> costs() const;
+
+private:
+    unsigned workers;                   ///< Number of threads taking tiles.
+    std::size_t grid_tiles;             ///< Number of tiles in the grid.
+    mutable std::mutex mut;             ///< Guards `queue` and `tile_costs`.
+    std::deque<render_tile_t> queue;    ///< Tiles not handed out yet.
+    std::vector<double> tile_costs;     ///< Time spent on each grid tile.
+};
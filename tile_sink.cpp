@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "tile_sink.h"
+
+StreamingImageWriter::StreamingImageWriter(const std::string& path, Image_Format format, int band_height)
+	: path{ path }, format{ format }, band_height{ band_height }
+{
+	if (band_height <= 0)
+	{
+		throw std::invalid_argument("Band height must be positive");
+	}
+}
+
+void StreamingImageWriter::begin(int width, int height)
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	this->width = width;
+	this->height = height;
+	bands.clear();
+	pixels_left = static_cast<std::size_t>(width) * height;
+	buffered = 0;
+	peak = 0;
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		throw std::runtime_error("Could not create " + path);
+	}
+	const std::string header{ encoded_header(format, width, height) };
+	file.write(header.data(), header.size());
+	header_size = header.size();
+}
+
+void StreamingImageWriter::write_tile(const render_tile_t& tile, const colour_t* pixels)
+{
+	// encode outside the lock, the render threads only serialize on the copy
+	const int tile_width{ tile.x_end - tile.x_start };
+	const std::size_t bytes{ encoded_pixel_size(format) };
+	std::vector<std::uint8_t> encoded(static_cast<std::size_t>(tile.area()) * bytes);
+	for (std::size_t i{ 0 }; i < static_cast<std::size_t>(tile.area()); i++)
+	{
+		encode_pixel(format, pixels[i], encoded.data() + i * bytes);
+	}
+
+	std::lock_guard<std::mutex> lk{ mut };
+	pixels_left -= tile.area();
+	const std::size_t row_bytes{ static_cast<std::size_t>(tile_width) * bytes };
+	const std::size_t image_row_bytes{ static_cast<std::size_t>(width) * bytes };
+	for (int index{ tile.y_start / band_height }; index * band_height < tile.y_end; index++)
+	{
+		const int band_start{ index * band_height };
+		const int band_end{ std::min(band_start + band_height, height) };
+		auto found{ bands.find(index) };
+		if (found == bands.end())
+		{
+			band_t band{ std::vector<std::uint8_t>(static_cast<std::size_t>(band_end - band_start) * image_row_bytes), static_cast<std::size_t>(band_end - band_start) * width };
+			buffered += band.bytes.size();
+			peak = std::max(peak, buffered);
+			found = bands.emplace(index, std::move(band)).first;
+		}
+		band_t& band{ found->second };
+		const int y_start{ std::max(tile.y_start, band_start) };
+		const int y_end{ std::min(tile.y_end, band_end) };
+		for (int y{ y_start }; y < y_end; y++)
+		{
+			std::memcpy(band.bytes.data() + (y - band_start) * image_row_bytes + tile.x_start * bytes, encoded.data() + (y - tile.y_start) * row_bytes, row_bytes);
+		}
+		band.pixels_left -= static_cast<std::size_t>(y_end - y_start) * tile_width;
+		if (band.pixels_left > 0)
+		{
+			continue;
+		}
+
+		// the band is complete, write its rows to their place in the file and release it
+		for (int y{ band_start }; y < band_end; y++)
+		{
+			file.seekp(static_cast<std::streamoff>(row_offset(y)));
+			file.write(reinterpret_cast<const char*>(band.bytes.data() + (y - band_start) * image_row_bytes), image_row_bytes);
+		}
+		buffered -= band.bytes.size();
+		bands.erase(found);
+		if (!file)
+		{
+			throw std::runtime_error("Could not write " + path);
+		}
+	}
+}
+
+void StreamingImageWriter::finish()
+{
+	std::lock_guard<std::mutex> lk{ mut };
+	const bool complete{ pixels_left == 0 };
+	file.close();
+	if (!complete)
+	{
+		throw std::runtime_error("Image " + path + " is missing tiles");
+	}
+	if (!file)
+	{
+		throw std::runtime_error("Could not write " + path);
+	}
+}
+
+std::size_t StreamingImageWriter::peak_buffered_bytes() const
+{
+	return peak;
+}
+
+std::size_t StreamingImageWriter::row_offset(int y) const
+{
+	// PFM stores the bottom row first
+	const int row{ format == Image_Format::pfm ? height - 1 - y : y };
+	return header_size + static_cast<std::size_t>(row) * width * encoded_pixel_size(format);
+}
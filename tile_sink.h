@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "colour.h"
+#include "ppm.h"
+#include "tile_scheduler.h"
+
+/**
+ * @class TileSink
+ * @brief Receives the pixels of finished tiles from `RenderManager::render_to`.
+ *
+ * `write_tile` is called from the render threads, concurrently and in no particular
+ * order, so implementations must be thread safe.
+ */
+class TileSink
+{
+public:
+    virtual ~TileSink() = default;
+
+    /**
+     * @brief Called once before the first tile.
+     *
+     * @param width Image width in pixels.
+     * @param height Image height in pixels.
+     */
+    virtual void begin(int width, int height) = 0;
+
+    /**
+     * @brief Receives one finished tile.
+     *
+     * @param tile The tile's bounds.
+     * @param pixels The tile's pixels, row by row.
+     */
+    virtual void write_tile(const render_tile_t& tile, const colour_t* pixels) = 0;
+
+    /**
+     * @brief Called once after the last tile.
+     */
+    virtual void finish() = 0;
+};
+
+/**
+ * @class StreamingImageWriter
+ * @brief Encodes finished tiles straight into an image file without holding the image.
+ *
+ * Tiles are encoded into the horizontal band of rows they belong to. A band is written
+ * to its place in the file as soon as all of its pixels have arrived and is then
+ * released, so only the bands tiles are being rendered in are held in memory (a few
+ * with the scanline tile order). Every pixel is encoded into 3 or 6 bytes (PPM) or
+ * 12 bytes (PFM), rather than the 32 bytes of a `colour_t`.
+ */
+class StreamingImageWriter : public TileSink
+{
+public:
+    /**
+     * @brief Constructs a writer, the file is created by `begin`.
+     *
+     * @param path The image file.
+     * @param format The file format.
+     * @param band_height Height of the bands in rows, usually the render's tile size.
+     * @throws std::invalid_argument if band_height is not positive.
+     */
+    StreamingImageWriter(const std::string& path, Image_Format format, int band_height);
+
+    /**
+     * @brief Creates the file and writes its header.
+     *
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    void begin(int width, int height) override;
+
+    /**
+     * @brief Encodes a tile, writing its band if it is complete.
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void write_tile(const render_tile_t& tile, const colour_t* pixels) override;
+
+    /**
+     * @brief Closes the file.
+     *
+     * @throws std::runtime_error if a band is incomplete or the file cannot be written.
+     */
+    void finish() override;
+
+    /**
+     * @brief Returns the largest number of bytes held in bands at once, once the image is finished.
+     */
+    std::size_t peak_buffered_bytes() const;
+
+private:
+    /**
+     * @struct band_t
+     * @brief The encoded pixels of a band of rows.
+     */
+    struct band_t
+    {
+        std::vector<std::uint8_t> bytes;    ///< Encoded rows of the band, top to bottom.
+        std::size_t pixels_left;            ///< Pixels that have not arrived.
+    };
+
+    /**
+     * @brief Returns the position of a row in the file.
+     */
+    std::size_t row_offset(int y) const;
+
+    std::string path;               ///< The image file.
+    Image_Format format;            ///< The file format.
+    int band_height;                ///< Height of the bands in rows.
+    int width{ 0 };                 ///< Image width in pixels.
+    int height{ 0 };                ///< Image height in pixels.
+    std::size_t header_size{ 0 };   ///< Bytes before the first row in the file.
+    std::size_t pixels_left{ 0 };   ///< Pixels of the image that have not arrived.
+    std::ofstream file;             ///< The open image file.
+    std::mutex mut;                 ///< Guards the bands and the file.
+    std::map<int, band_t> bands;    ///< Bands with pixels still missing, by index.
+    std::size_t buffered{ 0 };      ///< Bytes held in bands.
+    std::size_t peak{ 0 };          ///< Largest value of `buffered`.
+};
@@ -1,5 +1,7 @@
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <cmath>
 
 #include "utils.h"
 
@@ -40,4 +42,59 @@ std::vector<std::string> get_clean_tokens(std::istream& input, const char commen
         }
     }
     return tokens;
-}
\ No newline at end of file
+}
+std::uint16_t to_half(const double value)
+{
+    const float f{ static_cast<float>(value) };
+    std::uint32_t bits{};
+    std::memcpy(&bits, &f, sizeof(bits));
+
+    const std::uint16_t sign{ static_cast<std::uint16_t>((bits >> 16) & 0x8000) };
+    const std::int32_t exponent{ static_cast<std::int32_t>((bits >> 23) & 0xff) - 127 + 15 };
+    std::uint32_t mantissa{ bits & 0x7fffff };
+
+    // NaN and infinity
+    if (((bits >> 23) & 0xff) == 0xff)
+    {
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    // Too large for a half, clamp to infinity
+    if (exponent >= 0x1f)
+    {
+        return sign | 0x7c00;
+    }
+    // Subnormal half or zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        const int shift{ 14 - exponent };
+        std::uint32_t half_mantissa{ mantissa >> shift };
+        const std::uint32_t remainder{ mantissa & ((1u << shift) - 1) };
+        const std::uint32_t halfway{ 1u << (shift - 1) };
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) ++half_mantissa;
+        return sign | static_cast<std::uint16_t>(half_mantissa);
+    }
+    // Normal half, round the mantissa to nearest even (a carry correctly bumps the exponent)
+    std::uint32_t half{ (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> 13) };
+    const std::uint32_t remainder{ mantissa & 0x1fff };
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) ++half;
+    return sign | static_cast<std::uint16_t>(half);
+}
+
+double from_half(const std::uint16_t half)
+{
+    const double sign{ (half & 0x8000) ? -1.0 : 1.0 };
+    const int exponent{ (half >> 10) & 0x1f };
+    const int mantissa{ half & 0x3ff };
+
+    if (exponent == 0)
+    {
+        return sign * std::ldexp(mantissa, -24);
+    }
+    if (exponent == 0x1f)
+    {
+        return mantissa ? NAN : sign * INFINITY;
+    }
+    return sign * std::ldexp(mantissa + 1024, exponent - 25);
+}
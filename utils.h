@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
 
 /**
  * @brief Splits a string into a vector of substrings based on a delimiter.
@@ -43,3 +44,22 @@ std::vector<std::string> split(const std::string& str, const std::string& delime
  * std::vector<std::string> tokens = get_clean_tokens(file, '#');
  */
 std::vector<std::string> get_clean_tokens(std::istream& input, const char comment_symbol = '#');
+
+/**
+ * @brief Converts a value to an IEEE 754 half precision float.
+ *
+ * Values outside the half range are clamped to infinity and values too small
+ * to be represented flush to (signed) zero. Rounds to nearest even.
+ *
+ * @param value The value to convert.
+ * @return The 16-bit half float bit pattern.
+ */
+std::uint16_t to_half(const double value);
+
+/**
+ * @brief Converts an IEEE 754 half precision float back to a double.
+ *
+ * @param half The 16-bit half float bit pattern.
+ * @return The decoded value.
+ */
+double from_half(const std::uint16_t half);
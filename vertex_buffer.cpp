@@ -0,0 +1,299 @@
+#include <cmath>
+#include <cstring>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <algorithm>
+#include "vertex_buffer.h"
+#include "utils.h"
+
+/**
+ * @brief Integer grid cell a vertex position falls into, used as the weld lookup key.
+ */
+struct weld_cell_t
+{
+    std::int64_t x;
+    std::int64_t y;
+    std::int64_t z;
+
+    bool operator==(const weld_cell_t& c) const
+    {
+        return x == c.x && y == c.y && z == c.z;
+    }
+};
+
+struct weld_cell_hash_t
+{
+    std::size_t operator()(const weld_cell_t& c) const
+    {
+        std::size_t h{ std::hash<std::int64_t>{}(c.x) };
+        h ^= std::hash<std::int64_t>{}(c.y) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        h ^= std::hash<std::int64_t>{}(c.z) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+/**
+ * @brief Maps a coordinate to its weld cell.
+ *
+ * Exact welding uses the bit pattern of the coordinate so only identical values share a
+ * cell (adding 0.0 folds -0.0 into +0.0). Epsilon welding snaps to a grid of that size.
+ */
+static std::int64_t weld_coordinate(const double value, const double weld_epsilon)
+{
+    if (weld_epsilon > 0)
+    {
+        return static_cast<std::int64_t>(std::floor(value / weld_epsilon));
+    }
+    const double folded{ value + 0.0 };
+    std::int64_t bits{};
+    std::memcpy(&bits, &folded, sizeof(bits));
+    return bits;
+}
+
+static bool within(const double a, const double b, const double weld_epsilon)
+{
+    return std::fabs(a - b) <= weld_epsilon;
+}
+
+static bool can_weld(const mesh_vertex_t& a, const mesh_vertex_t& b, const double weld_epsilon)
+{
+    return within(a.position.x, b.position.x, weld_epsilon) &&
+        within(a.position.y, b.position.y, weld_epsilon) &&
+        within(a.position.z, b.position.z, weld_epsilon) &&
+        within(a.normal.x, b.normal.x, weld_epsilon) &&
+        within(a.normal.y, b.normal.y, weld_epsilon) &&
+        within(a.normal.z, b.normal.z, weld_epsilon) &&
+        within(a.uv.first, b.uv.first, weld_epsilon) &&
+        within(a.uv.second, b.uv.second, weld_epsilon);
+}
+
+/**
+ * @brief Quantises a coordinate in [min, max] to 16 bits.
+ */
+static std::uint16_t quantise(const double value, const double min, const double max)
+{
+    const double extent{ max - min };
+    if (extent <= 0) return 0;
+    const double t{ std::clamp((value - min) / extent, 0.0, 1.0) };
+    return static_cast<std::uint16_t>(std::lround(t * 65535.0));
+}
+
+static std::uint16_t to_snorm16(const double value)
+{
+    return static_cast<std::uint16_t>(static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0, 1.0) * 32767.0)));
+}
+
+static double from_snorm16(const std::uint16_t value)
+{
+    return static_cast<std::int16_t>(value) / 32767.0;
+}
+
+/**
+ * @brief Packed value of a vertex without a normal.
+ *
+ * -32768 is never produced by `to_snorm16`, so it cannot collide with a real normal.
+ */
+static constexpr std::uint32_t NO_PACKED_NORMAL{ 0x80008000u };
+
+/**
+ * @brief Octahedral encodes a unit vector into two 16-bit snorm values.
+ *
+ * The vector is projected onto the octahedron |x| + |y| + |z| = 1 and the lower
+ * hemisphere is folded over the upper one, giving a uniform 2D parameterisation.
+ */
+static std::uint32_t encode_octahedral(const tuple_t& n)
+{
+    const double l1{ std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z) };
+    if (l1 == 0) return NO_PACKED_NORMAL;
+    double u{ n.x / l1 };
+    double v{ n.y / l1 };
+    if (n.z < 0)
+    {
+        const double fu{ (1.0 - std::fabs(v)) * (u >= 0 ? 1.0 : -1.0) };
+        const double fv{ (1.0 - std::fabs(u)) * (v >= 0 ? 1.0 : -1.0) };
+        u = fu;
+        v = fv;
+    }
+    return static_cast<std::uint32_t>(to_snorm16(u)) | (static_cast<std::uint32_t>(to_snorm16(v)) << 16);
+}
+
+static tuple_t decode_octahedral(const std::uint32_t packed)
+{
+    if (packed == NO_PACKED_NORMAL) return tuple_t::vector(0, 0, 0);
+    const double u{ from_snorm16(static_cast<std::uint16_t>(packed & 0xffff)) };
+    const double v{ from_snorm16(static_cast<std::uint16_t>(packed >> 16)) };
+    double x{ u };
+    double y{ v };
+    const double z{ 1.0 - std::fabs(u) - std::fabs(v) };
+    if (z < 0)
+    {
+        x = (1.0 - std::fabs(v)) * (u >= 0 ? 1.0 : -1.0);
+        y = (1.0 - std::fabs(u)) * (v >= 0 ? 1.0 : -1.0);
+    }
+    tuple_t n{ tuple_t::vector(x, y, z) };
+    n.normalize();
+    return n;
+}
+
+vertex_buffer_t::vertex_buffer_t(const wavefront_t& obj, bool smooth, double weld_epsilon)
+{
+    if (obj.faces.size() * 3 > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error("Mesh has too many vertices for 32-bit indices");
+    }
+
+    // Vertices welded so far, bucketed by the grid cell of their position
+    std::unordered_map<weld_cell_t, std::vector<std::uint32_t>, weld_cell_hash_t> cells;
+    cells.reserve(obj.vertices.size());
+    vertices.reserve(obj.vertices.size());
+    indices.reserve(obj.faces.size() * 3);
+
+    // With an epsilon a matching vertex may sit in a neighbouring cell, exact welds only
+    // ever need to look in their own cell
+    const int reach{ weld_epsilon > 0 ? 1 : 0 };
+
+    for (const auto& face : obj.faces)
+    {
+        const std::array<int, 3> position_indices{ face.a, face.b, face.c };
+        for (int corner{ 0 }; corner < 3; corner++)
+        {
+            mesh_vertex_t vertex{
+                obj.vertices.at(position_indices[corner] - 1),
+                tuple_t::vector(0, 0, 0),
+                { 0.0, 0.0 }
+            };
+            if (face.has_uvs())
+            {
+                const int uv_index{ corner == 0 ? face.a_uv.value() : corner == 1 ? face.b_uv.value() : face.c_uv.value() };
+                vertex.uv = obj.uvs.at(uv_index - 1);
+            }
+            if (face.has_normals() && smooth)
+            {
+                vertex.normal = obj.vertex_normals_avg.at(position_indices[corner] - 1);
+            }
+
+            const weld_cell_t cell{
+                weld_coordinate(vertex.position.x, weld_epsilon),
+                weld_coordinate(vertex.position.y, weld_epsilon),
+                weld_coordinate(vertex.position.z, weld_epsilon)
+            };
+
+            // Look for an existing vertex to weld to
+            std::int64_t found{ -1 };
+            for (int dx{ -reach }; dx <= reach && found < 0; dx++)
+            {
+                for (int dy{ -reach }; dy <= reach && found < 0; dy++)
+                {
+                    for (int dz{ -reach }; dz <= reach && found < 0; dz++)
+                    {
+                        const auto bucket{ cells.find({ cell.x + dx, cell.y + dy, cell.z + dz }) };
+                        if (bucket == cells.end()) continue;
+                        for (const std::uint32_t candidate : bucket->second)
+                        {
+                            if (can_weld(vertices[candidate], vertex, weld_epsilon))
+                            {
+                                found = candidate;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (found < 0)
+            {
+                found = static_cast<std::int64_t>(vertices.size());
+                cells[cell].push_back(static_cast<std::uint32_t>(found));
+                vertices.push_back(vertex);
+            }
+            indices.push_back(static_cast<std::uint32_t>(found));
+        }
+    }
+    vertices.shrink_to_fit();
+}
+
+vertex_buffer_t::vertex_buffer_t(std::vector<mesh_vertex_t> vertices, std::vector<std::uint32_t> indices)
+    : vertices{ std::move(vertices) }, indices{ std::move(indices) }
+{
+    for (const std::uint32_t index : this->indices)
+    {
+        if (index >= this->vertices.size())
+        {
+            throw std::out_of_range("Vertex index out of range");
+        }
+    }
+}
+
+std::size_t vertex_buffer_t::triangle_count() const
+{
+    return indices.size() / 3;
+}
+
+std::size_t vertex_buffer_t::vertex_count() const
+{
+    return compressed ? packed_vertices.size() : vertices.size();
+}
+
+void vertex_buffer_t::compress()
+{
+    if (compressed) return;
+
+    quantisation_bounds = {};
+    for (const auto& vertex : vertices)
+    {
+        quantisation_bounds.add(vertex.position);
+    }
+
+    const tuple_t& min{ quantisation_bounds.min };
+    const tuple_t& max{ quantisation_bounds.max };
+    quantisation_step = tuple_t::vector((max.x - min.x) / 65535.0, (max.y - min.y) / 65535.0, (max.z - min.z) / 65535.0);
+    packed_vertices.reserve(vertices.size());
+    for (const auto& vertex : vertices)
+    {
+        packed_vertices.push_back({
+            {
+                quantise(vertex.position.x, min.x, max.x),
+                quantise(vertex.position.y, min.y, max.y),
+                quantise(vertex.position.z, min.z, max.z)
+            },
+            { to_half(vertex.uv.first), to_half(vertex.uv.second) },
+            encode_octahedral(vertex.normal)
+        });
+    }
+    std::vector<mesh_vertex_t>{}.swap(vertices);
+    compressed = true;
+}
+
+tuple_t vertex_buffer_t::position(const std::uint32_t index) const
+{
+    if (!compressed) return vertices[index].position;
+    const packed_vertex_t& vertex{ packed_vertices[index] };
+    const tuple_t& min{ quantisation_bounds.min };
+    return tuple_t::point(
+        min.x + quantisation_step.x * vertex.position[0],
+        min.y + quantisation_step.y * vertex.position[1],
+        min.z + quantisation_step.z * vertex.position[2]
+    );
+}
+
+tuple_t vertex_buffer_t::normal(const std::uint32_t index) const
+{
+    if (!compressed) return vertices[index].normal;
+    return decode_octahedral(packed_vertices[index].normal);
+}
+
+std::pair<double, double> vertex_buffer_t::uv(const std::uint32_t index) const
+{
+    if (!compressed) return vertices[index].uv;
+    const packed_vertex_t& vertex{ packed_vertices[index] };
+    return { from_half(vertex.uv[0]), from_half(vertex.uv[1]) };
+}
+
+std::size_t vertex_buffer_t::memory_usage() const
+{
+    return vertices.capacity() * sizeof(mesh_vertex_t) +
+        packed_vertices.capacity() * sizeof(packed_vertex_t) +
+        indices.capacity() * sizeof(std::uint32_t);
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "tuple.h"
+#include "bounding_box.h"
+#include "wavefront_obj.h"
+
+/**
+ * @struct mesh_vertex_t
+ * @brief A single welded mesh vertex holding every attribute needed for shading.
+ */
+struct mesh_vertex_t
+{
+    /** @brief Vertex position in mesh space. */
+    tuple_t position;
+
+    /** @brief Averaged vertex normal (zero vector if the vertex has no normal). */
+    tuple_t normal;
+
+    /** @brief Texture coordinates of the vertex ((0, 0) if the vertex has no uvs). */
+    std::pair<double, double> uv;
+};
+
+/**
+ * @struct packed_vertex_t
+ * @brief A compressed mesh vertex (16 bytes instead of the 80 of `mesh_vertex_t`).
+ *
+ * Positions are quantised to 16 bits per axis relative to the mesh bounds, the
+ * normal is octahedral encoded into two 16-bit signed values and the uvs are
+ * stored as half floats.
+ */
+struct packed_vertex_t
+{
+    /** @brief Quantised x, y and z position relative to the buffer's quantisation bounds. */
+    std::uint16_t position[3];
+
+    /** @brief u and v as half floats. */
+    std::uint16_t uv[2];
+
+    /** @brief Octahedral encoded normal as two 16-bit snorm values. */
+    std::uint32_t normal;
+};
+
+/**
+ * @struct vertex_buffer_t
+ * @brief Indexed, deduplicated vertex storage shared by all the triangles of a mesh.
+ *
+ * Every face corner of a Wavefront OBJ is turned into a (position, normal, uv) tuple.
+ * Identical tuples are welded into a single entry of `vertices` and the triangles
+ * reference them through 32-bit indices, so a vertex shared by many faces is only
+ * stored once. An optional weld epsilon also merges tuples whose components differ
+ * by at most that amount, which is useful for scanned data with cracks between patches.
+ */
+struct vertex_buffer_t
+{
+    /** @brief The welded vertices. */
+    std::vector<mesh_vertex_t> vertices;
+
+    /** @brief Three vertex indices per triangle, in face order. */
+    std::vector<std::uint32_t> indices;
+
+    /** @brief Whether the vertices are stored in `packed_vertices` rather than `vertices`. */
+    bool compressed{ false };
+
+    /** @brief The compressed vertices, only populated once `compress()` has been called. */
+    std::vector<packed_vertex_t> packed_vertices;
+
+    /** @brief Bounds the quantised positions are relative to. */
+    bbox_t quantisation_bounds{};
+
+    /** @brief Size of one quantisation step per axis, so decoding a position is one multiply-add per axis. */
+    tuple_t quantisation_step{ tuple_t::vector(0, 0, 0) };
+
+    /**
+     * @brief Builds the welded vertex buffer for all faces of an OBJ.
+     *
+     * @param obj The parsed Wavefront OBJ data.
+     * @param smooth Whether vertex normals should be stored (for smooth shading).
+     * @param weld_epsilon Maximum per-component difference for two vertices to be welded (0 welds exact matches only).
+     */
+    vertex_buffer_t(const wavefront_t& obj, bool smooth, double weld_epsilon = 0);
+
+    /**
+     * @brief Wraps already welded vertices and indices, e.g. read back from a mesh cache.
+     *
+     * @param vertices The welded vertices.
+     * @param indices Three vertex indices per triangle.
+     */
+    vertex_buffer_t(std::vector<mesh_vertex_t> vertices, std::vector<std::uint32_t> indices);
+
+    /**
+     * @brief Returns the number of triangles referenced by the index buffer.
+     */
+    std::size_t triangle_count() const;
+
+    /**
+     * @brief Returns the number of welded vertices, whichever storage holds them.
+     */
+    std::size_t vertex_count() const;
+
+    /**
+     * @brief Quantises all vertices into `packed_vertices` and releases the full precision storage.
+     *
+     * Positions lose precision to 1/65535th of the mesh extent per axis, normals to
+     * roughly 0.01 degrees and uvs to half float precision.
+     */
+    void compress();
+
+    /**
+     * @brief Decodes the position of a vertex.
+     * @param index The vertex index.
+     */
+    tuple_t position(const std::uint32_t index) const;
+
+    /**
+     * @brief Decodes the normal of a vertex.
+     * @param index The vertex index.
+     */
+    tuple_t normal(const std::uint32_t index) const;
+
+    /**
+     * @brief Decodes the texture coordinates of a vertex.
+     * @param index The vertex index.
+     */
+    std::pair<double, double> uv(const std::uint32_t index) const;
+
+    /**
+     * @brief Returns the number of bytes used by the vertex and index storage.
+     */
+    std::size_t memory_usage() const;
+};
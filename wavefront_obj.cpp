@@ -1,13 +1,47 @@
-#include <fstream>
+#include <atomic>
 #include <string>
 #include <string_view>
 #include <vector>
+#include <array>
+#include <thread>
+#include <functional>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
 #include <filesystem>
-#include <exception>
-#include "utils.h"
+#include <stdexcept>
 #include "tuple.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
 #include "wavefront_obj.h"
 
+/**
+ * @brief Smallest number of bytes handed to a single parsing thread.
+ *
+ * Files smaller than this are parsed on the calling thread, so the thread
+ * start-up cost is only paid for the large scans where it matters.
+ */
+static constexpr std::size_t MIN_OBJ_CHUNK_BYTES{ 1 << 20 };
+
+/**
+ * @brief Geometry parsed from a single newline-aligned chunk of an obj file.
+ *
+ * Positive obj indices are already global so they are stored as is. Negative
+ * (relative) indices can only be resolved once the number of elements defined
+ * in the preceding chunks is known, so they are stored relative to the start
+ * of the chunk and recorded in `relative_indices` to be offset on merge.
+ */
+struct obj_chunk_t
+{
+    std::vector<tuple_t> vertices;
+    std::vector<tuple_t> normals;
+    std::vector<std::pair<double, double>> uvs;
+    std::vector<face_t> faces;
+
+    /** @brief (face index, slot) pairs where slot 0-2 are vertices, 3-5 uvs and 6-8 normals. */
+    std::vector<std::pair<std::size_t, int>> relative_indices;
+};
+
 bool face_t::has_uvs() const
 {
 	return a_uv && b_uv && c_uv;
@@ -18,147 +52,352 @@ bool face_t::has_normals() const
 	return a_normal && b_normal && c_normal;
 }
 
-wavefront_t::wavefront_t(const char* obj_filename)
+/**
+ * @brief Returns a reference to one of the nine index slots of a face.
+ */
+static int& face_slot(face_t& face, const int slot)
 {
-    const std::filesystem::path obj_filepath{ std::filesystem::absolute(obj_filename) };
+    switch (slot)
+    {
+    case 0: return face.a;
+    case 1: return face.b;
+    case 2: return face.c;
+    case 3: return face.a_uv.value();
+    case 4: return face.b_uv.value();
+    case 5: return face.c_uv.value();
+    case 6: return face.a_normal.value();
+    case 7: return face.b_normal.value();
+    default: return face.c_normal.value();
+    }
+}
 
-    if (!std::filesystem::exists(obj_filepath))
+/**
+ * @brief Splits [0, count) into contiguous ranges and runs fn(begin, end) on each in parallel.
+ *
+ * The ranges run on the shared thread pool while the calling thread helps. Any
+ * exception thrown by one of them is rethrown once all ranges have finished.
+ */
+static void parallel_ranges(const std::size_t count, const unsigned thread_count, const std::function<void(std::size_t, std::size_t)>& fn)
+{
+    const std::size_t range_count{ std::min<std::size_t>(std::max(thread_count, 1u), count) };
+    if (range_count <= 1)
     {
-        throw std::invalid_argument("Obj file does not exist");
+        fn(0, count);
+        return;
     }
-    else
+
+    ThreadPool::shared().parallel_for(0, range_count, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i{ begin }; i < end; i++)
+        {
+            fn(i * count / range_count, (i + 1) * count / range_count);
+        }
+    });
+}
+
+/**
+ * @brief Returns the next whitespace separated token in [p, end) and advances p past it.
+ */
+static std::string_view next_token(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    const char* start{ p };
+    while (p < end && *p != ' ' && *p != '\t') ++p;
+    return { start, static_cast<std::size_t>(p - start) };
+}
+
+static double parse_double(std::string_view token)
+{
+    if (!token.empty() && token.front() == '+') token.remove_prefix(1);
+    double value{};
+    const auto [ptr, ec] { std::from_chars(token.data(), token.data() + token.size(), value) };
+    if (ec != std::errc{} || token.empty())
     {
-        std::ifstream file(obj_filepath);
+        throw std::invalid_argument("Invalid number in obj file");
+    }
+    return value;
+}
 
-        // Temporary storage for normal indices, and a list of normals from the OBJ file
-        std::vector<std::vector<double>> added_normal_indices;
-        std::vector<tuple_t> obj_normals{};
+static int parse_int(std::string_view token)
+{
+    int value{};
+    const auto [ptr, ec] { std::from_chars(token.data(), token.data() + token.size(), value) };
+    if (ec != std::errc{} || token.empty())
+    {
+        throw std::invalid_argument("Invalid index in obj file");
+    }
+    return value;
+}
 
+/**
+ * @brief Parses a face corner of the form v, v/vt, v//vn or v/vt/vn.
+ *
+ * Indices are split into the three output strings; missing components are left empty.
+ */
+static std::array<std::string_view, 3> split_face_corner(std::string_view corner)
+{
+    std::array<std::string_view, 3> parts{};
+    for (auto& part : parts)
+    {
+        const std::size_t slash{ corner.find('/') };
+        part = corner.substr(0, slash);
+        if (slash == std::string_view::npos) break;
+        corner.remove_prefix(slash + 1);
+    }
+    return parts;
+}
 
-        std::string line{};
+/**
+ * @brief Parses all complete lines in [begin, end) into a chunk.
+ */
+static void parse_chunk(const char* begin, const char* end, obj_chunk_t& chunk)
+{
+    const char* line_start{ begin };
+    while (line_start < end)
+    {
+        const char* line_end{ static_cast<const char*>(std::memchr(line_start, '\n', end - line_start)) };
+        if (!line_end) line_end = end;
+        const char* p{ line_start };
+        const char* stop{ (line_end > line_start && *(line_end - 1) == '\r') ? line_end - 1 : line_end };
+        line_start = line_end + 1;
 
-        while (std::getline(file, line))
+        const std::string_view keyword{ next_token(p, stop) };
+        if (keyword == "v")
         {
-            // Split the line into parts using space as a delimiter
-            std::vector<std::string> parts{ split(line, " ") };
+            // vertex line in obj: v 1.000000 1.000000 -1.000000
+            const double x{ parse_double(next_token(p, stop)) };
+            const double y{ parse_double(next_token(p, stop)) };
+            const double z{ parse_double(next_token(p, stop)) };
+            chunk.vertices.emplace_back(tuple_t::point(x, y, z));
+        }
+        else if (keyword == "vn")
+        {
+            // vertex normal line in obj vn -0.0000 1.0000 -0.0000
+            const double x{ parse_double(next_token(p, stop)) };
+            const double y{ parse_double(next_token(p, stop)) };
+            const double z{ parse_double(next_token(p, stop)) };
+            chunk.normals.emplace_back(tuple_t::vector(x, y, z));
+        }
+        else if (keyword == "vt")
+        {
+            // vertex uv line in obj vt 0.875000 0.500000
+            const double u{ parse_double(next_token(p, stop)) };
+            const double v{ parse_double(next_token(p, stop)) };
+            chunk.uvs.emplace_back(u, v);
+        }
+        else if (keyword == "f")
+        {
+            // 'f' denotes a face, parse the vertex/uv/normal indices
+            const std::array<std::string_view, 3> corners{ next_token(p, stop), next_token(p, stop), next_token(p, stop) };
+            std::array<std::array<std::string_view, 3>, 3> parts{};
+            for (int i{ 0 }; i < 3; i++)
+            {
+                parts[i] = split_face_corner(corners[i]);
+            }
 
-            if (parts.size()) {
-                // Process vertex coordinates
-                if (parts[0] == "v")
-                {
-					// vertex line in obj: v 1.000000 1.000000 -1.000000
-					//vertices.emplace_back(tuple_t::vector(std::stod(parts[1]), std::stod(parts[2]), std::stod(parts[3])));
-                    vertices.emplace_back(tuple_t::point(std::stod(parts[1]), std::stod(parts[2]), std::stod(parts[3])));
-					// create an empty array for each vertex to store it's normals so we can index it when we add the vtx normals
-                    vertex_normals.emplace_back(std::vector<tuple_t>{});
-                    added_normal_indices.push_back(std::vector<double>{});
-                }
+            face_t face{
+                parse_int(parts[0][0]), parse_int(parts[1][0]), parse_int(parts[2][0]),
+                std::nullopt, std::nullopt, std::nullopt,
+                std::nullopt, std::nullopt, std::nullopt
+            };
 
-                // Process vertex normals
-                if (parts[0] == "vn")
-                {
-					// vertex normal line in obj vn -0.0000 1.0000 - 0.0000
-                    obj_normals.emplace_back(tuple_t::vector(std::stod(parts[1]), std::stod(parts[2]), std::stod(parts[3])));
-                }
+            // If faces have UV indices, assign them
+            if (!parts[0][1].empty() && !parts[1][1].empty() && !parts[2][1].empty())
+            {
+                face.a_uv = parse_int(parts[0][1]);
+                face.b_uv = parse_int(parts[1][1]);
+                face.c_uv = parse_int(parts[2][1]);
+            }
 
-                // Process texture coordinates (UVs)
-                if (parts[0] == "vt")
-                {
-					// vertex uv line in obj vt 0.875000 0.500000
-                    uvs.emplace_back(std::stod(parts[1]), std::stod(parts[2]));
-                }
-                else if (parts[0] == "f")
+            // If faces have normal indices, assign them
+            if (!parts[0][2].empty() && !parts[1][2].empty() && !parts[2][2].empty())
+            {
+                face.a_normal = parse_int(parts[0][2]);
+                face.b_normal = parse_int(parts[1][2]);
+                face.c_normal = parse_int(parts[2][2]);
+            }
+
+            // Relative indices count back from the last element defined so far. Make them
+            // relative to the start of this chunk and remember them so the merge can offset them.
+            const std::array<int, 3> counts{
+                static_cast<int>(chunk.vertices.size()),
+                static_cast<int>(chunk.uvs.size()),
+                static_cast<int>(chunk.normals.size())
+            };
+            for (int slot{ 0 }; slot < 9; slot++)
+            {
+                if (slot >= 3 && !(slot < 6 ? face.has_uvs() : face.has_normals())) continue;
+                int& index{ face_slot(face, slot) };
+                if (index < 0)
                 {
-                    // 'f' denotes a face, parse the vertex/uv/normal indices
-                    std::vector<std::string> face_parts1{ split(parts[1], "/") };
-                    std::vector<std::string> face_parts2{ split(parts[2], "/") };
-                    std::vector<std::string> face_parts3{ split(parts[3], "/") };
-
-                    // Create a face object with vertex indices
-                    face_t face{
-                        std::stoi(face_parts1[0]),
-                        std::stoi(face_parts2[0]),
-                        std::stoi(face_parts3[0])
-                    };
-
-                    // If faces have UV indices, assign them
-                    if (face_parts1.size() > 1 && !face_parts1[1].empty() &&
-                        face_parts2.size() > 1 && !face_parts2[1].empty() &&
-                        face_parts3.size() > 1 && !face_parts3[1].empty())
-                    {
-                        face.a_uv = std::stoi(face_parts1[1]);
-                        face.b_uv = std::stoi(face_parts2[1]);
-                        face.c_uv = std::stoi(face_parts3[1]);
-                    }
-
-                    // If faces have normal indices, assign them
-                    if (face_parts1.size() > 1 && !face_parts1[2].empty() &&
-                        face_parts2.size() > 1 && !face_parts2[2].empty() &&
-                        face_parts3.size() > 1 && !face_parts3[2].empty())
-                    {
-                        face.a_normal = std::stoi(face_parts1[2]);
-                        face.b_normal = std::stoi(face_parts2[2]);
-                        face.c_normal = std::stoi(face_parts3[2]);
-                    }
-                    faces.push_back(face);
+                    index += counts[slot / 3] + 1;
+                    chunk.relative_indices.emplace_back(chunk.faces.size(), slot);
                 }
             }
+            chunk.faces.push_back(face);
         }
+    }
+}
+
+wavefront_t::wavefront_t(const char* obj_filename, unsigned thread_count)
+{
+    const std::filesystem::path obj_filepath{ std::filesystem::absolute(obj_filename) };
+
+    if (!std::filesystem::exists(obj_filepath))
+    {
+        throw std::invalid_argument("Obj file does not exist");
+    }
+
+    if (thread_count == 0)
+    {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
 
-        // Iterate through the faces to process normal data
-        std::size_t counter{ 0 };
-        for (const auto& face : faces)
+    // Map the file so the parsing threads read its pages directly, without copying it
+    // into process memory first
+    const MappedFile file{ obj_filepath.string().c_str() };
+    const char* text{ reinterpret_cast<const char*>(file.data()) };
+    const std::size_t file_size{ file.size() };
+
+    // Split the file into newline-aligned chunks, one per thread
+    const std::size_t chunk_count{ std::clamp<std::size_t>(file_size / MIN_OBJ_CHUNK_BYTES, 1, thread_count) };
+    std::vector<std::size_t> boundaries{ 0 };
+    for (std::size_t i{ 1 }; i < chunk_count; i++)
+    {
+        const std::size_t from{ std::max(i * file_size / chunk_count, boundaries.back()) };
+        const void* newline{ std::memchr(text + from, '\n', file_size - from) };
+        if (!newline) break;
+        boundaries.push_back(static_cast<std::size_t>(static_cast<const char*>(newline) - text) + 1);
+    }
+    boundaries.push_back(file_size);
+
+    std::vector<obj_chunk_t> chunks(boundaries.size() - 1);
+    parallel_ranges(chunks.size(), thread_count, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i{ begin }; i < end; i++)
         {
-            if (face.has_normals())
-            {
-                // Process vertex normals for each face
-                int vtx_a_index{ face.a - 1 };
-                int vtx_a_normal_index{ face.a_normal.value() - 1 };
+            parse_chunk(text + boundaries[i], text + boundaries[i + 1], chunks[i]);
+        }
+    });
 
-                // Add the normal to the vertex if it hasn't been added yet
-                if (std::find(added_normal_indices[vtx_a_index].begin(), added_normal_indices[vtx_a_index].end(), vtx_a_normal_index) == added_normal_indices[vtx_a_index].end())
-                {
-                    vertex_normals[vtx_a_index].push_back(obj_normals[vtx_a_normal_index]);
-                    added_normal_indices[vtx_a_index].push_back(vtx_a_normal_index);
-                }
+    // Merge the chunks in file order, offsetting any relative indices by the number of
+    // elements defined in the preceding chunks
+    std::size_t vertex_total{ 0 }, normal_total{ 0 }, uv_total{ 0 }, face_total{ 0 };
+    for (const auto& chunk : chunks)
+    {
+        vertex_total += chunk.vertices.size();
+        normal_total += chunk.normals.size();
+        uv_total += chunk.uvs.size();
+        face_total += chunk.faces.size();
+    }
+    std::vector<tuple_t> obj_normals{};
+    vertices.reserve(vertex_total);
+    obj_normals.reserve(normal_total);
+    uvs.reserve(uv_total);
+    faces.reserve(face_total);
+    for (auto& chunk : chunks)
+    {
+        const std::array<int, 3> offsets{
+            static_cast<int>(vertices.size()),
+            static_cast<int>(uvs.size()),
+            static_cast<int>(obj_normals.size())
+        };
+        for (const auto& [face_index, slot] : chunk.relative_indices)
+        {
+            face_slot(chunk.faces[face_index], slot) += offsets[slot / 3];
+        }
+        vertices.insert(vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+        obj_normals.insert(obj_normals.end(), chunk.normals.begin(), chunk.normals.end());
+        uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+        faces.insert(faces.end(), chunk.faces.begin(), chunk.faces.end());
+        chunk = {};
+    }
 
-                // Repeat for vertex B and C
-                int vtx_b_index{ face.b - 1 };
-                int vtx_b_normal_index{ face.b_normal.value() - 1 };
-                if (std::find(added_normal_indices[vtx_b_index].begin(), added_normal_indices[vtx_b_index].end(), vtx_b_normal_index) == added_normal_indices[vtx_b_index].end())
-                {
-                    vertex_normals[vtx_b_index].push_back(obj_normals[vtx_b_normal_index]);
-                    added_normal_indices[vtx_b_index].push_back(vtx_b_normal_index);
-                }
+    for (auto& face : faces)
+    {
+        for (int slot{ 0 }; slot < 9; slot++)
+        {
+            if (slot >= 3 && !(slot < 6 ? face.has_uvs() : face.has_normals())) continue;
+            const int index{ face_slot(face, slot) };
+            const std::size_t count{ slot < 3 ? vertices.size() : slot < 6 ? uvs.size() : obj_normals.size() };
+            if (index < 1 || static_cast<std::size_t>(index) > count)
+            {
+                throw std::invalid_argument("Obj face index out of range");
+            }
+        }
+    }
 
-                int vtx_c_index{ face.c - 1 };
-                int vtx_c_normal_index{ face.c_normal.value() - 1 };
-                if (std::find(added_normal_indices[vtx_c_index].begin(), added_normal_indices[vtx_c_index].end(), vtx_c_normal_index) == added_normal_indices[vtx_c_index].end())
-                {
-                    vertex_normals[vtx_c_index].push_back(obj_normals[vtx_c_normal_index]);
-                    added_normal_indices[vtx_c_index].push_back(vtx_c_normal_index);
-                }
+    // Group the face corners that have normals by vertex: count them and scatter them
+    // into per-vertex lists in parallel ranges of faces, so every face is visited once
+    // whatever the thread count.
+    std::vector<std::atomic<std::size_t>> corner_cursors(vertices.size());
+    parallel_ranges(faces.size(), thread_count, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t f{ begin }; f < end; f++)
+        {
+            if (!faces[f].has_normals()) continue;
+            corner_cursors[faces[f].a - 1].fetch_add(1, std::memory_order_relaxed);
+            corner_cursors[faces[f].b - 1].fetch_add(1, std::memory_order_relaxed);
+            corner_cursors[faces[f].c - 1].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    std::vector<std::size_t> first_corner(vertices.size() + 1, 0);
+    for (std::size_t v{ 0 }; v < vertices.size(); v++)
+    {
+        first_corner[v + 1] = first_corner[v] + corner_cursors[v].load(std::memory_order_relaxed);
+        corner_cursors[v].store(first_corner[v], std::memory_order_relaxed);
+    }
+    // corner 3 * f + k is corner k of face f
+    std::vector<std::size_t> vertex_corners(first_corner.back());
+    parallel_ranges(faces.size(), thread_count, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t f{ begin }; f < end; f++)
+        {
+            if (!faces[f].has_normals()) continue;
+            const std::array<int, 3> corner_vertices{ faces[f].a - 1, faces[f].b - 1, faces[f].c - 1 };
+            for (std::size_t k{ 0 }; k < 3; k++)
+            {
+                vertex_corners[corner_cursors[corner_vertices[k]].fetch_add(1, std::memory_order_relaxed)] = f * 3 + k;
             }
-            counter++;
         }
+    });
 
-        // Calculate the average normal for each vertex
-        for (const std::vector<tuple_t>& vtx_normals : vertex_normals)
+    // Collect the unique normals of every vertex and average them. Each vertex's corners
+    // are put back in face order first, so the result is the same as a serial pass
+    // regardless of the thread count.
+    vertex_normals.resize(vertices.size());
+    vertex_normals_avg.resize(vertices.size());
+    parallel_ranges(vertices.size(), thread_count, [&](std::size_t begin, std::size_t end) {
+        // Normal indices already added to the current vertex
+        std::vector<int> added{};
+        for (std::size_t i{ begin }; i < end; i++)
         {
+            const auto corners_begin{ vertex_corners.begin() + first_corner[i] };
+            const auto corners_end{ vertex_corners.begin() + first_corner[i + 1] };
+            std::sort(corners_begin, corners_end);
+            added.clear();
+            for (auto corner{ corners_begin }; corner != corners_end; ++corner)
+            {
+                const face_t& face{ faces[*corner / 3] };
+                const std::optional<int>& normal_index{ *corner % 3 == 0 ? face.a_normal : *corner % 3 == 1 ? face.b_normal : face.c_normal };
+                // Add the normal to the vertex if it hasn't been added yet
+                if (std::find(added.begin(), added.end(), normal_index.value() - 1) == added.end())
+                {
+                    vertex_normals[i].push_back(obj_normals[normal_index.value() - 1]);
+                    added.push_back(normal_index.value() - 1);
+                }
+            }
+
             tuple_t normal_avg{ tuple_t::vector(0.0, 0.0, 0.0) };
 
             // If there are normals for this vertex, compute the average
-            if (!vtx_normals.empty())
+            if (!vertex_normals[i].empty())
             {
-                for (const auto& normal : vtx_normals)
+                for (const auto& normal : vertex_normals[i])
                 {
                     normal_avg += normal;
                 }
-                normal_avg /= vtx_normals.size();
+                normal_avg /= vertex_normals[i].size();
                 normal_avg.normalize();
             }
 
-            vertex_normals_avg.push_back(normal_avg);
+            vertex_normals_avg[i] = normal_avg;
         }
-    }
-}
\ No newline at end of file
+    });
+}
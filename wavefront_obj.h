@@ -90,10 +90,14 @@ struct wavefront_t
      * @brief Constructs and loads a Wavefront `.obj` file into memory.
      *
      * Parses the specified file and populates the vertex, normal, UV, and face data.
+     * The file is memory mapped and split into newline-aligned chunks of at least 1 MiB
+     * which are parsed in parallel. The per-chunk results are then merged in file order, with
+     * relative (negative) indices resolved against the global vertex/uv/normal counts.
      *
      * @param obj_filename Path to the `.obj` file to be loaded.
+     * @param thread_count Maximum number of threads used for parsing (0 uses the hardware concurrency).
      * @throws std::runtime_error If the file is not found or contains invalid syntax.
      */
-    wavefront_t(const char* obj_filename);
+    wavefront_t(const char* obj_filename, unsigned thread_count = 0);
 };
 
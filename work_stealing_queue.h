@@ -0,0 +1,89 @@
+#pragma once
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief A per-worker task deque that other workers can steal from.
+ *
+ * The owning worker pushes and pops at the front, so it keeps working on the
+ * tasks it created most recently (which are likely to still be in cache), while
+ * thieves take the oldest tasks from the back. Each worker has its own queue,
+ * so workers only contend on a lock when one of them steals.
+ *
+ * @tparam T The type of elements stored in the queue (must be movable).
+ */
+template<typename T>
+class WorkStealingQueue
+{
+public:
+    /**
+     * @brief Constructs an empty queue.
+     */
+    WorkStealingQueue() {};
+
+    WorkStealingQueue(const WorkStealingQueue&) = delete;
+    WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+    /**
+     * @brief Pushes a task onto the owner's end of the queue.
+     *
+     * @param data The task to be added. It will be moved into the queue.
+     */
+    void push(T data)
+    {
+        std::lock_guard<std::mutex> lk{ mut };
+        the_queue.push_front(std::move(data));
+    }
+
+    /**
+     * @brief Pops the most recently pushed task (for the owning worker).
+     *
+     * @param res Reference to store the task if available.
+     * @return true if a task was popped, false if the queue was empty.
+     */
+    bool try_pop(T& res)
+    {
+        std::lock_guard<std::mutex> lk{ mut };
+        if (the_queue.empty()) return false;
+        res = std::move(the_queue.front());
+        the_queue.pop_front();
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest task (for other workers).
+     *
+     * @param res Reference to store the task if available.
+     * @return true if a task was stolen, false if the queue was empty.
+     */
+    bool try_steal(T& res)
+    {
+        std::lock_guard<std::mutex> lk{ mut };
+        if (the_queue.empty()) return false;
+        res = std::move(the_queue.back());
+        the_queue.pop_back();
+        return true;
+    }
+
+    /**
+     * @brief Checks whether the queue is empty.
+     *
+     * @return true if the queue is empty, false otherwise.
+     */
+    bool empty() const
+    {
+        std::lock_guard<std::mutex> lk{ mut };
+        return the_queue.empty();
+    }
+
+private:
+    /**
+     * @brief Mutex to protect access to the internal deque.
+     */
+    mutable std::mutex mut;
+
+    /**
+     * @brief The underlying deque used for storage.
+     */
+    std::deque<T> the_queue;
+};
@@ -1,5 +1,7 @@
 #include <memory>
 #include <cmath>
+#include <stdexcept>
+#include <utility>
 #include "world.h"
 #include "point_light.h"
 #include "geometry.h"
@@ -8,6 +10,11 @@
 #include "matrix.h"
 #include "group.h"
 
+/**
+ * @brief Mask the calling thread records touched objects into, if any.
+ */
+static thread_local object_mask_t* touched_objects{ nullptr };
+
 World World::default_world()
 {
 	World w{};
@@ -40,12 +47,15 @@ void World::add_object(std::shared_ptr<SceneObject> obj)
 		lights.push_back(light);
 	}
 	scene_objects.push_back(obj);
+	full_render_needed = true;
 }
 
 void World::intersect(const ray_t& ray, intersections_t& intersections) const
 {
-	for (auto& object : scene_objects)
+	for (std::size_t id{ 0 }; id < scene_objects.size(); id++)
 	{
+		const auto& object{ scene_objects[id] };
+		const std::size_t before{ intersections.entries.size() };
 		auto group = dynamic_cast<Group*>(object.get());
 		if (group)
 		{
@@ -59,6 +69,10 @@ void World::intersect(const ray_t& ray, intersections_t& intersections) const
 				geo->intersect(ray, intersections);
 			}
 		}
+		if (touched_objects && intersections.entries.size() > before)
+		{
+			touched_objects->set(id);
+		}
 	}
 }
 
@@ -70,7 +84,7 @@ colour_t World::shade_hit(const intersection_state& state, int remaining) const
 		if (auto light = weak_light.lock())
 		{
 			const double intensity{ light->intensity_at(state.over_point, *this) };
-			colour += state.object->material->lighting(*light, state.object, state.point, state.eye_vector, state.normal, intensity);
+			colour += state.object->material->lighting(*light, state.object, state.point, state.eye_vector, state.normal, intensity, state.differentials);
 			colour_t reflected_c{ reflected_colour(state, remaining) };
 			colour_t refracted_c{ refracted_colour(state, remaining) };
 			auto phong{ std::dynamic_pointer_cast<Phong>(state.object->material) };
@@ -106,7 +120,8 @@ colour_t World::reflected_colour(const intersection_state& state, int remaining)
 	if (phong && phong->reflective > 0)
 	{
 		// Construct a reflection ray starting just above the surface to avoid self-intersection
-		const ray_t reflected_ray{ state.over_point, state.reflect_vector };
+		ray_t reflected_ray{ state.over_point, state.reflect_vector };
+		reflected_ray.differentials = state.reflected_differentials();
 
 		// Recursively compute the color returned by the reflected ray
 		colour = colour_at(reflected_ray, remaining - 1);
@@ -159,7 +174,8 @@ colour_t World::refracted_colour(const intersection_state& state, int remaining)
 		const tuple_t direction = state.normal * (n_ratio * cos_i - cos_t) - state.eye_vector * n_ratio;
 
 		// Create the refracted ray starting just below the surface to avoid artifacts
-		const ray_t refract_ray{ state.under_point, direction };
+		ray_t refract_ray{ state.under_point, direction };
+		refract_ray.differentials = state.refracted_differentials(n_ratio);
 
 		// Recursively compute the refracted color, scaled by the material's transparency
 		colour = colour_at(refract_ray, remaining - 1) * phong->transparency;
@@ -202,4 +218,43 @@ bool World::is_shadowed(const tuple_t& point, const tuple_t& light_position) con
 		}
 	) };
 	return intersection && intersection->time < distance;
+}
+
+void World::mark_changed(const std::shared_ptr<SceneObject>& object, const Change_Kind kind)
+{
+	const auto found{ std::find(scene_objects.begin(), scene_objects.end(), object) };
+	if (found == scene_objects.end())
+	{
+		throw std::invalid_argument("Object is not part of the world");
+	}
+	// a light's material is how it lights every object, so any edit to it is global
+	if (kind == Change_Kind::geometry || std::dynamic_pointer_cast<Light>(object))
+	{
+		full_render_needed = true;
+	}
+	else
+	{
+		material_changes.set(static_cast<std::size_t>(found - scene_objects.begin()));
+	}
+}
+
+const object_mask_t& World::changed_objects() const
+{
+	return material_changes;
+}
+
+bool World::needs_full_render() const
+{
+	return full_render_needed;
+}
+
+void World::clear_changes()
+{
+	material_changes = {};
+	full_render_needed = false;
+}
+
+object_mask_t* World::record_touched(object_mask_t* mask)
+{
+	return std::exchange(touched_objects, mask);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <cstdint>
 #include "colour.h"
 #include "scene_object.h"
 #include "geometry.h"
@@ -9,6 +11,84 @@
 #include "intersection.h"
 #include "intersection_state.h"
 
+/**
+ * @struct object_mask_t
+ * @brief A compact set of object ids (indices into `World::scene_objects`), one bit per object.
+ */
+struct object_mask_t
+{
+	/** @brief The bits, 64 objects per word. */
+	std::vector<std::uint64_t> words;
+
+	/**
+	 * @brief Adds an object to the set.
+	 * @param id The object id.
+	 */
+	void set(const std::size_t id)
+	{
+		if (id / 64 >= words.size()) words.resize(id / 64 + 1, 0);
+		words[id / 64] |= std::uint64_t{ 1 } << (id % 64);
+	}
+
+	/**
+	 * @brief Returns whether an object is in the set.
+	 * @param id The object id.
+	 */
+	bool test(const std::size_t id) const
+	{
+		return id / 64 < words.size() && (words[id / 64] >> (id % 64)) & 1;
+	}
+
+	/**
+	 * @brief Returns whether the two sets have an object in common.
+	 * @param other The other set.
+	 */
+	bool intersects(const object_mask_t& other) const
+	{
+		const std::size_t count{ std::min(words.size(), other.words.size()) };
+		for (std::size_t i{ 0 }; i < count; i++)
+		{
+			if (words[i] & other.words[i]) return true;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Adds every object of another set.
+	 * @param other The other set.
+	 */
+	void merge(const object_mask_t& other)
+	{
+		if (other.words.size() > words.size()) words.resize(other.words.size(), 0);
+		for (std::size_t i{ 0 }; i < other.words.size(); i++)
+		{
+			words[i] |= other.words[i];
+		}
+	}
+
+	/**
+	 * @brief Returns whether the set is empty.
+	 */
+	bool empty() const
+	{
+		for (const std::uint64_t word : words)
+		{
+			if (word) return false;
+		}
+		return true;
+	}
+};
+
+/**
+ * @enum Change_Kind
+ * @brief What was edited on an object reported through `World::mark_changed`.
+ */
+enum class Change_Kind
+{
+	material,   ///< Only how the object is shaded changed, rays hit it exactly where they did before
+	geometry    ///< Its transform or shape changed (or it is a light), it may now affect any pixel
+};
+
 /**
  * @class World
  * @brief Represents a 3D scene containing objects, lights, and the logic to render them.
@@ -16,6 +96,11 @@
  * The World class manages all scene objects and lighting elements. It provides
  * methods for ray-object intersection, shading, and determining visible colors
  * based on lighting and material interactions.
+ *
+ * Edits made to the objects after a render are reported through `mark_changed`, so
+ * a `RenderManager` can re-render only the tiles whose rays touched the edited objects.
+ * While a thread has a touch mask set with `record_touched`, every top level object
+ * a ray traced by that thread intersects is added to the mask.
  */
 class World
 {
@@ -129,6 +214,44 @@ public:
 	 */
 	bool is_shadowed(const tuple_t& point, const tuple_t& light_position) const;
 
+	/**
+	 * @brief Reports an edit made to one of the world's objects since the last render.
+	 *
+	 * @param object The edited object.
+	 * @param kind Whether only its material or also its geometry changed.
+	 * @throws std::invalid_argument if the object is not a top level object of the world.
+	 */
+	void mark_changed(const std::shared_ptr<SceneObject>& object, const Change_Kind kind = Change_Kind::material);
+
+	/**
+	 * @brief Returns the objects whose material changed since the last `clear_changes`.
+	 */
+	const object_mask_t& changed_objects() const;
+
+	/**
+	 * @brief Returns whether an edit since the last `clear_changes` may affect any pixel.
+	 *
+	 * True for a new world, after `add_object` and after a geometry change.
+	 */
+	bool needs_full_render() const;
+
+	/**
+	 * @brief Forgets the reported edits, called once they have been rendered.
+	 */
+	void clear_changes();
+
+	/**
+	 * @brief Sets the mask the calling thread records touched objects into.
+	 *
+	 * @param mask The mask, or null to stop recording.
+	 * @return The mask the thread recorded into before, to be restored afterwards.
+	 */
+	static object_mask_t* record_touched(object_mask_t* mask);
+
+private:
+	object_mask_t material_changes;     ///< Objects whose material changed.
+	bool full_render_needed{ true };    ///< Whether an edit may affect any pixel.
+
 };
 
 